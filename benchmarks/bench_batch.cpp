@@ -0,0 +1,56 @@
+#include <cstdint>
+
+// lfc
+#include "lfc/runtime/gains.hpp"
+
+// Eigen
+#include "Eigen/Core"
+
+// benchmark
+#include "benchmark/benchmark.h"
+
+namespace lfc {
+namespace {
+
+/// Y = offset + gains * X of STREAMS (range(0)) states, with ROWS x COLS
+/// (range(1) x range(2)) gains, solved one after the other, or all at once
+template <bool kBatch>
+void BM_SolveStreams(benchmark::State &state) {
+  const Eigen::Index streams = state.range(0);
+  const Eigen::Index rows = state.range(1);
+  const Eigen::Index cols = state.range(2);
+
+  const auto gains = Gains{gains_t::Random(rows, cols), GainsKernel::kColMajor};
+  const offset_t offset = offset_t::Random(rows);
+  const Eigen::MatrixXd x = Eigen::MatrixXd::Random(cols, streams);
+  Eigen::MatrixXd y = Eigen::MatrixXd::Zero(rows, streams);
+
+  for (auto _ : state) {
+    if constexpr (kBatch) {
+      gains.SolveBatchInto(offset, x, y);
+    } else {
+      for (Eigen::Index k = 0; k < streams; ++k) {
+        auto y_k = y.col(k);
+        gains.SolveInto(offset, x.col(k), y_k);
+      }
+    }
+    benchmark::DoNotOptimize(y.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * streams);
+}
+
+/// A dozen robots ([q, v] -> tau), and bigger (whole body) models
+void Streams(benchmark::internal::Benchmark *bench) {
+  for (auto [rows, cols] : {std::pair{12, 24}, std::pair{64, 128}}) {
+    for (auto streams : {1, 4, 12}) bench->Args({streams, rows, cols});
+  }
+  bench->ArgNames({"streams", "rows", "cols"});
+}
+
+BENCHMARK_TEMPLATE(BM_SolveStreams, false)->Apply(Streams);
+BENCHMARK_TEMPLATE(BM_SolveStreams, true)->Apply(Streams);
+
+} // namespace
+} // namespace lfc
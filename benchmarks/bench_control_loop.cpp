@@ -0,0 +1,150 @@
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// lfc
+#include "lfc/lockfree/histogram.hpp"
+#include "lfc/ros/linear_feedback_node.hpp"
+
+// ROS
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp/wait_set.hpp"
+#include "sensor_msgs/msg/joint_state.hpp"
+
+// benchmark
+#include "benchmark/benchmark.h"
+
+namespace lfc::ros {
+namespace {
+
+using namespace std::chrono_literals;
+
+using joint_state_t = sensor_msgs::msg::JointState;
+
+constexpr std::size_t kJoints = 6;
+
+/**
+ *  \brief Latency of a control step of the node (JointState published ->
+ *         command received), driven by its executor or by its wait set loop
+ *
+ *  The node is spun as by the lfc executable (without real-time settings).
+ *  The driver, on the benchmark thread, publishes each JointState then takes
+ *  its command (matched through its stamp) from a wait set, the same way for
+ *  every control loop: the differences come from the node side only.
+ */
+template <ControlLoop kLoop, bool kBusyPoll>
+void BM_ControlLoop(benchmark::State &state) {
+  rclcpp::init(0, nullptr);
+
+  // NODE: a [kJoints x 2 * kJoints] model (positions and velocities)
+  auto options = rclcpp::NodeOptions{};
+  options
+      .append_parameter_override("gains/shape/rows",
+                                 static_cast<std::int64_t>(kJoints))
+      .append_parameter_override("gains/shape/cols",
+                                 static_cast<std::int64_t>(2 * kJoints))
+      .append_parameter_override("gains/values",
+                                 std::vector<double>(2 * kJoints * kJoints,
+                                                     0.5))
+      .append_parameter_override("control/loop",
+                                 std::string{ToString(kLoop)})
+      .append_parameter_override("control/busy_poll", kBusyPoll);
+  auto node = std::make_shared<LinearFeedbackNode>(options);
+
+  // Spun as by the lfc executable: the executor also spins the control
+  // callback group, unless driven by the wait set loop
+  auto executor = rclcpp::executors::SingleThreadedExecutor{};
+  executor.add_node(node);
+  auto spinner = std::thread([&]() { executor.spin(); });
+  auto control = std::thread([&]() {
+    if (kLoop == ControlLoop::kWaitSet) node->SpinWaitSet();
+  });
+
+  // DRIVER
+  auto driver = std::make_shared<rclcpp::Node>("bench_control_loop_driver");
+  auto publisher = driver->create_publisher<joint_state_t>(
+      "joint_state", rclcpp::QoS{/* depth = */ 5});
+  auto subscription = driver->create_subscription<joint_state_t>(
+      "command", rclcpp::QoS{/* depth = */ 5},
+      [](joint_state_t::ConstSharedPtr /* msg */) {});
+  auto wait_set = rclcpp::WaitSet{};
+  wait_set.add_subscription(subscription);
+
+  auto msg = joint_state_t{};
+  msg.position.assign(kJoints, 0.1);
+  msg.velocity.assign(kJoints, 0.2);
+  auto command = joint_state_t{};
+  auto info = rclcpp::MessageInfo{};
+
+  // Takes the command of msg, dropping the older ones (e.g. timed out)
+  const auto take_command = [&]() {
+    while (wait_set.wait(1s).kind() == rclcpp::WaitResultKind::Ready) {
+      while (subscription->take(command, info)) {
+        if (command.header.stamp == msg.header.stamp) return true;
+      }
+    }
+    return false;
+  };
+
+  // Discovery
+  const auto deadline = std::chrono::steady_clock::now() + 10s;
+  while ((publisher->get_subscription_count() == 0) ||
+         (subscription->get_publisher_count() == 0)) {
+    if (std::chrono::steady_clock::now() > deadline) break;
+    std::this_thread::sleep_for(10ms);
+  }
+
+  auto sequence = std::uint32_t{0};
+  auto histogram = lockfree::Histogram<>{};
+  for (auto _ : state) {
+    msg.header.stamp.nanosec = ++sequence;
+
+    const auto start = std::chrono::steady_clock::now();
+    publisher->publish(msg);
+    if (!take_command()) {
+      state.SkipWithError("No command received within 1s");
+      break;
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    histogram.Record(static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+            .count()));
+  }
+
+  if (!state.error_occurred()) {
+    state.counters["p50_us"] =
+        static_cast<double>(histogram.ValueAtPercentile(50.)) * 1e-3;
+    state.counters["p99_us"] =
+        static_cast<double>(histogram.ValueAtPercentile(99.)) * 1e-3;
+    state.counters["p99.9_us"] =
+        static_cast<double>(histogram.ValueAtPercentile(99.9)) * 1e-3;
+    state.counters["max_us"] =
+        static_cast<double>(histogram.Max()) * 1e-3;
+  }
+
+  // The wait set loop stops with rclcpp::ok()
+  rclcpp::shutdown();
+  executor.cancel();
+  spinner.join();
+  control.join();
+}
+
+BENCHMARK_TEMPLATE(BM_ControlLoop, ControlLoop::kExecutor, false)
+    ->Iterations(10000)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ControlLoop, ControlLoop::kWaitSet, false)
+    ->Iterations(10000)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ControlLoop, ControlLoop::kWaitSet, true)
+    ->Iterations(10000)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+} // namespace
+} // namespace lfc::ros
@@ -0,0 +1,54 @@
+#include <cstdint>
+#include <string>
+
+// lfc
+#include "lfc/flight_recorder.hpp"
+
+// Eigen
+#include "Eigen/Core"
+
+// benchmark
+#include "benchmark/benchmark.h"
+
+namespace lfc {
+namespace {
+
+/**
+ *  \brief A record of the control path (X of state.range(0) values, Y of
+ *         state.range(1) values) into a flight recorder of 10000 records
+ *
+ *  Expected well under 100ns per record (i.e. per control step).
+ */
+void BM_FlightRecord(benchmark::State &state) {
+  const auto x_size = static_cast<std::size_t>(state.range(0));
+  const auto y_size = static_cast<std::size_t>(state.range(1));
+  const Eigen::VectorXd x = Eigen::VectorXd::Random(state.range(0));
+  const Eigen::VectorXd y = Eigen::VectorXd::Random(state.range(1));
+
+  auto reason = std::string{};
+  auto recorder = FlightRecorder::Create(x_size, y_size, 10000, reason);
+  if (!recorder.has_value()) {
+    state.SkipWithError(reason.c_str());
+    return;
+  }
+
+  std::int64_t time = 0;
+  for (auto _ : state) {
+    recorder->Record(1, time, time, x.data(), y.data());
+    benchmark::ClobberMemory();
+    ++time;
+  }
+
+  state.SetBytesProcessed(
+      state.iterations() *
+      static_cast<std::int64_t>((x_size + y_size) * sizeof(double)));
+}
+
+BENCHMARK(BM_FlightRecord)
+    ->Args({12, 6})
+    ->Args({14, 7})
+    ->Args({24, 12})
+    ->Args({64, 32});
+
+} // namespace
+} // namespace lfc
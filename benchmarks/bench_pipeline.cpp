@@ -0,0 +1,137 @@
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// lfc
+#include "lfc/lockfree/spsc_ring.hpp"
+#include "lfc/runtime/gains.hpp"
+
+// Eigen
+#include "Eigen/Core"
+
+// benchmark
+#include "benchmark/benchmark.h"
+
+namespace lfc {
+namespace {
+
+/// State gathered by the taking thread, solved by the solver (as the
+/// StampedState of the pipelined node)
+struct Gathered {
+  std::uint64_t sequence = 0;
+  Eigen::VectorXd x = Eigen::VectorXd{};
+};
+
+/// Model of ROWS x COLS (range(0) x range(1)) gains, and a "message" whose
+/// position and velocity (COLS / 2 values each) are gathered into X
+struct Fixture {
+  explicit Fixture(const benchmark::State &state)
+      : gains(gains_t::Random(state.range(0), state.range(1)),
+              GainsKernel::kColMajor),
+        offset(offset_t::Random(state.range(0))),
+        message(static_cast<std::size_t>(state.range(1)) * sizeof(double)),
+        y(Eigen::VectorXd::Zero(state.range(0))) {}
+
+  /// Gather the message into \a x (a memcpy per field, as the serialized
+  /// JointState)
+  auto GatherInto(Eigen::VectorXd &x) const noexcept -> void {
+    const auto half = static_cast<std::size_t>(x.size() / 2);
+    std::memcpy(x.data(), message.data(), half * sizeof(double));
+    std::memcpy(x.data() + half, message.data() + (half * sizeof(double)),
+                (static_cast<std::size_t>(x.size()) - half) * sizeof(double));
+  }
+
+  Gains gains;
+  offset_t offset;
+  std::vector<std::uint8_t> message;
+  Eigen::VectorXd y;
+};
+
+/// Gather then solve each state on the same thread (the default node)
+void BM_GatherSolve(benchmark::State &state) {
+  auto fixture = Fixture{state};
+  auto x = Eigen::VectorXd{Eigen::VectorXd::Zero(state.range(1))};
+
+  for (auto _ : state) {
+    fixture.GatherInto(x);
+    fixture.gains.SolveInto(fixture.offset, x, fixture.y);
+    benchmark::DoNotOptimize(fixture.y.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ *  \brief Gather each state on this thread, solved by a second one, through
+ *         an SPSC ring (the pipelined node)
+ *
+ *  With kWait, each state is waited for until solved: the time per iteration
+ *  is the latency of a state. Otherwise, the gathering thread only waits for
+ *  a free slot: the items per second are the throughput of the pipeline.
+ */
+template <bool kWait>
+void BM_Pipelined(benchmark::State &state) {
+  auto fixture = Fixture{state};
+  auto ring = lockfree::SpscRing<Gathered, 8>{};
+  ring.ForEachSlot(
+      [&](Gathered &slot) { slot.x.setZero(state.range(1)); });
+
+  std::atomic<std::uint64_t> solved = 0;
+  std::atomic<bool> running = true;
+  auto solver = std::thread([&]() {
+    while (running.load(std::memory_order_relaxed)) {
+      auto *gathered = ring.TryPeek();
+      if (gathered == nullptr) {
+        std::this_thread::yield();
+        continue;
+      }
+
+      fixture.gains.SolveInto(fixture.offset, gathered->x, fixture.y);
+      benchmark::DoNotOptimize(fixture.y.data());
+      solved.store(gathered->sequence, std::memory_order_release);
+      ring.Release();
+    }
+  });
+
+  std::uint64_t sequence = 0;
+  for (auto _ : state) {
+    Gathered *slot = nullptr;
+    while ((slot = ring.TryClaim()) == nullptr) std::this_thread::yield();
+    fixture.GatherInto(slot->x);
+    slot->sequence = ++sequence;
+    ring.Commit();
+
+    if constexpr (kWait) {
+      while (solved.load(std::memory_order_acquire) != sequence) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  // Whole pipeline drained, such that the throughput counts solved states
+  while (solved.load(std::memory_order_acquire) != sequence) {
+    std::this_thread::yield();
+  }
+  running.store(false, std::memory_order_relaxed);
+  solver.join();
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+/// A [q, v] -> tau robot, and a bigger (whole body) model
+void Models(benchmark::internal::Benchmark *bench) {
+  for (auto [rows, cols] : {std::pair{12, 24}, std::pair{64, 128}}) {
+    bench->Args({rows, cols});
+  }
+  bench->ArgNames({"rows", "cols"});
+}
+
+BENCHMARK(BM_GatherSolve)->Apply(Models);
+BENCHMARK_TEMPLATE(BM_Pipelined, true)->Apply(Models)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Pipelined, false)->Apply(Models)->UseRealTime();
+
+} // namespace
+} // namespace lfc
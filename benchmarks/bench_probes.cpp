@@ -0,0 +1,58 @@
+#include <cstdint>
+
+// lfc
+#include "lfc/linear_model.hpp"
+#include "lfc/probes.h"
+
+// Eigen
+#include "Eigen/Core"
+
+// benchmark
+#include "benchmark/benchmark.h"
+
+namespace lfc {
+namespace {
+
+/**
+ *  \brief A 6x12 solve, as done by the control path, with (\a Probed) or
+ *         without the probes surrounding it
+ *
+ *  Probes are expected to be detached while benchmarking: both variants
+ *  should be within noise of each other.
+ */
+template <bool Probed>
+void BM_ProbedSolve(benchmark::State &state) {
+  const Eigen::MatrixXd gains = Eigen::MatrixXd::Random(6, 12);
+  const Eigen::VectorXd offset = Eigen::VectorXd::Random(6);
+  const Eigen::VectorXd x = Eigen::VectorXd::Random(12);
+  Eigen::VectorXd y = Eigen::VectorXd::Zero(6);
+  std::uint64_t version = 0;
+
+  for (auto _ : state) {
+    if constexpr (Probed) {
+      LFC_PROBE(receive, &x);
+      LFC_PROBE(gather, &x);
+      LFC_PROBE(solve_start, &x, version);
+    }
+
+    SolveInto(TieAsLinearModel(gains, offset), x, y);
+
+    if constexpr (Probed) {
+      LFC_PROBE(solve_end, &x, version);
+      LFC_PROBE(publish, &x, version, version);
+    }
+
+    benchmark::DoNotOptimize(y.data());
+    benchmark::DoNotOptimize(version);
+    benchmark::ClobberMemory();
+    ++version;
+  }
+
+  state.SetLabel(LFC_HAS_PROBES ? "usdt" : "no-op (no <sys/sdt.h>)");
+}
+
+BENCHMARK_TEMPLATE(BM_ProbedSolve, false);
+BENCHMARK_TEMPLATE(BM_ProbedSolve, true);
+
+} // namespace
+} // namespace lfc
@@ -0,0 +1,54 @@
+#include <cstdint>
+
+// lfc
+#include "lfc/linear_model.hpp"
+
+// Eigen
+#include "Eigen/Core"
+
+// benchmark
+#include "benchmark/benchmark.h"
+
+namespace lfc {
+namespace {
+
+using col_major_t = Eigen::MatrixXd;
+using row_major_t =
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+/// Y = offset + gains * X, with ROWS x COLS (range(0) x range(1)) gains
+template <class Gains>
+void BM_SolveInto(benchmark::State &state) {
+  const Eigen::Index rows = state.range(0);
+  const Eigen::Index cols = state.range(1);
+
+  const Gains gains = Gains::Random(rows, cols);
+  const Eigen::VectorXd offset = Eigen::VectorXd::Random(rows);
+  const Eigen::VectorXd x = Eigen::VectorXd::Random(cols);
+  Eigen::VectorXd y = Eigen::VectorXd::Zero(rows);
+
+  for (auto _ : state) {
+    SolveInto(TieAsLinearModel(gains, offset), x, y);
+    benchmark::DoNotOptimize(y.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * rows * cols);
+}
+
+/// Square, tall (ROWS >> COLS) and wide (ROWS << COLS) gains
+void Shapes(benchmark::internal::Benchmark *bench) {
+  for (auto [rows, cols] : {std::pair{6, 12}, std::pair{12, 12},
+                            std::pair{32, 32}, std::pair{256, 256},
+                            std::pair{1000, 1000}, std::pair{1024, 16},
+                            std::pair{16, 1024}, std::pair{64, 4096}}) {
+    bench->Args({rows, cols});
+  }
+  bench->ArgNames({"rows", "cols"});
+}
+
+BENCHMARK_TEMPLATE(BM_SolveInto, col_major_t)->Apply(Shapes);
+BENCHMARK_TEMPLATE(BM_SolveInto, row_major_t)->Apply(Shapes);
+
+} // namespace
+} // namespace lfc
@@ -0,0 +1,92 @@
+#pragma once
+
+// SYSTEM
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lfc {
+
+/**
+ *  \brief Publish-on-change filter of fixed size commands
+ *
+ *  A command is only published when any of its values differs from the last
+ *  command published by more than an epsilon, or when the last command
+ *  published is older than a keep alive period (such that subscribers can
+ *  tell a steady command from a dead publisher). The first command is always
+ *  published, NaN values always count as a change.
+ *
+ *  ShouldPublish() never allocates, and is expected to be called by a single
+ *  thread. Suppressed() can be read from any thread.
+ */
+class ChangeFilter {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  /**
+   *  \brief Filter commands of \a size values, changing when any value moves
+   *         by more than \a epsilon, republished at least every
+   *         \a keep_alive (never when zero)
+   *
+   *  \warning Allocates
+   */
+  ChangeFilter(std::size_t size, double epsilon, clock::duration keep_alive)
+      : m_epsilon(epsilon),
+        m_keep_alive(keep_alive),
+        m_published(size, 0.) {}
+
+  /// \return The number of values of the commands
+  auto Size() const noexcept -> std::size_t { return m_published.size(); }
+
+  /**
+   *  \brief Tell if the Size() \a values of the command computed at \a now
+   *         should be published, latching them as the last command published
+   *         when they should
+   *
+   *  \return False when the command is suppressed (see Suppressed())
+   */
+  auto ShouldPublish(const double *values, clock::time_point now) noexcept
+      -> bool {
+    const auto alive = (m_keep_alive == clock::duration::zero()) ||
+                       ((now - m_last_published) < m_keep_alive);
+    if (m_has_published && alive && !Changed(values)) {
+      m_suppressed.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    std::copy(values, values + m_published.size(), m_published.begin());
+    m_last_published = now;
+    m_has_published = true;
+    return true;
+  }
+
+  /// \return The number of commands suppressed so far (unchanged)
+  auto Suppressed() const noexcept -> std::uint64_t {
+    return m_suppressed.load(std::memory_order_relaxed);
+  }
+
+ private:
+  /// \return True when any of \a values moved by more than the epsilon
+  auto Changed(const double *values) const noexcept -> bool {
+    for (std::size_t i = 0; i < m_published.size(); ++i) {
+      // Negated, such that NaN is a change
+      if (!(std::abs(values[i] - m_published[i]) <= m_epsilon)) return true;
+    }
+    return false;
+  }
+
+  double m_epsilon;
+  clock::duration m_keep_alive;
+
+  std::vector<double> m_published; /*!< Last command published */
+  clock::time_point m_last_published = {};
+  bool m_has_published = false;
+
+  std::atomic<std::uint64_t> m_suppressed = 0;
+};
+
+} // namespace lfc
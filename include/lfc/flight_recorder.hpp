@@ -0,0 +1,414 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace lfc {
+
+/// Header of a flight recorder dump (see FlightRecorder::DumpTo())
+struct FlightDumpHeader {
+  static constexpr std::array<char, 8> kMagic = {'L', 'F', 'C', 'F',
+                                                 'L', 'I', 'G', 'H'};
+  static constexpr std::uint32_t kVersion = 1;
+
+  std::array<char, 8> magic = kMagic;
+  std::uint32_t version = kVersion;
+  std::uint32_t record_size = 0; /*!< Bytes per record */
+  std::uint64_t x_size = 0;
+  std::uint64_t y_size = 0;
+  std::uint64_t count = 0;    /*!< Records following the header */
+  std::uint64_t recorded = 0; /*!< Records recorded since the start */
+};
+
+/// A record of the flight recorder, decoded (see LoadFlightDump())
+struct FlightRecord {
+  std::uint64_t sequence = 0; /*!< 1 for the first record */
+  std::uint64_t model_version = 0;
+  std::int64_t time_ns = 0;  /*!< Steady clock time of the record */
+  std::int64_t stamp_ns = 0; /*!< Stamp of the state X */
+  std::vector<double> x = {};
+  std::vector<double> y = {};
+};
+
+/**
+ *  \brief Ring of the last fixed-size binary records of the control path:
+ *         {sequence, model version, time, stamp, X, Y}
+ *
+ *  The ring is preallocated (anonymous mmap, populated) and Record() only
+ *  copies the values into it (memcpy): no allocation, no syscall.
+ *
+ *  The ring is dumped on demand, or on a fault signal (see DumpOnFault()),
+ *  through DumpTo(), which is async-signal-safe. A record being overwritten
+ *  while dumped is detected (its sequence surrounds its values) and dropped
+ *  by LoadFlightDump().
+ */
+class FlightRecorder {
+ public:
+  /**
+   *  \brief Preallocate a ring of \a capacity records of \a x_size X and
+   *         \a y_size Y values
+   *
+   *  \param[out] reason Reason of the failure, if any
+   *
+   *  \return The recorder, std::nullopt on failure
+   */
+  static auto Create(std::size_t x_size, std::size_t y_size,
+                     std::size_t capacity, std::string &reason)
+      -> std::optional<FlightRecorder> {
+    if (capacity == 0) {
+      reason = "the capacity must be > 0";
+      return std::nullopt;
+    }
+
+    auto recorder = FlightRecorder{};
+    recorder.m_x_size = x_size;
+    recorder.m_y_size = y_size;
+    recorder.m_capacity = capacity;
+    recorder.m_record_words = kFixedWords + x_size + y_size;
+    recorder.m_bytes =
+        kRingOffset + (capacity * recorder.m_record_words * sizeof(Word));
+
+    void *const base =
+        ::mmap(nullptr, recorder.m_bytes, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (base == MAP_FAILED) {
+      reason = "can't mmap " + std::to_string(recorder.m_bytes) +
+               " bytes (" + std::strerror(errno) + ")";
+      return std::nullopt;
+    }
+
+    recorder.m_base = static_cast<std::uint8_t *>(base);
+    new (recorder.m_base) std::atomic<std::uint64_t>{0};
+    return recorder;
+  }
+
+  FlightRecorder(const FlightRecorder &) = delete;
+  FlightRecorder &operator=(const FlightRecorder &) = delete;
+
+  FlightRecorder(FlightRecorder &&other) noexcept { Swap(other); }
+
+  FlightRecorder &operator=(FlightRecorder &&other) noexcept {
+    if (this != &other) {
+      Release();
+      Swap(other);
+    }
+    return *this;
+  }
+
+  ~FlightRecorder() noexcept { Release(); }
+
+  /// \return The number of X values per record
+  constexpr auto XSize() const noexcept -> std::size_t { return m_x_size; }
+
+  /// \return The number of Y values per record
+  constexpr auto YSize() const noexcept -> std::size_t { return m_y_size; }
+
+  /// \return The number of records kept
+  constexpr auto Capacity() const noexcept -> std::size_t {
+    return m_capacity;
+  }
+
+  /// \return The number of records recorded since the start
+  auto Recorded() const noexcept -> std::uint64_t {
+    return Counter().load(std::memory_order_acquire);
+  }
+
+  /**
+   *  \brief WRITER: Record the \a x (XSize() values) solved into \a y
+   *         (YSize() values) by the model \a model_version, at \a time_ns,
+   *         \a x being stamped with \a stamp_ns
+   */
+  auto Record(std::uint64_t model_version, std::int64_t time_ns,
+              std::int64_t stamp_ns, const double *x,
+              const double *y) noexcept -> void {
+    auto &counter = Counter();
+    const auto sequence = counter.load(std::memory_order_relaxed) + 1;
+    auto *const record = RecordAt((sequence - 1) % m_capacity);
+
+    // The sequence ending the record is written first, and the one starting
+    // it last: a dump (reading forward) of a record being overwritten never
+    // sees both matching
+    record[m_record_words - 1] = sequence;
+    std::atomic_thread_fence(std::memory_order_release);
+    record[1] = model_version;
+    record[2] = static_cast<Word>(time_ns);
+    record[3] = static_cast<Word>(stamp_ns);
+    std::memcpy(record + kXWord, x, m_x_size * sizeof(double));
+    std::memcpy(record + kXWord + m_x_size, y, m_y_size * sizeof(double));
+    std::atomic_thread_fence(std::memory_order_release);
+    record[0] = sequence;
+
+    counter.store(sequence, std::memory_order_release);
+  }
+
+  /**
+   *  \brief Write a FlightDumpHeader followed by the records kept (oldest
+   *         first) into \a fd
+   *
+   *  Async-signal-safe: only uses write(2).
+   *
+   *  \return False on write failure
+   */
+  auto DumpTo(int fd) const noexcept -> bool {
+    const auto recorded = Recorded();
+    const auto count = std::min<std::uint64_t>(recorded, m_capacity);
+
+    auto header = FlightDumpHeader{};
+    header.record_size =
+        static_cast<std::uint32_t>(m_record_words * sizeof(Word));
+    header.x_size = m_x_size;
+    header.y_size = m_y_size;
+    header.count = count;
+    header.recorded = recorded;
+    if (!WriteAll(fd, &header, sizeof(header))) return false;
+
+    const auto first = (recorded - count) % m_capacity;
+    const auto tail = std::min<std::uint64_t>(count, m_capacity - first);
+    const auto record_bytes = m_record_words * sizeof(Word);
+    return WriteAll(fd, RecordAt(first), tail * record_bytes) &&
+           WriteAll(fd, RecordAt(0), (count - tail) * record_bytes);
+  }
+
+  /**
+   *  \brief Dump (see DumpTo()) into the file \a path (replaced)
+   *
+   *  Async-signal-safe (as long as \a path is).
+   *
+   *  \return False on failure (errno being set)
+   */
+  auto DumpTo(const char *path) const noexcept -> bool {
+    const auto fd =
+        ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    const auto ok = DumpTo(fd);
+    return (::close(fd) == 0) && ok;
+  }
+
+ private:
+  using Word = std::uint64_t;
+
+  // Record: {sequence, model version, time, stamp, X..., Y..., sequence}
+  static constexpr std::size_t kXWord = 4;
+  static constexpr std::size_t kFixedWords = kXWord + 1;
+
+  // The records counter leads the mapping, its own cache line
+  static constexpr std::size_t kRingOffset = 64;
+
+  FlightRecorder() = default;
+
+  auto Counter() const noexcept -> std::atomic<std::uint64_t> & {
+    return *std::launder(reinterpret_cast<std::atomic<std::uint64_t> *>(
+        m_base));
+  }
+
+  auto RecordAt(std::size_t index) const noexcept -> Word * {
+    return reinterpret_cast<Word *>(m_base + kRingOffset) +
+           (index * m_record_words);
+  }
+
+  static auto WriteAll(int fd, const void *data, std::size_t size) noexcept
+      -> bool {
+    const auto *bytes = static_cast<const std::uint8_t *>(data);
+    while (size > 0) {
+      const auto written = ::write(fd, bytes, size);
+      if (written < 0) {
+        if (errno == EINTR) continue;
+        return false;
+      }
+      bytes += written;
+      size -= static_cast<std::size_t>(written);
+    }
+    return true;
+  }
+
+  auto Swap(FlightRecorder &other) noexcept -> void {
+    std::swap(m_base, other.m_base);
+    std::swap(m_bytes, other.m_bytes);
+    std::swap(m_x_size, other.m_x_size);
+    std::swap(m_y_size, other.m_y_size);
+    std::swap(m_capacity, other.m_capacity);
+    std::swap(m_record_words, other.m_record_words);
+  }
+
+  auto Release() noexcept -> void;
+
+  std::uint8_t *m_base = nullptr;
+  std::size_t m_bytes = 0;
+  std::size_t m_x_size = 0;
+  std::size_t m_y_size = 0;
+  std::size_t m_capacity = 0;
+  std::size_t m_record_words = 0;
+};
+
+namespace details {
+
+/// Recorder dumped on fault (see DumpOnFault()), and the file it is dumped to
+inline std::atomic<const FlightRecorder *> g_fault_recorder = nullptr;
+inline std::array<char, 4096> g_fault_path = {};
+
+/// Signals dumping the fault recorder, and their actions before that
+inline constexpr std::array<int, 5> kFaultSignals = {SIGSEGV, SIGBUS, SIGFPE,
+                                                     SIGILL, SIGABRT};
+inline std::array<struct sigaction, kFaultSignals.size()> g_previous_actions =
+    {};
+inline std::atomic<bool> g_fault_handlers_set = false;
+
+/**
+ *  \brief Dump the fault recorder (if any), then hand \a signal over to the
+ *         action set before DumpOnFault() (e.g. another crash handler, or
+ *         the default core dump)
+ */
+inline auto DumpAndChain(int signal, siginfo_t *info, void * /* context */)
+    -> void {
+  if (const auto *recorder = g_fault_recorder.exchange(nullptr);
+      recorder != nullptr) {
+    recorder->DumpTo(g_fault_path.data());
+  }
+
+  for (std::size_t i = 0; i < kFaultSignals.size(); ++i) {
+    if (kFaultSignals[i] == signal) {
+      ::sigaction(signal, &g_previous_actions[i], nullptr);
+    }
+  }
+
+  // A fault of the kernel (e.g. SIGSEGV on a bad access) is raised again,
+  // with its original info, when the faulting instruction is retried on
+  // return. Others (e.g. abort()) are raised here.
+  if ((info == nullptr) || (info->si_code <= 0)) std::raise(signal);
+}
+
+} // namespace details
+
+inline auto FlightRecorder::Release() noexcept -> void {
+  // Never dumped once released
+  const auto *self = this;
+  details::g_fault_recorder.compare_exchange_strong(self, nullptr);
+
+  if (m_base != nullptr) ::munmap(m_base, m_bytes);
+  m_base = nullptr;
+}
+
+/**
+ *  \brief Dump \a recorder into the file \a path when the process receives a
+ *         fault signal (SIGSEGV, SIGBUS, SIGFPE, SIGILL or SIGABRT), before
+ *         the action previously set for this signal (e.g. the core dump, or
+ *         the handler of another library, chained)
+ *
+ *  A single recorder is dumped on fault: the last one registered, until it
+ *  is destroyed. The handlers are only set by the first call.
+ *
+ *  \return False when \a path is too long, or the handlers can't be set
+ */
+inline auto DumpOnFault(const FlightRecorder &recorder,
+                        const std::string &path) -> bool {
+  if (path.size() >= details::g_fault_path.size()) return false;
+
+  // Not dumped while the path is being replaced
+  details::g_fault_recorder.store(nullptr);
+  std::copy_n(path.c_str(), path.size() + 1, details::g_fault_path.begin());
+
+  // Set once, such that the previous actions are never our own
+  if (!details::g_fault_handlers_set.load()) {
+    struct sigaction action = {};
+    action.sa_sigaction = details::DumpAndChain;
+    action.sa_flags = SA_SIGINFO | SA_NODEFER;
+    sigemptyset(&action.sa_mask);
+    for (std::size_t i = 0; i < details::kFaultSignals.size(); ++i) {
+      if (::sigaction(details::kFaultSignals[i], &action,
+                      &details::g_previous_actions[i]) != 0) {
+        // Nothing set, such that the next call saves the right actions
+        for (std::size_t j = 0; j < i; ++j) {
+          ::sigaction(details::kFaultSignals[j],
+                      &details::g_previous_actions[j], nullptr);
+        }
+        return false;
+      }
+    }
+    details::g_fault_handlers_set.store(true);
+  }
+
+  details::g_fault_recorder.store(&recorder);
+  return true;
+}
+
+/**
+ *  \brief Load the flight recorder dump \a path (see FlightRecorder::DumpTo)
+ *
+ *  Records overwritten while being dumped are dropped, the others are sorted
+ *  by sequence.
+ *
+ *  \param[out] header Header of the dump
+ *  \param[out] reason Reason of the failure, if any
+ *
+ *  \return The records, std::nullopt on failure
+ */
+inline auto LoadFlightDump(const std::string &path, FlightDumpHeader &header,
+                           std::string &reason)
+    -> std::optional<std::vector<FlightRecord>> {
+  auto file = std::ifstream{path, std::ios::binary};
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+    reason = "can't read the header of '" + path + "'";
+    return std::nullopt;
+  }
+
+  constexpr std::uint64_t kFixedWords = 5;
+  if ((header.magic != FlightDumpHeader::kMagic) ||
+      (header.version != FlightDumpHeader::kVersion) ||
+      (header.record_size != ((kFixedWords + header.x_size + header.y_size) *
+                              sizeof(std::uint64_t)))) {
+    reason = "'" + path + "' isn't a flight recorder dump of version " +
+             std::to_string(FlightDumpHeader::kVersion);
+    return std::nullopt;
+  }
+
+  auto records = std::vector<FlightRecord>{};
+  auto words = std::vector<std::uint64_t>(header.record_size /
+                                          sizeof(std::uint64_t));
+  for (std::uint64_t i = 0; i < header.count; ++i) {
+    if (!file.read(reinterpret_cast<char *>(words.data()),
+                   static_cast<std::streamsize>(header.record_size))) {
+      reason = "'" + path + "' is truncated";
+      return std::nullopt;
+    }
+
+    // Overwritten while being dumped
+    if ((words.front() == 0) || (words.front() != words.back())) continue;
+
+    auto &record = records.emplace_back();
+    record.sequence = words[0];
+    record.model_version = words[1];
+    record.time_ns = static_cast<std::int64_t>(words[2]);
+    record.stamp_ns = static_cast<std::int64_t>(words[3]);
+
+    record.x.resize(header.x_size);
+    record.y.resize(header.y_size);
+    std::memcpy(record.x.data(), words.data() + 4,
+                header.x_size * sizeof(double));
+    std::memcpy(record.y.data(), words.data() + 4 + header.x_size,
+                header.y_size * sizeof(double));
+  }
+
+  std::sort(records.begin(), records.end(),
+            [](const FlightRecord &lhs, const FlightRecord &rhs) {
+              return lhs.sequence < rhs.sequence;
+            });
+  return records;
+}
+
+} // namespace lfc
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <utility>
+
+#include "has_trait.hpp"
+
+namespace lfc::internal {
+
+namespace details {
+
+template <class T>
+using NoAliasMemberFunction = decltype(std::declval<T>().noalias());
+
+}
+
+/// Set to TRUE when `T.noalias()` exists (e.g. Eigen's dense objects)
+template <class T>
+struct HasNoAliasMemberFunction
+    : HasTrait<details::NoAliasMemberFunction, T> {};
+
+template <class T>
+constexpr bool HasNoAliasMemberFunction_v =
+    HasNoAliasMemberFunction<T>::value;
+
+} // namespace lfc::internal
@@ -8,6 +8,7 @@
 #include "internal/reference_wrapper.hpp"
 #include "internal/traits_has_accepts.hpp"
 #include "internal/traits_has_is_valid.hpp"
+#include "internal/traits_has_noalias.hpp"
 
 namespace lfc {
 
@@ -233,6 +234,44 @@ constexpr auto Solve(Model &&m, X &&x) {
   }
 }
 
+/**
+ *  \brief Solve the model, writing the result into \a y instead of returning
+ *         a new value
+ *
+ *  This is the allocation-free counterpart of Solve(), intended to be used on
+ *  the control path with preallocated outputs. It evaluates
+ *  `y = coeffs * x` followed by `y += offset` (when the model has an offset).
+ *  When Y defines `noalias()` (i.e. Eigen types), the product is evaluated
+ *  directly into \a y, without any temporary.
+ *
+ *  \param[in] m Any valid LinearModel<>
+ *  \param[in] x Any value X that can be multiplied by the model's coeffs
+ *  \param[out] y Output, assignable from (coeffs * x)
+ *
+ *  \pre IsValid(m) returns true
+ *  \pre Accepts(m, x) returns true
+ *  \pre y does not alias x
+ */
+template <class Model, class X, class Y, class...,
+          class ModelTraits = LinearModelTraits<std::decay_t<Model>>,
+          std::enable_if_t<ModelTraits::value, bool> = true>
+constexpr auto SolveInto(Model &&m, X &&x, Y &&y) -> void {
+  assert(IsValid(m) &&
+         "Model is not valid. Some parameters may be wrongly set internally.");
+
+  assert(Accepts(m, x) && "Model doesn't accept the given state X.");
+
+  if constexpr (internal::HasNoAliasMemberFunction_v<Y &>) {
+    y.noalias() = std::forward<Model>(m).coeffs * std::forward<X>(x);
+  } else {
+    y = std::forward<Model>(m).coeffs * std::forward<X>(x);
+  }
+
+  if constexpr (ModelTraits::HasOffset()) {
+    y += std::forward<Model>(m).offset;
+  }
+}
+
 /**
  *  \return The result of Solve() when IsValid() and Accepts() returns true,
  *          std::nullopt otherwise.
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace lfc {
+
+/// How a LinearModelTrajectory is sampled between 2 consecutive models
+enum class TrajectoryInterpolation {
+  kHold,   /*!< Zero order hold: the model k is active within [t_k, t_k+1[ */
+  kLinear, /*!< Linear blend between the models k and k+1 */
+};
+
+/// Location of a time t within a LinearModelTrajectory
+struct TrajectoryPoint {
+  std::size_t index = 0; /*!< Index k of the active model */
+  double alpha = 0.;     /*!< kLinear only: weight of the model k+1 [0, 1[ */
+};
+
+/**
+ *  \brief Time indexed sequence of linear models (coeffs_k, offset_k),
+ *         uniformly sampled at t_k = t0 + k * dt
+ *
+ *  All the models are stored one after the other, in a single contiguous
+ *  buffer, each one being the ROWS x COLS coefficients (column major, as
+ *  Eigen's default) followed by the ROWS offset values.
+ *
+ *  This buffer is either owned by the trajectory, or borrowed from any
+ *  memory kept alive alongside (e.g. a memory mapped file).
+ *
+ *  \tparam Scalar Type of the coefficients/offset values
+ */
+template <class Scalar>
+class LinearModelTrajectory {
+ public:
+  /// Empty trajectory
+  LinearModelTrajectory() = default;
+
+  /**
+   *  \brief Construct a trajectory from \a size values of \a data
+   *
+   *  \pre \a size is a multiple of (rows * cols + rows)
+   *  \pre \a dt > 0
+   *
+   *  \param[in] owner Keeps \a data alive as long as the trajectory exists
+   */
+  LinearModelTrajectory(std::size_t rows, std::size_t cols, double t0,
+                        double dt, const Scalar *data, std::size_t size,
+                        std::shared_ptr<const void> owner)
+      : m_rows(rows),
+        m_cols(cols),
+        m_t0(t0),
+        m_dt(dt),
+        m_count(size / ((rows * cols) + rows)),
+        m_data(data),
+        m_owner(std::move(owner)) {}
+
+  /// \return The number of models
+  constexpr auto Count() const noexcept -> std::size_t { return m_count; }
+
+  /// \return The number of rows of the coefficients (size of the offset)
+  constexpr auto Rows() const noexcept -> std::size_t { return m_rows; }
+
+  /// \return The number of cols of the coefficients
+  constexpr auto Cols() const noexcept -> std::size_t { return m_cols; }
+
+  /// \return Time of the first model
+  constexpr auto Start() const noexcept -> double { return m_t0; }
+
+  /// \return Time between 2 consecutive models
+  constexpr auto Period() const noexcept -> double { return m_dt; }
+
+  /// \return Number of values between 2 consecutive models
+  constexpr auto Stride() const noexcept -> std::size_t {
+    return (m_rows * m_cols) + m_rows;
+  }
+
+  /// \return Ptr to the ROWS x COLS (column major) coeffs of the model \a k
+  constexpr auto Coeffs(std::size_t k) const noexcept -> const Scalar * {
+    return m_data + (k * Stride());
+  }
+
+  /// \return Ptr to the ROWS offset values of the model \a k
+  constexpr auto Offset(std::size_t k) const noexcept -> const Scalar * {
+    return Coeffs(k) + (m_rows * m_cols);
+  }
+
+  /**
+   *  \return The active model at \a t (in O(1)), clamped to the first/last
+   *          model outside of the trajectory
+   *
+   *  \pre Count() > 0
+   */
+  auto Locate(double t, TrajectoryInterpolation interpolation) const noexcept
+      -> TrajectoryPoint {
+    const auto position = (t - m_t0) / m_dt;
+    if (!(position > 0.)) return TrajectoryPoint{0, 0.};
+
+    const auto last = m_count - 1;
+    if (position >= static_cast<double>(last)) {
+      return TrajectoryPoint{last, 0.};
+    }
+
+    auto point = TrajectoryPoint{static_cast<std::size_t>(position), 0.};
+    if (interpolation == TrajectoryInterpolation::kLinear) {
+      point.alpha = position - std::floor(position);
+    }
+    return point;
+  }
+
+  /**
+   *  \brief Hint the CPU to fetch the model \a k into its caches, ahead of
+   *         its use (no-op when \a k is out of the trajectory)
+   */
+  auto Prefetch(std::size_t k) const noexcept -> void {
+    if (k >= m_count) return;
+
+    constexpr std::size_t kCacheLine = 64;
+    const auto *const begin = reinterpret_cast<const char *>(Coeffs(k));
+    const auto bytes = Stride() * sizeof(Scalar);
+    for (std::size_t offset = 0; offset < bytes; offset += kCacheLine) {
+      __builtin_prefetch(begin + offset, /* rw = */ 0, /* locality = */ 1);
+    }
+  }
+
+ private:
+  std::size_t m_rows = 0;
+  std::size_t m_cols = 0;
+  double m_t0 = 0.;
+  double m_dt = 1.;
+  std::size_t m_count = 0;
+  const Scalar *m_data = nullptr;
+  std::shared_ptr<const void> m_owner = nullptr;
+};
+
+/**
+ *  \brief Reorder, in place, the ROWS x COLS coefficients of each model of
+ *         \a values from row major to column major (the offsets are kept)
+ *
+ *  \return False (\a values being untouched) when they don't hold a whole
+ *          number of models
+ */
+template <class Scalar>
+auto RowMajorToColumnMajorModels(std::size_t rows, std::size_t cols,
+                                 std::vector<Scalar> &values) -> bool {
+  const auto stride = (rows * cols) + rows;
+  if ((stride == 0) || ((values.size() % stride) != 0)) return false;
+
+  auto coeffs = std::vector<Scalar>(rows * cols);
+  for (std::size_t begin = 0; begin < values.size(); begin += stride) {
+    auto *const model = values.data() + begin;
+    std::copy(model, model + (rows * cols), coeffs.data());
+    for (std::size_t row = 0; row < rows; ++row) {
+      for (std::size_t col = 0; col < cols; ++col) {
+        model[(col * rows) + row] = coeffs[(row * cols) + col];
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ *  \return A trajectory owning \a values (the models one after the other),
+ *          std::nullopt when the values don't hold a whole number of models
+ *          or \a dt isn't > 0
+ */
+template <class Scalar>
+auto MakeLinearModelTrajectory(std::size_t rows, std::size_t cols, double t0,
+                               double dt, std::vector<Scalar> values)
+    -> std::optional<LinearModelTrajectory<Scalar>> {
+  const auto stride = (rows * cols) + rows;
+  if ((stride == 0) || ((values.size() % stride) != 0) || !(dt > 0.)) {
+    return std::nullopt;
+  }
+
+  auto owner = std::make_shared<const std::vector<Scalar>>(std::move(values));
+  const auto *const data = owner->data();
+  const auto size = owner->size();
+  return LinearModelTrajectory<Scalar>{
+      rows, cols, t0, dt, data, size, std::move(owner)};
+}
+
+/**
+ *  \return A trajectory borrowing the \a size values of \a data (kept alive by
+ *          \a owner, e.g. a memory mapped file), std::nullopt when the values
+ *          don't hold a whole number of models or \a dt isn't > 0
+ */
+template <class Scalar>
+auto MakeLinearModelTrajectory(std::size_t rows, std::size_t cols, double t0,
+                               double dt, const Scalar *data, std::size_t size,
+                               std::shared_ptr<const void> owner)
+    -> std::optional<LinearModelTrajectory<Scalar>> {
+  const auto stride = (rows * cols) + rows;
+  if ((stride == 0) || ((size % stride) != 0) || !(dt > 0.) ||
+      ((data == nullptr) && (size > 0))) {
+    return std::nullopt;
+  }
+
+  return LinearModelTrajectory<Scalar>{
+      rows, cols, t0, dt, data, size, std::move(owner)};
+}
+
+} // namespace lfc
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace lfc::lockfree {
+
+/**
+ *  \brief Constant memory, HDR style, histogram of values (e.g. durations in
+ *         ns) recorded by ONE writer, read by any number of readers
+ *
+ *  Values are counted into logarithmic buckets: each range [2^k, 2^(k+1)[ is
+ *  split into 2^SubBucketBits linear sub buckets, bounding the relative error
+ *  of any value reported to 2^-SubBucketBits (values < 2^SubBucketBits are
+ *  exact). The whole std::uint64_t range is covered, without any allocation.
+ *
+ *  Record() is wait-free: the writer owns all the counters, updated with
+ *  relaxed loads/stores only (no read-modify-write). Readers may observe a
+ *  value being recorded partially (e.g. counted but not yet summed).
+ *
+ *  \tparam SubBucketBits Precision of the histogram (log2 of the sub buckets)
+ */
+template <std::size_t SubBucketBits = 4>
+class Histogram {
+  static_assert((SubBucketBits > 0) && (SubBucketBits < 16));
+  static_assert(sizeof(std::size_t) == sizeof(std::uint64_t));
+
+ public:
+  static constexpr std::size_t kSubBuckets = std::size_t{1} << SubBucketBits;
+  static constexpr std::size_t kBuckets = (65 - SubBucketBits) * kSubBuckets;
+
+  Histogram() = default;
+  Histogram(const Histogram &) = delete;
+  Histogram &operator=(const Histogram &) = delete;
+
+  /// \return The index of the bucket counting \a value
+  static constexpr auto BucketOf(std::uint64_t value) noexcept
+      -> std::size_t {
+    if (value < kSubBuckets) return value;
+
+    const auto msb = static_cast<std::size_t>(63 - __builtin_clzll(value));
+    const auto shift = msb - SubBucketBits;
+    const auto sub = (value >> shift) & (kSubBuckets - 1);
+    return ((shift + 1) * kSubBuckets) + sub;
+  }
+
+  /// \return The lowest value counted by the bucket \a index
+  static constexpr auto LowestOf(std::size_t index) noexcept
+      -> std::uint64_t {
+    if (index < kSubBuckets) return index;
+
+    const auto shift = (index / kSubBuckets) - 1;
+    const auto sub = index % kSubBuckets;
+    return std::uint64_t{kSubBuckets + sub} << shift;
+  }
+
+  /// \return The highest value counted by the bucket \a index
+  static constexpr auto HighestOf(std::size_t index) noexcept
+      -> std::uint64_t {
+    if (index < kSubBuckets) return index;
+
+    const auto shift = (index / kSubBuckets) - 1;
+    return LowestOf(index) + ((std::uint64_t{1} << shift) - 1);
+  }
+
+  /// WRITER: Count \a value
+  auto Record(std::uint64_t value) noexcept -> void {
+    Increment(m_counts[BucketOf(value)], 1);
+    Increment(m_count, 1);
+    Increment(m_sum, value);
+    if (value > m_max.load(std::memory_order_relaxed)) {
+      m_max.store(value, std::memory_order_relaxed);
+    }
+  }
+
+  /// \return The number of values recorded
+  auto Count() const noexcept -> std::uint64_t {
+    return m_count.load(std::memory_order_relaxed);
+  }
+
+  /// \return The sum of all the values recorded
+  auto Sum() const noexcept -> std::uint64_t {
+    return m_sum.load(std::memory_order_relaxed);
+  }
+
+  /// \return The highest value recorded (exact), 0 if none
+  auto Max() const noexcept -> std::uint64_t {
+    return m_max.load(std::memory_order_relaxed);
+  }
+
+  /// \return The mean of the values recorded, 0 if none
+  auto Mean() const noexcept -> double {
+    const auto count = Count();
+    return (count == 0) ? 0.
+                        : static_cast<double>(Sum()) /
+                              static_cast<double>(count);
+  }
+
+  /**
+   *  \return The value below which \a percentile % of the values recorded
+   *          fall (i.e. the highest value of the bucket reaching it, never
+   *          above Max()), 0 if none
+   */
+  auto ValueAtPercentile(double percentile) const noexcept -> std::uint64_t {
+    // Counts are summed from the buckets, consistent with each other
+    auto total = std::uint64_t{0};
+    for (const auto &count : m_counts) {
+      total += count.load(std::memory_order_relaxed);
+    }
+    if (total == 0) return 0;
+
+    const auto clamped = (percentile < 0.)     ? 0.
+                         : (percentile > 100.) ? 100.
+                                               : percentile;
+    auto target = static_cast<std::uint64_t>(
+        (clamped / 100.) * static_cast<double>(total) + 0.5);
+    if (target == 0) target = 1;
+
+    auto seen = std::uint64_t{0};
+    for (std::size_t i = 0; i < kBuckets; ++i) {
+      seen += m_counts[i].load(std::memory_order_relaxed);
+      if (seen >= target) {
+        const auto max = Max();
+        const auto highest = HighestOf(i);
+        return ((max > 0) && (max < highest)) ? max : highest;
+      }
+    }
+
+    return Max();
+  }
+
+  /**
+   *  \brief WRITER: Count all the values recorded by \a other (e.g. merging
+   *         the histograms of several writers, once they are done)
+   */
+  auto Merge(const Histogram &other) noexcept -> void {
+    for (std::size_t i = 0; i < kBuckets; ++i) {
+      Increment(m_counts[i], other.m_counts[i].load(std::memory_order_relaxed));
+    }
+    Increment(m_count, other.Count());
+    Increment(m_sum, other.Sum());
+    if (other.Max() > Max()) {
+      m_max.store(other.Max(), std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   *  \brief Forget all the values recorded
+   *
+   *  \warning NOT thread safe with Record(), only meant to be used while the
+   *           writer isn't running
+   */
+  auto Reset() noexcept -> void {
+    for (auto &count : m_counts) count.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  /// Single writer: a plain load/store, cheaper than a fetch_add
+  static auto Increment(std::atomic<std::uint64_t> &counter,
+                        std::uint64_t value) noexcept -> void {
+    counter.store(counter.load(std::memory_order_relaxed) + value,
+                  std::memory_order_relaxed);
+  }
+
+  std::array<std::atomic<std::uint64_t>, kBuckets> m_counts = {};
+  std::atomic<std::uint64_t> m_count = 0;
+  std::atomic<std::uint64_t> m_sum = 0;
+  std::atomic<std::uint64_t> m_max = 0;
+};
+
+} // namespace lfc::lockfree
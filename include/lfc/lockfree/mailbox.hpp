@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace lfc::lockfree {
+
+/**
+ *  \brief Single-slot, latest-value, mailbox between ONE writer and ONE reader
+ *
+ *  The writer fills Back() then calls Post(), overwriting any value not yet
+ *  fetched by the reader. The reader calls Fetch() to grab the newest posted
+ *  value (if any) and reads it through Front(), which stays untouched by the
+ *  writer until the next Fetch().
+ *
+ *  Internally, this is a triple buffer: both sides are wait-free, never
+ *  allocate nor copy T (only a single atomic exchange of an index), and the
+ *  reader can never observe a partially written value.
+ *
+ *  \warning The value found in Back() is NOT the last posted value: it may be
+ *           a few values behind (or the initial one). The writer is expected
+ *           to fully overwrite it.
+ *
+ *  \tparam T Type of the values exchanged
+ */
+template <class T>
+class Mailbox {
+ public:
+  /// Default construct all the slots
+  Mailbox() = default;
+
+  /// Copy \a init into all the slots (e.g. to preallocate them)
+  explicit Mailbox(const T &init) : m_slots{init, init, init} {}
+
+  Mailbox(const Mailbox &) = delete;
+  Mailbox &operator=(const Mailbox &) = delete;
+
+  /// WRITER: \return The slot to fill before calling Post()
+  constexpr auto Back() noexcept -> T & { return m_slots[m_back]; }
+
+  /// WRITER: Make the value written into Back() available to the reader
+  auto Post() noexcept -> void {
+    m_back = m_middle.exchange(m_back | kFresh, std::memory_order_acq_rel) &
+             kIndex;
+  }
+
+  /**
+   *  \brief READER: Fetch the newest posted value, if any
+   *
+   *  \return True when a new value has been fetched into Front(). False when
+   *          nothing has been posted since the last Fetch() (Front() is left
+   *          untouched).
+   */
+  auto Fetch() noexcept -> bool {
+    if ((m_middle.load(std::memory_order_relaxed) & kFresh) == 0) {
+      return false;
+    }
+
+    m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & kIndex;
+    return true;
+  }
+
+  /// READER: \return The last fetched value (the initial one by default)
+  constexpr auto Front() noexcept -> T & { return m_slots[m_front]; }
+  constexpr auto Front() const noexcept -> const T & {
+    return m_slots[m_front];
+  }
+
+  /**
+   *  \brief Apply \a f to all slots
+   *
+   *  \warning NOT thread safe, only meant to (re)initialize the mailbox
+   *           before/after the writer/reader are running
+   */
+  template <class F>
+  auto ForEachSlot(F &&f) -> void {
+    for (auto &slot : m_slots) f(slot);
+  }
+
+ private:
+  static constexpr std::uint8_t kIndex = 0b011; /*!< Mask of the slot index */
+  static constexpr std::uint8_t kFresh = 0b100; /*!< Set when not fetched */
+
+  std::array<T, 3> m_slots = {};
+
+  alignas(64) std::atomic<std::uint8_t> m_middle = 1; /*!< Shared */
+  alignas(64) std::uint8_t m_back = 0;                /*!< Writer only */
+  alignas(64) std::uint8_t m_front = 2;               /*!< Reader only */
+};
+
+} // namespace lfc::lockfree
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace lfc::lockfree {
+
+/**
+ *  \brief Value written by ONE writer, read consistently by any number of
+ *         readers, through a sequence lock
+ *
+ *  The writer never waits: Store() bumps the sequence to odd, writes the
+ *  value and bumps it back to even. Readers copy the value and retry while
+ *  the sequence was odd, or changed, during their copy (see TryLoad()).
+ *
+ *  The value is held as relaxed atomic words (no data race), such that the
+ *  Seqlock can be shared between processes (e.g. in shared memory, as long
+ *  as std::atomic<std::uint64_t> is lock free).
+ *
+ *  \tparam T Type of the value, trivially copyable
+ */
+template <class T>
+class Seqlock {
+  static_assert(std::is_trivially_copyable_v<T>);
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+  static constexpr std::size_t kWords =
+      (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+ public:
+  Seqlock() = default;
+  Seqlock(const Seqlock &) = delete;
+  Seqlock &operator=(const Seqlock &) = delete;
+
+  /// WRITER: Replace the value by \a value (wait free)
+  auto Store(const T &value) noexcept -> void {
+    auto words = std::array<std::uint64_t, kWords>{};
+    std::memcpy(words.data(), &value, sizeof(T));
+
+    const auto sequence = m_sequence.load(std::memory_order_relaxed);
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (std::size_t i = 0; i < kWords; ++i) {
+      m_words[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    m_sequence.store(sequence + 2, std::memory_order_release);
+  }
+
+  /**
+   *  \brief READER: Try to copy the value into \a out
+   *
+   *  \return True when \a out holds a consistent value. False when the
+   *          writer was storing concurrently (\a out is left untouched).
+   */
+  auto TryLoad(T &out) const noexcept -> bool {
+    const auto before = m_sequence.load(std::memory_order_acquire);
+    if ((before & 1) != 0) return false;
+
+    auto words = std::array<std::uint64_t, kWords>{};
+    for (std::size_t i = 0; i < kWords; ++i) {
+      words[i] = m_words[i].load(std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (m_sequence.load(std::memory_order_relaxed) != before) return false;
+
+    std::memcpy(static_cast<void *>(&out), words.data(), sizeof(T));
+    return true;
+  }
+
+  /// READER: \return A consistent copy of the value, retrying until success
+  auto Load() const noexcept -> T {
+    auto out = T{};
+    while (!TryLoad(out)) {
+    }
+    return out;
+  }
+
+  /// \return The number of Store() done (twice, odd while storing)
+  auto Sequence() const noexcept -> std::uint64_t {
+    return m_sequence.load(std::memory_order_acquire);
+  }
+
+ private:
+  std::atomic<std::uint64_t> m_sequence = 0;
+  std::array<std::atomic<std::uint64_t>, kWords> m_words = {};
+};
+
+/**
+ *  \brief Header followed by a runtime number of values (e.g. a segment of a
+ *         state vector, alongside when it was received), written by ONE
+ *         writer and read consistently by any number of readers, through a
+ *         sequence lock (see Seqlock)
+ *
+ *  The words are allocated once, when constructed: neither Store() nor
+ *  TryLoad() ever allocate.
+ *
+ *  \tparam Header Type of the header, trivially copyable
+ *  \tparam T Type of the values, trivially copyable
+ */
+template <class Header, class T>
+class SeqlockArray {
+  static_assert(std::is_trivially_copyable_v<Header>);
+  static_assert(std::is_trivially_copyable_v<T>);
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+  static constexpr std::size_t kHeaderWords =
+      (sizeof(Header) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+ public:
+  /// Construct the array of \a size values (zero initialized, as the header)
+  explicit SeqlockArray(std::size_t size)
+      : m_size(size),
+        m_words(std::make_unique<std::atomic<std::uint64_t>[]>(
+            kHeaderWords + ValueWords(size))) {
+    for (std::size_t i = 0; i < kHeaderWords + ValueWords(size); ++i) {
+      m_words[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  SeqlockArray(const SeqlockArray &) = delete;
+  SeqlockArray &operator=(const SeqlockArray &) = delete;
+
+  /// \return The number of values
+  auto Size() const noexcept -> std::size_t { return m_size; }
+
+  /// WRITER: Replace the header by \a header, and the values by the Size()
+  /// \a values (wait free)
+  auto Store(const Header &header, const T *values) noexcept -> void {
+    auto header_words = std::array<std::uint64_t, kHeaderWords>{};
+    std::memcpy(header_words.data(), &header, sizeof(Header));
+
+    const auto sequence = m_sequence.load(std::memory_order_relaxed);
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (std::size_t i = 0; i < kHeaderWords; ++i) {
+      m_words[i].store(header_words[i], std::memory_order_relaxed);
+    }
+
+    const auto *const bytes = reinterpret_cast<const char *>(values);
+    const auto size = m_size * sizeof(T);
+    for (std::size_t i = 0; i < ValueWords(m_size); ++i) {
+      const auto offset = i * sizeof(std::uint64_t);
+      auto word = std::uint64_t{0};
+      std::memcpy(&word, bytes + offset,
+                  std::min(sizeof(std::uint64_t), size - offset));
+      m_words[kHeaderWords + i].store(word, std::memory_order_relaxed);
+    }
+
+    m_sequence.store(sequence + 2, std::memory_order_release);
+  }
+
+  /**
+   *  \brief READER: Try to copy the header into \a header, and the values
+   *         into the Size() \a values
+   *
+   *  \return True when \a header and \a values are consistent. False when
+   *          the writer was storing concurrently (\a header is left
+   *          untouched, but \a values may have been partially overwritten).
+   */
+  auto TryLoad(Header &header, T *values) const noexcept -> bool {
+    const auto before = m_sequence.load(std::memory_order_acquire);
+    if ((before & 1) != 0) return false;
+
+    auto header_words = std::array<std::uint64_t, kHeaderWords>{};
+    for (std::size_t i = 0; i < kHeaderWords; ++i) {
+      header_words[i] = m_words[i].load(std::memory_order_relaxed);
+    }
+
+    auto *const bytes = reinterpret_cast<char *>(values);
+    const auto size = m_size * sizeof(T);
+    for (std::size_t i = 0; i < ValueWords(m_size); ++i) {
+      const auto offset = i * sizeof(std::uint64_t);
+      const auto word =
+          m_words[kHeaderWords + i].load(std::memory_order_relaxed);
+      std::memcpy(bytes + offset, &word,
+                  std::min(sizeof(std::uint64_t), size - offset));
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (m_sequence.load(std::memory_order_relaxed) != before) return false;
+
+    std::memcpy(static_cast<void *>(&header), header_words.data(),
+                sizeof(Header));
+    return true;
+  }
+
+  /**
+   *  \brief READER: Copy the header into \a header and the values into
+   *         \a values, retrying until consistent (see TryLoad())
+   *
+   *  \warning Unbounded: a real-time reader must bound its TryLoad() calls
+   *           instead, as it could otherwise spin forever on a writer it
+   *           preempted in the middle of a Store()
+   */
+  auto Load(Header &header, T *values) const noexcept -> void {
+    while (!TryLoad(header, values)) {
+    }
+  }
+
+  /// \return The number of Store() done (twice, odd while storing)
+  auto Sequence() const noexcept -> std::uint64_t {
+    return m_sequence.load(std::memory_order_acquire);
+  }
+
+ private:
+  static constexpr auto ValueWords(std::size_t size) noexcept -> std::size_t {
+    return ((size * sizeof(T)) + sizeof(std::uint64_t) - 1) /
+           sizeof(std::uint64_t);
+  }
+
+  std::size_t m_size;
+  std::atomic<std::uint64_t> m_sequence = 0;
+  std::unique_ptr<std::atomic<std::uint64_t>[]> m_words;
+};
+
+} // namespace lfc::lockfree
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace lfc::lockfree {
+
+/**
+ *  \brief Bounded ring of N preallocated T, between ONE producer and ONE
+ *         consumer
+ *
+ *  Slots are filled and consumed in place (no copies, no allocations):
+ *  - The producer grabs a free slot with TryClaim(), fills it, then makes it
+ *    visible to the consumer with Commit();
+ *  - The consumer grabs the oldest committed slot with TryPeek(), uses it,
+ *    then gives it back to the producer with Release().
+ *
+ *  All operations are wait-free (a few atomic loads/stores, no RMW).
+ *
+ *  \tparam T Type of the slots
+ *  \tparam N Number of slots, must be a power of 2
+ */
+template <class T, std::size_t N>
+class SpscRing {
+  static_assert((N > 0) && ((N & (N - 1)) == 0), "N must be a power of 2");
+
+ public:
+  /// Default construct all the slots
+  SpscRing() = default;
+
+  /// Copy \a init into all the slots (e.g. to preallocate them)
+  explicit SpscRing(const T &init) { m_slots.fill(init); }
+
+  SpscRing(const SpscRing &) = delete;
+  SpscRing &operator=(const SpscRing &) = delete;
+
+  /// \return The number of slots
+  static constexpr auto Capacity() noexcept -> std::size_t { return N; }
+
+  /**
+   *  \brief PRODUCER: \return The next free slot, nullptr when the ring is full
+   *
+   *  Calling it again without Commit() returns the same slot.
+   */
+  auto TryClaim() noexcept -> T * {
+    const auto tail = m_tail.load(std::memory_order_relaxed);
+    if ((tail - m_head_cache) == N) {
+      m_head_cache = m_head.load(std::memory_order_acquire);
+      if ((tail - m_head_cache) == N) return nullptr;
+    }
+    return &m_slots[tail & kMask];
+  }
+
+  /// PRODUCER: Publish the slot returned by TryClaim() to the consumer
+  ///
+  /// \pre TryClaim() returned a slot (not nullptr)
+  auto Commit() noexcept -> void {
+    m_tail.store(m_tail.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_release);
+  }
+
+  /**
+   *  \brief CONSUMER: \return The oldest committed slot, nullptr when the ring
+   *         is empty
+   *
+   *  Calling it again without Release() returns the same slot.
+   */
+  auto TryPeek() noexcept -> T * {
+    const auto head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail_cache) {
+      m_tail_cache = m_tail.load(std::memory_order_acquire);
+      if (head == m_tail_cache) return nullptr;
+    }
+    return &m_slots[head & kMask];
+  }
+
+  /// CONSUMER: Give the slot returned by TryPeek() back to the producer
+  ///
+  /// \pre TryPeek() returned a slot (not nullptr)
+  auto Release() noexcept -> void {
+    m_head.store(m_head.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_release);
+  }
+
+  /**
+   *  \brief Apply \a f to all slots
+   *
+   *  \warning NOT thread safe, only meant to (re)initialize the ring before or
+   *           after the producer/consumer are running
+   */
+  template <class F>
+  auto ForEachSlot(F &&f) -> void {
+    for (auto &slot : m_slots) f(slot);
+  }
+
+ private:
+  static constexpr std::size_t kMask = N - 1;
+
+  std::array<T, N> m_slots = {};
+
+  alignas(64) std::atomic<std::size_t> m_head = 0; /*!< Next slot to consume */
+  std::size_t m_tail_cache = 0;                    /*!< Consumer only */
+
+  alignas(64) std::atomic<std::size_t> m_tail = 0; /*!< Next slot to produce */
+  std::size_t m_head_cache = 0;                    /*!< Producer only */
+};
+
+} // namespace lfc::lockfree
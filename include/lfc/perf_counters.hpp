@@ -0,0 +1,257 @@
+#pragma once
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace lfc {
+
+/// Hardware events counted by PerfCounters
+enum class PerfEvent : std::size_t {
+  kCycles,
+  kInstructions,
+  kLlcMisses, /*!< Last level cache misses */
+  kBranchMisses,
+};
+
+constexpr std::size_t kPerfEventCount = 4;
+
+constexpr auto ToString(PerfEvent event) noexcept -> std::string_view {
+  switch (event) {
+    case PerfEvent::kCycles: return "cycles";
+    case PerfEvent::kInstructions: return "instructions";
+    case PerfEvent::kLlcMisses: return "llc_misses";
+    case PerfEvent::kBranchMisses: return "branch_misses";
+  }
+
+  return "";
+}
+
+/// Values of the PerfEvent counters (indexed by PerfEvent)
+using PerfSample = std::array<std::uint64_t, kPerfEventCount>;
+
+/**
+ *  \brief Group of hardware counters (see PerfEvent) of the calling thread,
+ *         through perf_event_open(2)
+ *
+ *  The counters only count the user space of the thread that opened them.
+ *  When permitted (x86, perf_event_mmap_page::cap_user_rdpmc), they are read
+ *  with the rdpmc instruction, without any syscall. Otherwise, they are read
+ *  with a single read(2) of the group.
+ *
+ *  Typical usage, around lfc::SolveInto():
+ *  \code
+ *  auto reason = std::string{};
+ *  auto perf = PerfCounters::Open(reason);
+ *  if (perf.has_value()) {
+ *    auto sample = PerfSample{};
+ *    perf->Measure(sample, [&]() { SolveInto(model, x, y); });
+ *  }
+ *  \endcode
+ */
+class PerfCounters {
+ public:
+  /**
+   *  \brief Open, and start, the counters of the calling thread
+   *
+   *  \param[out] reason Reason of the failure (e.g. no PMU available, or not
+   *              permitted by kernel.perf_event_paranoid), if any
+   *
+   *  \return The counters, std::nullopt on failure
+   */
+  static auto Open(std::string &reason) -> std::optional<PerfCounters> {
+    constexpr std::array<std::uint64_t, kPerfEventCount> kConfigs = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES,
+    };
+
+    auto counters = PerfCounters{};
+    for (std::size_t i = 0; i < kPerfEventCount; ++i) {
+      auto attr = perf_event_attr{};
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = kConfigs[i];
+      attr.disabled = (i == 0) ? 1 : 0; /* The leader enables the group */
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP;
+
+      const auto group = (i == 0) ? -1 : counters.m_fds[0];
+      const auto fd = static_cast<int>(
+          ::syscall(SYS_perf_event_open, &attr, /* pid = */ 0, /* cpu = */ -1,
+                    group, PERF_FLAG_FD_CLOEXEC));
+      if (fd < 0) {
+        reason = "can't open the '" +
+                 std::string{ToString(static_cast<PerfEvent>(i))} +
+                 "' counter (" + std::strerror(errno) + ")";
+        return std::nullopt;
+      }
+      counters.m_fds[i] = fd;
+
+      // Only needed by rdpmc, the counters are still usable without
+      void *const page = ::mmap(nullptr, PageSize(), PROT_READ, MAP_SHARED,
+                                fd, 0);
+      if (page != MAP_FAILED) {
+        counters.m_pages[i] = static_cast<const perf_event_mmap_page *>(page);
+      }
+    }
+
+    if (::ioctl(counters.m_fds[0], PERF_EVENT_IOC_ENABLE,
+                PERF_IOC_FLAG_GROUP) != 0) {
+      reason = std::string{"can't enable the counters ("} +
+               std::strerror(errno) + ")";
+      return std::nullopt;
+    }
+
+    return counters;
+  }
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  PerfCounters(PerfCounters &&other) noexcept
+      : m_fds(std::exchange(other.m_fds, kNoFds)),
+        m_pages(std::exchange(other.m_pages, {})) {}
+
+  PerfCounters &operator=(PerfCounters &&other) noexcept {
+    if (this != &other) {
+      Close();
+      m_fds = std::exchange(other.m_fds, kNoFds);
+      m_pages = std::exchange(other.m_pages, {});
+    }
+    return *this;
+  }
+
+  ~PerfCounters() noexcept { Close(); }
+
+  /// \return True when all the counters are currently readable with rdpmc
+  auto UsesRdpmc() const noexcept -> bool {
+    auto sample = PerfSample{};
+    return ReadRdpmc(sample);
+  }
+
+  /**
+   *  \brief Read the current values of the counters into \a out
+   *
+   *  \return False when they can't be read (\a out is unspecified)
+   */
+  auto Read(PerfSample &out) const noexcept -> bool {
+    return ReadRdpmc(out) || ReadGroup(out);
+  }
+
+  /**
+   *  \brief Call \a f, counting the events occurring during this call into
+   *         \a delta
+   *
+   *  \return False when the counters can't be read (\a f is called anyway,
+   *          \a delta is unspecified)
+   */
+  template <class F>
+  auto Measure(PerfSample &delta, F &&f) const -> bool {
+    auto before = PerfSample{};
+    const auto ok = Read(before);
+    f();
+    if (!ok || !Read(delta)) return false;
+
+    for (std::size_t i = 0; i < kPerfEventCount; ++i) {
+      delta[i] -= before[i];
+    }
+    return true;
+  }
+
+ private:
+  static constexpr std::array<int, kPerfEventCount> kNoFds = {-1, -1, -1, -1};
+
+  PerfCounters() = default;
+
+  static auto PageSize() noexcept -> std::size_t {
+    return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  }
+
+  auto Close() noexcept -> void {
+    for (std::size_t i = 0; i < kPerfEventCount; ++i) {
+      if (m_pages[i] != nullptr) {
+        ::munmap(const_cast<perf_event_mmap_page *>(m_pages[i]), PageSize());
+      }
+      if (m_fds[i] >= 0) ::close(m_fds[i]);
+    }
+    m_fds = kNoFds;
+    m_pages = {};
+  }
+
+  /// Read all the counters with rdpmc (see perf_event_mmap_page)
+  auto ReadRdpmc(PerfSample &out) const noexcept -> bool {
+#if defined(__x86_64__) || defined(__i386__)
+    for (std::size_t i = 0; i < kPerfEventCount; ++i) {
+      const volatile auto *const page = m_pages[i];
+      if (page == nullptr) return false;
+
+      std::uint32_t sequence = 0;
+      do {
+        sequence = page->lock;
+        std::atomic_signal_fence(std::memory_order_acq_rel);
+
+        const std::uint32_t index = page->index;
+        if ((page->cap_user_rdpmc == 0) || (index == 0)) return false;
+
+        // Sign extend the pmc_width bits counter
+        const auto shift = 64u - page->pmc_width;
+        const auto pmc = static_cast<std::int64_t>(Rdpmc(index - 1) << shift);
+        out[i] = static_cast<std::uint64_t>(page->offset + (pmc >> shift));
+
+        std::atomic_signal_fence(std::memory_order_acq_rel);
+      } while (page->lock != sequence);
+    }
+    return true;
+#else
+    static_cast<void>(out);
+    return false;
+#endif
+  }
+
+#if defined(__x86_64__) || defined(__i386__)
+  static auto Rdpmc(std::uint32_t counter) noexcept -> std::uint64_t {
+    std::uint32_t low = 0;
+    std::uint32_t high = 0;
+    asm volatile("rdpmc" : "=a"(low), "=d"(high) : "c"(counter));
+    return (std::uint64_t{high} << 32) | low;
+  }
+#endif
+
+  /// Read all the counters at once, through the group leader (syscall)
+  auto ReadGroup(PerfSample &out) const noexcept -> bool {
+    struct {
+      std::uint64_t count;
+      PerfSample values;
+    } group = {};
+
+    if ((m_fds[0] < 0) ||
+        (::read(m_fds[0], &group, sizeof(group)) !=
+         static_cast<ssize_t>(sizeof(group))) ||
+        (group.count != kPerfEventCount)) {
+      return false;
+    }
+
+    out = group.values;
+    return true;
+  }
+
+  std::array<int, kPerfEventCount> m_fds = kNoFds;
+  std::array<const perf_event_mmap_page *, kPerfEventCount> m_pages = {};
+};
+
+} // namespace lfc
@@ -0,0 +1,31 @@
+#pragma once
+
+/**
+ *  \brief USDT (user statically defined tracing) probes
+ *
+ *  LFC_PROBE(name, args...) defines the probe 'lfc:name' (e.g. attached with
+ *  bpftrace through 'usdt:<binary>:lfc:name'), with up to 12 integer or
+ *  pointer args.
+ *
+ *  Probes are compiled in when <sys/sdt.h> is available (e.g. from the
+ *  systemtap-sdt-dev package), unless LFC_DISABLE_PROBES is defined (see the
+ *  CMake option 'lfc_ENABLE_PROBES'). Detached, a probe is a single nop (the
+ *  args being left in place in registers/stack), only patched when a tracer
+ *  attaches. Otherwise, LFC_PROBE() is a no-op.
+ */
+
+#if !defined(LFC_DISABLE_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define LFC_HAS_PROBES 1
+#endif
+#endif
+
+#if defined(LFC_HAS_PROBES)
+#define LFC_PROBE(...) STAP_PROBEV(lfc, __VA_ARGS__)
+#else
+#define LFC_HAS_PROBES 0
+#define LFC_PROBE(...) \
+  do {                 \
+  } while (false)
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+
+// Internal
+#include "lfc/export.h"
+#include "lfc/ros/linear_feedback_node.hpp"
+
+// ROS
+#include "rclcpp_lifecycle/lifecycle_node.hpp"
+
+namespace lfc::ros {
+
+extern template struct BasicLinearFeedbackNode<rclcpp_lifecycle::LifecycleNode>;
+
+/**
+ *  \brief Managed (lifecycle) variant of the LinearFeedbackNode
+ *
+ *  All the setup (parameters, allocations, kernel selection and warm up) is
+ *  done when configuring, such that activating/deactivating the node only
+ *  flips an atomic flag: JointStates received while inactive are dropped.
+ *
+ *  \note The control callback group (see ControlCallbackGroup()) only exists
+ *        once configured, and must not be spun anymore when cleaning up
+ */
+struct LFC_PUBLIC LinearFeedbackLifecycleNode
+    : public BasicLinearFeedbackNode<rclcpp_lifecycle::LifecycleNode> {
+  using CallbackReturn = rclcpp_lifecycle::node_interfaces::
+      LifecycleNodeInterface::CallbackReturn;
+
+  /// Default construct the node (name: "linear_feedback", ns: "")
+  LinearFeedbackLifecycleNode();
+
+  /// Construct the node with the specified node \arg options
+  LinearFeedbackLifecycleNode(const rclcpp::NodeOptions &options);
+
+  /// Declare the parameters, allocate, select the kernel and warm up
+  auto on_configure(const rclcpp_lifecycle::State &state)
+      -> CallbackReturn override;
+
+  /// Start solving the JointStates received
+  auto on_activate(const rclcpp_lifecycle::State &state)
+      -> CallbackReturn override;
+
+  /// Stop solving the JointStates received
+  auto on_deactivate(const rclcpp_lifecycle::State &state)
+      -> CallbackReturn override;
+
+  /// Release everything allocated by on_configure()
+  auto on_cleanup(const rclcpp_lifecycle::State &state)
+      -> CallbackReturn override;
+
+  /// Stop solving and release everything allocated by on_configure()
+  auto on_shutdown(const rclcpp_lifecycle::State &state)
+      -> CallbackReturn override;
+};
+
+} // namespace lfc::ros
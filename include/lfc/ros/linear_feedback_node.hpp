@@ -1,33 +1,220 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
 
 // Internal
 #include "lfc/export.h"
+#include "lfc/ros/realtime.hpp"
 
 // ROS
+#include "diagnostic_msgs/msg/diagnostic_array.hpp"
 #include "rclcpp/node.hpp"
 #include "sensor_msgs/msg/joint_state.hpp"
+#include "std_msgs/msg/float64_multi_array.hpp"
+#include "std_srvs/srv/trigger.hpp"
 
 namespace lfc::ros {
 
 /// PIMPL used by the LinearFeedbackNode. Contains internal impl details.
 struct LFC_PRIVATE LinearFeedbackNodeImpl;
 
-struct LFC_PUBLIC LinearFeedbackNode : public rclcpp::Node {
-  /// Default construct the node (name: "linear_feedback", ns: "")
-  LinearFeedbackNode();
+/// How the control path (JointState -> command) is driven
+enum class ControlLoop {
+  kExecutor, /*!< Subscription callback, spun by an rclcpp executor */
+  kWaitSet,  /*!< Inline take/solve/publish loop, see SpinWaitSet() */
+  kShm,      /*!< Shared memory states/commands loop, see SpinShm() */
+};
 
-  /// Construct the node with the specified node \arg options
-  LinearFeedbackNode(const rclcpp::NodeOptions &options);
+constexpr auto ToString(ControlLoop loop) noexcept -> std::string_view {
+  switch (loop) {
+    case ControlLoop::kExecutor: return "executor";
+    case ControlLoop::kWaitSet: return "wait_set";
+    case ControlLoop::kShm: return "shm";
+  }
+
+  return "";
+}
+
+/// Settings of the control path (see 'control/*' parameters)
+struct ControlConfig {
+  ControlLoop loop = ControlLoop::kExecutor;
+  bool busy_poll = false; /*!< kWaitSet/kShm: poll without ever sleeping */
+  double rate = 0.;       /*!< kExecutor only: fixed rate (Hz), 0 = event */
+  bool pipeline = false;  /*!< Solve on a separate thread (see SpinSolver) */
+  std::vector<int> pipeline_cpus = {}; /*!< CPUs the solver is pinned to */
+  std::string shm_name = "/lfc-transport"; /*!< kShm only: ShmTransport */
+  std::size_t shm_capacity = 8; /*!< kShm only: slots per ring */
+};
+
+/**
+ *  \brief Node computing Y = offset + gains * X from the JointState X
+ *
+ *  Everything (parameters, allocations, kernel selection, publishers,
+ *  subscribers, ...) is set up by Configure(), the control path only
+ *  solving while active (see SetActive()).
+ *
+ *  \tparam NodeBase Either rclcpp::Node or rclcpp_lifecycle::LifecycleNode
+ *          (see LinearFeedbackNode and LinearFeedbackLifecycleNode)
+ */
+template <class NodeBase>
+struct LFC_PUBLIC BasicLinearFeedbackNode : public NodeBase {
+  /// Construct the node (name: "linear_feedback", ns: ""), NOT configured
+  BasicLinearFeedbackNode(const rclcpp::NodeOptions &options);
 
   /// Destruct the node and free allocated memory
-  virtual ~LinearFeedbackNode() noexcept;
+  virtual ~BasicLinearFeedbackNode() noexcept;
+
+  /**
+   *  \return The callback group of the control path (JointState -> command)
+   *
+   *  \note When 'realtime/enabled' is set, or when the control loop is
+   *        kWaitSet, this group is NOT added automatically to the executors
+   *        the node is added to, and must be spun explicitly (see
+   *        RealtimeSettings() and SpinWaitSet())
+   */
+  auto ControlCallbackGroup() const -> rclcpp::CallbackGroup::SharedPtr;
+
+  /// \return The real-time settings declared through 'realtime/*' parameters
+  auto RealtimeSettings() const -> const RealtimeConfig &;
+
+  /// \return The control path settings declared through 'control/*' params
+  auto ControlSettings() const -> const ControlConfig &;
+
+  /**
+   *  \brief Drive the control subscription directly, without any executor
+   *
+   *  Takes, solves and publishes inline, on the calling thread, until
+   *  rclcpp::ok() returns false. When 'control/busy_poll' is set, the
+   *  subscription is polled continuously, without ever sleeping. Otherwise,
+   *  a single-subscription rclcpp::StaticWaitSet is used to wait for data.
+   *
+   *  \pre ControlSettings().loop is ControlLoop::kWaitSet
+   */
+  auto SpinWaitSet() -> void;
+
+  /**
+   *  \brief Drive the control path from the shared memory transport of a
+   *         co-located driver (see ShmTransport), without any ROS message
+   *
+   *  Waits for the states pushed by the driver, solving the newest one (the
+   *  older ones being dropped) into a command pushed back to the driver, on
+   *  the calling thread, until rclcpp::ok() returns false. When
+   *  'control/busy_poll' is set, the states are polled continuously, without
+   *  ever sleeping. Otherwise, the driver wakes this thread up (futex).
+   *
+   *  \pre ControlSettings().loop is ControlLoop::kShm
+   */
+  auto SpinShm() -> void;
+
+ protected:
+  /**
+   *  \brief Declare the parameters, allocate everything, select the gains
+   *         kernel, create the publishers/subscribers/threads and warm up the
+   *         control path (dummy solves)
+   *
+   *  \throw rclcpp::exceptions::InvalidParametersException On invalid params
+   */
+  auto Configure() -> void;
+
+  /**
+   *  \brief Undo Configure() (the parameters stay declared)
+   *
+   *  \pre No control callback is running (i.e. the node is inactive and its
+   *       control callback group isn't spun anymore)
+   */
+  auto Cleanup() -> void;
+
+  /// Start (or stop) solving the JointStates received (wait free)
+  auto SetActive(bool active) noexcept -> void;
 
  private:
+  // The control path accepts either a JointState, or a serialized JointState
+  // (rclcpp::SerializedMessage) when 'state/serialized' is set
+
+  /// Gather, solve and publish the command associated to \a joint_state
+  template <class JointStateMsg>
+  auto OnJointState(const JointStateMsg &joint_state) -> void;
+
+  /// Fixed rate only: gather \a joint_state as the newest state available
+  template <class JointStateMsg>
+  auto StoreJointState(const JointStateMsg &joint_state) -> void;
+
+  /// Fixed rate only: solve and publish the newest state available
+  auto OnControlTick() -> void;
+
+  /// Fusion only: gather the \a fields of \a msg as the newest values of
+  /// the state \a source (see 'state/sources')
+  template <class SourceMsg, class Field>
+  auto StoreSourceState(std::size_t source, const SourceMsg &msg,
+                        const std::vector<Field> &fields) -> void;
+
+  /// Batch only: gather \a joint_state as the newest state of \a stream
+  template <class JointStateMsg>
+  auto StoreBatchState(std::size_t stream, const JointStateMsg &joint_state)
+      -> void;
+
+  /// Batch only: solve all the newest states at once, and publish them
+  auto OnBatchTick() -> void;
+
+  /// Pipeline only: gather \a joint_state into the next free pipeline slot
+  template <class JointStateMsg>
+  auto PushJointState(const JointStateMsg &joint_state) -> void;
+
+  /// Pipeline only: solve and publish the gathered states until stopped
+  auto SpinSolver() -> void;
+
   std::unique_ptr<LinearFeedbackNodeImpl> m_impl; /*!< PIMPL */
+  rclcpp::CallbackGroup::SharedPtr m_control_group;
   rclcpp::Subscription<sensor_msgs::msg::JointState>::SharedPtr m_input;
-  // rclcpp::Publisher<int> m_output;
+  rclcpp::Publisher<sensor_msgs::msg::JointState>::SharedPtr m_output;
+  rclcpp::TimerBase::SharedPtr m_timer; /*!< Fixed rate (or batch) only */
+
+  /// Batch only (see 'batch/*'): one subscription/publisher per stream,
+  /// replacing m_input/m_output
+  std::vector<rclcpp::Subscription<sensor_msgs::msg::JointState>::SharedPtr>
+      m_batch_inputs;
+  std::vector<rclcpp::Publisher<sensor_msgs::msg::JointState>::SharedPtr>
+      m_batch_outputs;
+
+  /// Fusion only (see 'state/sources'): one subscription per state source,
+  /// alongside m_input
+  std::vector<rclcpp::SubscriptionBase::SharedPtr> m_source_inputs;
+
+  /// Streamed gains only (see 'gains/stream/enabled')
+  rclcpp::Subscription<std_msgs::msg::Float64MultiArray>::SharedPtr
+      m_gains_input;
+
+  /// Live updates of the gains/offset values
+  rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr
+      m_on_set_model;
+
+  /// Control path latencies (see 'diagnostics/*'), published periodically
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr
+      m_diagnostics_output;
+  rclcpp::TimerBase::SharedPtr m_diagnostics_timer;
+
+  /// Decimated copy of the commands (see 'debug/*'), published periodically
+  rclcpp::Publisher<sensor_msgs::msg::JointState>::SharedPtr m_debug_output;
+  rclcpp::TimerBase::SharedPtr m_debug_timer;
+
+  /// Dump of the flight recorder (see 'flight_recorder/*'), on demand
+  rclcpp::Service<std_srvs::srv::Trigger>::SharedPtr m_dump_flight;
+};
+
+extern template struct BasicLinearFeedbackNode<rclcpp::Node>;
+
+/// Node configured and active as soon as constructed
+struct LFC_PUBLIC LinearFeedbackNode
+    : public BasicLinearFeedbackNode<rclcpp::Node> {
+  /// Default construct the node (name: "linear_feedback", ns: "")
+  LinearFeedbackNode();
+
+  /// Construct the node with the specified node \arg options
+  LinearFeedbackNode(const rclcpp::NodeOptions &options);
 };
 
 } // namespace lfc::ros
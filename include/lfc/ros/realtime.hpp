@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Internal
+#include "lfc/export.h"
+
+// ROS
+#include "rclcpp/logger.hpp"
+
+namespace lfc::ros {
+
+/// Settings of the real-time control thread (see 'realtime/*' parameters)
+struct RealtimeConfig {
+  bool enabled = false;          /*!< Run the control group on its own thread */
+  int priority = 80;             /*!< SCHED_FIFO priority, in [1, 99] */
+  std::vector<int> cpus = {};    /*!< CPU affinity (empty: no pinning) */
+  bool lock_memory = true;       /*!< Call mlockall() when configuring */
+  std::size_t stack_bytes = 0;   /*!< Stack prefaulted by the control thread */
+  std::size_t heap_bytes = 0;    /*!< Heap prefaulted when configuring */
+};
+
+/**
+ *  \brief Lock all current and future pages of the process in RAM
+ *
+ *  Also tells the allocator to never give memory back to the system, so that
+ *  prefaulted heap pages stay mapped (and locked) once freed.
+ *
+ *  \return 0 on success, the errno value of mlockall() otherwise
+ */
+LFC_PUBLIC auto LockProcessMemory() noexcept -> int;
+
+/**
+ *  \brief Fault in \a bytes of heap, then release them to the allocator
+ *
+ *  \return 0 on success, ENOMEM if the memory couldn't be allocated
+ */
+LFC_PUBLIC auto PrefaultHeap(std::size_t bytes) noexcept -> int;
+
+/**
+ *  \brief Fault in \a bytes of the CALLING thread stack
+ *
+ *  \pre bytes is lower than the thread stack size
+ */
+LFC_PUBLIC auto PrefaultStack(std::size_t bytes) noexcept -> void;
+
+/**
+ *  \brief Set the CALLING thread scheduling policy to SCHED_FIFO
+ *
+ *  \param[in] priority The SCHED_FIFO priority, in [1, 99]
+ *
+ *  \return 0 on success, the errno value of pthread_setschedparam() otherwise
+ *          (EPERM when lacking CAP_SYS_NICE / rtprio limits)
+ */
+LFC_PUBLIC auto SetThreadFifoPriority(int priority) noexcept -> int;
+
+/**
+ *  \brief Pin the CALLING thread to the given \a cpus
+ *
+ *  \return 0 on success, the errno value of pthread_setaffinity_np() otherwise
+ */
+LFC_PUBLIC auto SetThreadAffinity(const std::vector<int> &cpus) noexcept
+    -> int;
+
+/**
+ *  \brief Log the outcome of the real-time \a setting, whose \a error is an
+ *         errno value (0 on success)
+ *
+ *  Every real-time setting is best effort: a failure is only a warning.
+ */
+LFC_PUBLIC auto ReportRealtime(const rclcpp::Logger &logger,
+                               const char *setting, int error) -> void;
+
+} // namespace lfc::ros
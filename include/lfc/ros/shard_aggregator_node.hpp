@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+// Internal
+#include "lfc/export.h"
+#include "lfc/shard_assembler.hpp"
+
+// ROS
+#include "rclcpp/node.hpp"
+#include "sensor_msgs/msg/joint_state.hpp"
+
+namespace lfc::ros {
+
+/**
+ *  \brief Node assembling the whole command of a row partitioned model from
+ *         the partial commands of its shards (LinearFeedbackNodes with
+ *         'shard/rows_begin|end' set), see ShardAssembler
+ *
+ *  Subscribes to the partial commands of every shard ('shards/inputs'), and
+ *  publishes each command on 'command' as soon as all of its rows are
+ *  received, stamped as the state solved. Commands are never published
+ *  backwards in time: the incomplete ones overtaken by a newer one are
+ *  dropped.
+ */
+struct LFC_PUBLIC ShardAggregatorNode : public rclcpp::Node {
+  /// Default construct the node (name: "lfc_aggregator", ns: "")
+  ShardAggregatorNode();
+
+  /**
+   *  \brief Construct the node with the specified node \arg options
+   *
+   *  \throw rclcpp::exceptions::InvalidParametersException On invalid params
+   */
+  ShardAggregatorNode(const rclcpp::NodeOptions &options);
+
+ private:
+  /// Add the rows of \a partial, publishing the command once complete
+  auto OnPartialCommand(const sensor_msgs::msg::JointState &partial) -> void;
+
+  std::unique_ptr<ShardAssembler> m_assembler;
+  sensor_msgs::msg::JointState m_command; /*!< Preallocated Y (as effort) */
+
+  std::vector<rclcpp::Subscription<sensor_msgs::msg::JointState>::SharedPtr>
+      m_inputs;
+  rclcpp::Publisher<sensor_msgs::msg::JointState>::SharedPtr m_output;
+};
+
+} // namespace lfc::ros
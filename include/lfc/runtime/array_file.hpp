@@ -0,0 +1,41 @@
+#pragma once
+
+// SYSTEM
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// INTERNAL
+#include "lfc/export.h"
+
+namespace lfc {
+
+/// Array of doubles, read-only memory mapped from a file (see MapArrayFile())
+struct ArrayFile {
+  std::shared_ptr<const void> mapping = nullptr; /*!< Keeps data alive */
+  const double *data = nullptr;
+  std::size_t size = 0; /*!< Number of values */
+
+  std::vector<std::size_t> shape = {}; /*!< .npy only, {size} otherwise */
+  bool fortran_order = false; /*!< .npy only: values are column major */
+};
+
+/**
+ *  \brief Memory map the array of doubles stored in the file \a path
+ *
+ *  Files ending with '.npy' are NumPy arrays (versions 1.0 to 3.0), whose
+ *  header is validated: they must hold little endian float64 ('<f8') values.
+ *  Any other file is considered as raw little endian float64 values.
+ *
+ *  Nothing is copied: the values are read in place, from the mapping.
+ *
+ *  \param[out] reason Reason of the failure, if any
+ *
+ *  \return The mapped array, std::nullopt on failure
+ */
+LFC_PUBLIC auto MapArrayFile(const std::string &path, std::string &reason)
+    -> std::optional<ArrayFile>;
+
+} // namespace lfc
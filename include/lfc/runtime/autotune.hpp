@@ -0,0 +1,79 @@
+#pragma once
+
+// SYSTEM
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+// INTERNAL
+#include "lfc/export.h"
+#include "lfc/runtime/gains.hpp"
+
+namespace lfc {
+
+/// Time taken by a kernel to solve a model
+struct KernelTiming {
+  GainsKernel kernel = GainsKernel::kColMajor;
+  double ns_per_solve = 0.;
+};
+
+/**
+ *  \brief Time each kernel applicable to \a gains, by solving the actual
+ *         model (\a gains, \a offset) repeatedly
+ *
+ *  The \a budget is evenly split between the applicable kernels.
+ *
+ *  \return The timings of the applicable kernels, fastest first
+ */
+LFC_PUBLIC auto TimeGainsKernels(const gains_t &gains,
+                                 const offset_t &offset,
+                                 std::chrono::nanoseconds budget)
+    -> std::vector<KernelTiming>;
+
+/// \return The model name of the CPU (from /proc/cpuinfo), "unknown" if none
+LFC_PUBLIC auto CpuModelName() -> std::string;
+
+/// \return The key of the autotuning of a \a rows x \a cols model, on this CPU
+LFC_PUBLIC auto AutotuneKey(Eigen::Index rows, Eigen::Index cols)
+    -> std::string;
+
+/**
+ *  \return The kernel stored under \a key in the autotuning cache file
+ *          \a path, std::nullopt when there is none (or no such file)
+ */
+LFC_PUBLIC auto ReadCachedKernel(const std::string &path,
+                                 const std::string &key)
+    -> std::optional<GainsKernel>;
+
+/**
+ *  \brief Store \a kernel under \a key in the autotuning cache file \a path,
+ *         replacing the previous one (the file is created if needed)
+ *
+ *  \return False when the file couldn't be written
+ */
+LFC_PUBLIC auto WriteCachedKernel(const std::string &path,
+                                  const std::string &key, GainsKernel kernel)
+    -> bool;
+
+/// Outcome of AutotuneKernel()
+struct Autotuning {
+  GainsKernel kernel = GainsKernel::kColMajor; /*!< The fastest one */
+  bool cached = false; /*!< Read from the cache, not timed */
+  std::vector<KernelTiming> timings = {}; /*!< Timed only, fastest first */
+  bool cache_failed = false; /*!< Timed only: the cache couldn't be written */
+};
+
+/**
+ *  \brief Pick the kernel solving the model (\a gains, \a offset) the
+ *         fastest, timed within \a budget (see TimeGainsKernels()), or read
+ *         from the \a cache file (if any) when this model shape has already
+ *         been tuned on this CPU
+ *
+ *  The kernel timed is stored into the \a cache file (if any).
+ */
+LFC_PUBLIC auto AutotuneKernel(const gains_t &gains, const offset_t &offset,
+                               std::chrono::nanoseconds budget,
+                               const std::string &cache) -> Autotuning;
+
+} // namespace lfc
@@ -0,0 +1,106 @@
+#pragma once
+
+// SYSTEM
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// INTERNAL
+#include "lfc/export.h"
+
+namespace lfc {
+
+/**
+ *  \brief Plain configuration of a ControlStep (see ControlStep::Create()),
+ *         mirroring the parameters of the lfc node (same names, same
+ *         defaults), without any ROS dependency
+ */
+struct RuntimeConfig {
+  /// 'gains/shape/rows|cols': < 0 to use the .npy 'gains/file' shape
+  std::int64_t gains_rows = -1;
+  std::int64_t gains_cols = -1;
+  std::string gains_file = {}; /*!< 'gains/file': over 'gains/values' */
+  std::vector<double> gains_values = {}; /*!< 'gains/values': ZERO if empty */
+  std::string gains_storage_order = "row_major"; /*!< Of 'gains/values' */
+
+  /// 'offset/*': sized as the gains rows
+  std::string offset_file = {};
+  std::vector<double> offset_values = {}; /*!< ZERO if empty */
+
+  /// 'shard/rows_begin|end': rows of the gains/offset solved, all of them
+  /// with [0, -1)
+  std::int64_t shard_rows_begin = 0;
+  std::int64_t shard_rows_end = -1;
+
+  /// 'trajectory/*' (see LinearModelTrajectory): models replacing the
+  /// gains/offset ones when set, their gains stored as 'gains/storage_order'
+  std::string trajectory_file = {}; /*!< Over 'trajectory/values' */
+  std::vector<double> trajectory_values = {};
+  double trajectory_start = 0.; /*!< <= 0: time of the first step solved */
+  double trajectory_period = 0.;
+  std::string trajectory_interpolation = "hold";
+
+  /// 'batch/*' (see ControlStep::StepBatch()): states solved together, one
+  /// per stream ('batch/streams' in a file, the node counting its
+  /// 'batch/inputs')
+  std::int64_t batch_streams = 0;
+  std::vector<double> batch_offsets = {}; /*!< ROWS per stream, or none */
+
+  /// 'command/on_change/*' (see ChangeFilter)
+  bool on_change = false;
+  double on_change_epsilon = 0.;
+  double on_change_keep_alive = 0.1; /*!< Seconds, 0 means never */
+
+  /// 'model/*': gains kernel, 'auto' to time them (see AutotuneKernel())
+  std::string kernel = "auto";
+  std::int64_t autotune_budget_ms = 100;
+  std::string autotune_cache = {};
+
+  /// 'diagnostics/*' (see ControlPathStats)
+  double deadline = 0.;  /*!< Seconds, 0 means no deadline */
+  std::string shm = {};  /*!< Stats shared through this shm, if not empty */
+  bool perf = false;     /*!< Count the hardware events of each solve */
+
+  /// 'flight_recorder/*' (see FlightRecorder)
+  std::int64_t flight_records = 10000; /*!< 0 disables it */
+  std::string flight_path = {}; /*!< Empty: see FlightPathOf() */
+  bool flight_dump_on_fault = true;
+};
+
+/**
+ *  \return The file the flight recorder of \a config is dumped to: its
+ *          'flight_recorder/path', '/tmp/lfc-flight-<pid>.bin' when empty
+ *          (such that controllers never replace the dumps of each other)
+ */
+LFC_PUBLIC auto FlightPathOf(const RuntimeConfig &config) -> std::string;
+
+/**
+ *  \brief Update \a config with the \a text settings, one 'key: value' per
+ *         line, keys being the node parameters names (e.g. 'gains/file')
+ *
+ *  This is a flat subset of YAML: '#' starts a comment, strings may be
+ *  quoted, booleans are 'true' or 'false', and lists of numbers are written
+ *  '[a, b, ...]' (possibly spanning several lines).
+ *
+ *  \param[out] reason Reason of the failure (e.g. unknown key), if any
+ *
+ *  \return False on failure (\a config being partially updated)
+ */
+LFC_PUBLIC auto ParseRuntimeConfig(std::string_view text,
+                                   RuntimeConfig &config, std::string &reason)
+    -> bool;
+
+/**
+ *  \brief Load the RuntimeConfig of the file \a path (see
+ *         ParseRuntimeConfig()), unset keys keeping their default
+ *
+ *  \param[out] reason Reason of the failure, if any
+ *
+ *  \return The config, std::nullopt on failure
+ */
+LFC_PUBLIC auto LoadRuntimeConfig(const std::string &path, std::string &reason)
+    -> std::optional<RuntimeConfig>;
+
+} // namespace lfc
@@ -0,0 +1,108 @@
+#pragma once
+
+// SYSTEM
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+
+// INTERNAL
+#include "lfc/perf_counters.hpp"
+#include "lfc/stats_page.hpp"
+
+namespace lfc {
+
+/**
+ *  \brief Latencies (ns) and counters of the control path steps (state ->
+ *         command), recorded into a StatsPage
+ *
+ *  Recorded by the single thread solving the commands (see Record()), wait
+ *  free, without allocating nor any syscall, and read concurrently by any
+ *  other thread (e.g. the node diagnostics), or process when the page is
+ *  shared (see CreateSharedStatsPage() and lfc-top).
+ */
+struct ControlPathStats {
+  using clock = std::chrono::steady_clock;
+
+  /// Where everything is recorded: private, unless shared (see Share())
+  std::shared_ptr<StatsPage> page = std::make_shared<StatsPage>();
+  clock::duration deadline = clock::duration::zero(); /*!< 0: no deadline */
+
+  /// Record into \a shared from now on (counters are carried over)
+  auto Share(std::shared_ptr<StatsPage> shared) -> void {
+    page = std::move(shared);
+    page->counters.Store(m_counters);
+  }
+
+  /// WRITER: Set the name of the gains \a kernel used by the control path
+  auto SetKernel(std::string_view kernel) noexcept -> void {
+    const auto size = std::min(kernel.size(), m_counters.kernel.size() - 1);
+    std::fill(m_counters.kernel.begin(), m_counters.kernel.end(), '\0');
+    std::copy_n(kernel.begin(), size, m_counters.kernel.begin());
+    page->counters.Store(m_counters);
+  }
+
+  /// ANY THREAD: Count a state dropped
+  auto Drop() noexcept -> void {
+    page->dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /// WRITER: Record the hardware events counted during a solve
+  auto RecordPerf(const PerfSample &sample) noexcept -> void {
+    for (std::size_t i = 0; i < kPerfEventCount; ++i) {
+      page->perf[i].Record(sample[i]);
+    }
+  }
+
+  /**
+   *  \brief WRITER: Record a control step, given the time points (steady
+   *         clock) of its state receipt, solve and publication, the state
+   *         \a stamp_ns (system clock) and the \a model_version solved
+   *
+   *  The end to end latency compares the system clock with the \a stamp_ns,
+   *  and is only recorded when the stamp is in the past (i.e. expected to
+   *  come from the same, synchronized, clock).
+   */
+  auto Record(clock::time_point received, clock::time_point solve_begin,
+              clock::time_point solve_end, clock::time_point published,
+              std::int64_t stamp_ns, std::uint64_t model_version) noexcept
+      -> void {
+    auto &stats = *page;
+    stats.receive_to_solve.Record(Ns(solve_begin - received));
+    stats.solve.Record(Ns(solve_end - solve_begin));
+    stats.solve_to_publish.Record(Ns(published - solve_end));
+
+    const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+    if ((stamp_ns > 0) && (now >= stamp_ns)) {
+      stats.end_to_end.Record(static_cast<std::uint64_t>(now - stamp_ns));
+    }
+
+    m_counters.ticks += 1;
+    if ((deadline > clock::duration::zero()) &&
+        ((published - received) > deadline)) {
+      m_counters.deadline_misses += 1;
+    }
+    m_counters.model_version = model_version;
+    m_counters.last_tick_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            published.time_since_epoch())
+            .count();
+    stats.counters.Store(m_counters);
+  }
+
+ private:
+  static auto Ns(clock::duration duration) noexcept -> std::uint64_t {
+    const auto ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    return (ns > 0) ? static_cast<std::uint64_t>(ns) : 0;
+  }
+
+  StatsCounters m_counters = {}; /*!< WRITER: copy of page->counters */
+};
+
+} // namespace lfc
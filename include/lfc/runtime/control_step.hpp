@@ -0,0 +1,540 @@
+#pragma once
+
+// SYSTEM
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// INTERNAL
+#include "lfc/change_filter.hpp"
+#include "lfc/export.h"
+#include "lfc/flight_recorder.hpp"
+#include "lfc/linear_model.hpp"
+#include "lfc/linear_model_trajectory.hpp"
+#include "lfc/lockfree/mailbox.hpp"
+#include "lfc/perf_counters.hpp"
+#include "lfc/probes.h"
+#include "lfc/runtime/autotune.hpp"
+#include "lfc/runtime/config.hpp"
+#include "lfc/runtime/control_path_stats.hpp"
+#include "lfc/runtime/gains.hpp"
+#include "lfc/runtime/model.hpp"
+
+// EXT
+// -- Eigen
+#include "Eigen/Core"
+
+namespace lfc {
+
+/**
+ *  \brief Preallocated control step Y = offset + gains * X, without ROS:
+ *         everything the control path needs, from the model updates to the
+ *         stats and the flight recorder
+ *
+ *  Threads:
+ *  - ONE control thread: State(), Step() (or FetchModel(), SolveInto() and
+ *    Record()), BatchState() and StepBatch(), never allocating nor waiting;
+ *  - ONE model writer (e.g. the parameters callback): Reset() (only while
+ *    the control thread is stopped), PostPatches() and PostModel();
+ *  - any thread: Stats() readers, PerfError().
+ *
+ *  Typical usage, from the cyclic thread of a fieldbus master:
+ *  \code
+ *  auto reason = std::string{};
+ *  const auto config = LoadRuntimeConfig("lfc.yaml", reason);
+ *  auto step = config ? ControlStep::Create(*config, reason) : nullptr;
+ *
+ *  // Each cycle
+ *  ReadInputs(step->State());
+ *  WriteOutputs(step->Step(now_ns));
+ *  \endcode
+ */
+class ControlStep {
+ public:
+  using clock = ControlPathStats::clock;
+  using input_t = Eigen::VectorXd;
+  using output_t = Eigen::VectorXd;
+
+  /// When (and what) a control step solves, see Step()
+  struct Stamps {
+    clock::time_point received = {}; /*!< When its state X was received */
+    std::int64_t stamp_ns = 0;       /*!< Stamp of X (system clock) */
+    double time = 0.; /*!< Trajectory only: time (s) picking its model */
+    const void *probe = nullptr; /*!< arg0 of its probes (e.g. X) */
+  };
+
+  /// Empty (0x0) model, see Reset()
+  ControlStep() = default;
+  ControlStep(const ControlStep &) = delete;
+  ControlStep &operator=(const ControlStep &) = delete;
+
+  /**
+   *  \brief Create the control step described by \a config: load the model
+   *         (or the rows of its shard) or its trajectory, pick its kernel,
+   *         and set up the batch, the publish-on-change filter, the stats
+   *         (deadline, shm, perf) and the flight recorder (dumped on fault,
+   *         if set)
+   *
+   *  \param[out] reason Reason of the failure, if any
+   *
+   *  \return The control step, nullptr on failure
+   */
+  LFC_PUBLIC static auto Create(const RuntimeConfig &config,
+                                std::string &reason)
+      -> std::unique_ptr<ControlStep>;
+
+  /**
+   *  \brief MODEL WRITER: Replace the model by (\a gains, \a offset), solved
+   *         with \a kernel, resizing State() and Command() (and the batch
+   *         ones, keeping their streams)
+   *
+   *  \warning Allocates, and must not run concurrently with the control
+   *           thread
+   *  \pre Gains::IsApplicable(kernel, gains), offset.size() == gains.rows()
+   *  \pre Same shapes as the trajectory and the batch offsets, if any
+   */
+  LFC_PUBLIC auto Reset(const gains_t &gains, const offset_t &offset,
+                        GainsKernel kernel) -> void;
+
+  /// \return The kernel solving the model (see Reset())
+  auto Kernel() const noexcept -> GainsKernel { return m_kernel; }
+
+  /// \return How Create() picked the kernel, std::nullopt when not 'auto'
+  auto Tuning() const noexcept -> const std::optional<Autotuning> & {
+    return m_tuning;
+  }
+
+  /// \return The number of Y values
+  auto Rows() const noexcept -> Eigen::Index { return m_posted.gains.Rows(); }
+
+  /// \return The number of X values
+  auto Cols() const noexcept -> Eigen::Index { return m_posted.gains.Cols(); }
+
+  /// MODEL WRITER: \return The last model posted (dense gains)
+  auto Posted() const noexcept -> const Model & { return m_posted; }
+
+  /// \return The trajectory of models solved instead of the model, nullptr
+  ///         when not set (see 'trajectory/*')
+  auto Trajectory() const noexcept -> const LinearModelTrajectory<double> * {
+    return m_trajectory.has_value() ? &(*m_trajectory) : nullptr;
+  }
+
+  /// \return The filter of the commands published on change, nullptr when
+  ///         not enabled (see 'command/on_change/*')
+  auto OnChange() const noexcept -> const ChangeFilter * {
+    return m_on_change.has_value() ? &(*m_on_change) : nullptr;
+  }
+
+  /**
+   *  \brief MODEL WRITER: Apply the \a pending patches (versioned by this
+   *         call) to the model, and post it to the control thread
+   *
+   *  The new model is built into the spare buffer of the mailbox, brought up
+   *  to date by replaying the last patches posted (a full update when
+   *  \a full_update is set, invalidating them), such that a patch costs
+   *  proportionally to its size, not to the model one. The control thread
+   *  never waits on it.
+   *
+   *  \pre The \a pending patches fit within the model
+   */
+  LFC_PUBLIC auto PostPatches(std::vector<ModelPatch> &pending,
+                              bool full_update) -> void;
+
+  /**
+   *  \brief MODEL WRITER: Replace all the \a gains (and the \a offset, when
+   *         not nullptr), and post the model to the control thread
+   *
+   *  \pre Same shapes as the current model
+   */
+  template <class Values>
+  auto PostModel(const Eigen::MatrixBase<Values> &gains,
+                 const offset_t *offset = nullptr) -> void {
+    m_posted.gains.Assign(gains);
+    if (offset != nullptr) m_posted.offset = *offset;
+
+    // Full update: no need to catch up the spare buffer, and all the previous
+    // patches are invalidated
+    auto &next = m_model.Back();
+    next.gains.Assign(gains);
+    next.offset = m_posted.offset;
+    next.version = ++m_posted.version;
+    m_patches.clear();
+
+    m_model.Post();
+    LFC_PROBE(model_post, m_posted.version);
+  }
+
+  /**
+   *  \brief CONTROL THREAD: Pick up the newest model posted, if any (probe
+   *         'lfc:model_swap', arg0: version)
+   *
+   *  \return The version of the model solved (0 with a trajectory)
+   */
+  auto FetchModel() noexcept -> std::uint64_t {
+    if (m_trajectory.has_value()) return 0;
+    if (m_model.Fetch()) {
+      LFC_PROBE(model_swap, m_model.Front().version);
+    }
+    return m_model.Front().version;
+  }
+
+  /// CONTROL THREAD: \return The model fetched (see FetchModel())
+  auto Current() const noexcept -> const Model & { return m_model.Front(); }
+
+  /**
+   *  \brief CONTROL THREAD: Call \a solve, counting its hardware events when
+   *         enabled (see EnablePerf())
+   *
+   *  The counters are opened by the control thread, on its first call.
+   */
+  template <class F>
+  auto Measure(F &&solve) -> void {
+    if (m_perf_state.load(std::memory_order_relaxed) == PerfState::kPending) {
+      OpenPerfCounters();
+    }
+
+    if (!m_perf.has_value()) {
+      solve();
+    } else if (m_perf->Measure(m_perf_sample, solve)) {
+      m_stats.RecordPerf(m_perf_sample);
+    }
+  }
+
+  /**
+   *  \brief CONTROL THREAD: Solve the model fetched (or the model of the
+   *         trajectory active at \a time, in s) into \a y (see Measure())
+   *
+   *  The trajectory starts at the first \a time solved, unless its start
+   *  is set (see 'trajectory/start').
+   */
+  template <class X, class Y>
+  auto SolveInto(const X &x, Y &y, double time = 0.) -> void {
+    Measure([&]() {
+      if (m_trajectory.has_value()) {
+        SolveTrajectoryInto(x, y, time);
+      } else {
+        const auto &current = Current();
+        current.gains.SolveInto(current.offset, x, y);
+      }
+    });
+  }
+
+  /// CONTROL THREAD: Solve the model fetched for the batch of states \a x
+  /// (one per column) into \a y (see Gains::SolveBatchInto() and Measure())
+  template <class X, class Y>
+  auto SolveBatchInto(const X &x, Y &y) -> void {
+    Measure([&]() {
+      const auto &current = Current();
+      current.gains.SolveBatchInto(current.offset, x, y);
+    });
+  }
+
+  /**
+   *  \brief CONTROL THREAD: Record a control step (see
+   *         ControlPathStats::Record()) and, when enabled, its \a x and \a y
+   *         into the flight recorder
+   */
+  auto Record(clock::time_point received, clock::time_point solve_begin,
+              clock::time_point solve_end, clock::time_point published,
+              std::int64_t stamp_ns, std::uint64_t model_version,
+              const double *x, const double *y) noexcept -> void {
+    m_stats.Record(received, solve_begin, solve_end, published, stamp_ns,
+                   model_version);
+
+    if (m_recorder.has_value()) {
+      m_recorder->Record(model_version,
+                         std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             published.time_since_epoch())
+                             .count(),
+                         stamp_ns, x, y);
+    }
+  }
+
+  /// CONTROL THREAD: \return The preallocated state X, solved by Step()
+  auto State() noexcept -> input_t & { return m_state; }
+
+  /// \return The preallocated command Y, solved by Step()
+  auto Command() const noexcept -> const output_t & { return m_command; }
+
+  /**
+   *  \brief CONTROL THREAD: Solve \a x into \a y with the newest model (see
+   *         SolveInto()), hand it to \a publish and record this step
+   *
+   *  \a publish(changed) is always called, \a changed being false when the
+   *  command is suppressed as unchanged (see OnChange()): it must then not be
+   *  published, but may be used otherwise (e.g. debug copies).
+   *
+   *  Probes (arg0 being \a stamps.probe): 'lfc:solve_start' and
+   *  'lfc:solve_end' (arg1: model version)
+   */
+  template <class X, class Y, class Publish>
+  auto Step(const X &x, Y &y, const Stamps &stamps, Publish &&publish)
+      -> void {
+    const auto version = FetchModel();
+
+    const auto solve_begin = clock::now();
+    LFC_PROBE(solve_start, stamps.probe, version);
+    SolveInto(x, y, stamps.time);
+    LFC_PROBE(solve_end, stamps.probe, version);
+    const auto solve_end = clock::now();
+
+    publish(!m_on_change.has_value() ||
+            m_on_change->ShouldPublish(y.data(), solve_end));
+    const auto published = clock::now();
+    Record(stamps.received, solve_begin, solve_end, published, stamps.stamp_ns,
+           version, x.data(), y.data());
+  }
+
+  /**
+   *  \brief CONTROL THREAD: Solve the State() (stamped with \a stamp_ns,
+   *         system clock) into the Command(), with the newest model, and
+   *         record this step
+   *
+   *  \return The Command()
+   */
+  auto Step(std::int64_t stamp_ns) -> const output_t & {
+    const auto stamps = Stamps{clock::now(), stamp_ns,
+                               static_cast<double>(stamp_ns) * 1e-9, &m_state};
+    Step(m_state, m_command, stamps, [](bool /* changed */) {});
+    return m_command;
+  }
+
+  /// CONTROL THREAD: \return The preallocated batch of states (COLS x
+  ///                 STREAMS, see 'batch/*'), solved by StepBatch()
+  auto BatchState() noexcept -> Eigen::MatrixXd & { return m_batch_state; }
+
+  /// \return The preallocated batch of commands (ROWS x STREAMS), solved by
+  ///         StepBatch()
+  auto BatchCommand() const noexcept -> const Eigen::MatrixXd & {
+    return m_batch_command;
+  }
+
+  /**
+   *  \brief CONTROL THREAD: Solve the BatchState() into the BatchCommand()
+   *         at once, with the newest model (see SolveBatchInto()) plus the
+   *         offset of each stream, then call \a publish(k) and record the
+   *         step of each stream k whose \a stamps[k] isn't nullptr
+   *
+   *  The other streams (e.g. without any state yet) are solved, but neither
+   *  published nor recorded. Nothing is solved when all of them are.
+   *
+   *  Probes, per stream published (arg0 being its stamps probe, as for
+   *  Step()): 'lfc:solve_start' and 'lfc:solve_end' around the batch solve
+   *
+   *  \pre \a stamps holds one entry per stream
+   */
+  template <class Publish>
+  auto StepBatch(const std::vector<const Stamps *> &stamps, Publish &&publish)
+      -> void {
+    if (std::all_of(stamps.begin(), stamps.end(),
+                    [](const Stamps *stream) { return stream == nullptr; })) {
+      return;
+    }
+
+    const auto version = FetchModel();
+
+    const auto solve_begin = clock::now();
+    for (const auto *stream : stamps) {
+      if (stream != nullptr) LFC_PROBE(solve_start, stream->probe, version);
+    }
+    SolveBatchInto(m_batch_state, m_batch_command);
+    if (m_batch_offsets.size() > 0) m_batch_command += m_batch_offsets;
+    for (const auto *stream : stamps) {
+      if (stream != nullptr) LFC_PROBE(solve_end, stream->probe, version);
+    }
+    const auto solve_end = clock::now();
+
+    for (std::size_t k = 0; k < stamps.size(); ++k) {
+      const auto *const stream = stamps[k];
+      if (stream == nullptr) continue;
+
+      publish(k);
+      const auto published = clock::now();
+      const auto col = static_cast<Eigen::Index>(k);
+      Record(stream->received, solve_begin, solve_end, published,
+             stream->stamp_ns, version, m_batch_state.col(col).data(),
+             m_batch_command.col(col).data());
+    }
+  }
+
+  /**
+   *  \brief CONTROL THREAD: Solve \a solves times the model (or the
+   *         successive models of the trajectory) from the State() and the
+   *         BatchState(), leaving the Command() and the BatchCommand() to
+   *         ZERO, without recording anything
+   *
+   *  Faults in the pages used by the control step, and trains the branch
+   *  predictors, before the first real step. The trajectory start time isn't
+   *  latched.
+   */
+  auto WarmUp(std::size_t solves) -> void {
+    for (std::size_t i = 0; i < solves; ++i) {
+      if (m_trajectory.has_value()) {
+        SolveModelInto(i % m_trajectory->Count(), m_state, m_command);
+      } else {
+        FetchModel();
+        const auto &current = Current();
+        current.gains.SolveInto(current.offset, m_state, m_command);
+      }
+    }
+
+    if (m_batch_state.cols() > 0) {
+      const auto &current = Current();
+      for (std::size_t i = 0; i < solves; ++i) {
+        current.gains.SolveBatchInto(current.offset, m_batch_state,
+                                     m_batch_command);
+      }
+      m_batch_command.setZero();
+    }
+
+    m_command.setZero();
+  }
+
+  /// \return The stats of the control steps recorded
+  auto Stats() noexcept -> ControlPathStats & { return m_stats; }
+  auto Stats() const noexcept -> const ControlPathStats & { return m_stats; }
+
+  /**
+   *  \brief Count the hardware events of each solve from now on (see
+   *         Measure()), ignored when unavailable (see PerfError())
+   *
+   *  Only the events of the thread calling Measure() first are counted: the
+   *  solves must all be done by this same thread.
+   *
+   *  \warning Only while the control thread is stopped
+   */
+  auto EnablePerf() noexcept -> void {
+    m_perf_state.store(PerfState::kPending, std::memory_order_relaxed);
+  }
+
+  /// \return Why the hardware events can't be counted, nullptr if they can
+  ///         (or aren't enabled, or not yet opened)
+  auto PerfError() const noexcept -> const std::string * {
+    return (m_perf_state.load(std::memory_order_acquire) ==
+            PerfState::kUnavailable)
+               ? &m_perf_error
+               : nullptr;
+  }
+
+  /**
+   *  \brief Record the last \a records control steps (see Record()) into a
+   *         flight recorder, sized after the current model
+   *
+   *  \warning Allocates, only while the control thread is stopped
+   *
+   *  \param[out] reason Reason of the failure, if any
+   *
+   *  \return False on failure (nothing is recorded)
+   */
+  auto EnableFlightRecorder(std::size_t records, std::string &reason)
+      -> bool {
+    m_recorder = FlightRecorder::Create(static_cast<std::size_t>(Cols()),
+                                        static_cast<std::size_t>(Rows()),
+                                        records, reason);
+    return m_recorder.has_value();
+  }
+
+  /// \return The flight recorder, nullptr when not enabled
+  auto Recorder() noexcept -> FlightRecorder * {
+    return m_recorder.has_value() ? &(*m_recorder) : nullptr;
+  }
+
+ private:
+  enum class PerfState { kDisabled, kPending, kOpen, kUnavailable };
+
+  /// Open the hardware counters, counting the events of the calling thread
+  auto OpenPerfCounters() -> void {
+    m_perf = PerfCounters::Open(m_perf_error);
+    m_perf_state.store(m_perf.has_value() ? PerfState::kOpen
+                                          : PerfState::kUnavailable,
+                       std::memory_order_release);
+  }
+
+  /// Bring \a slot up to date with the posted model, replaying the last
+  /// patches when possible, copying the whole model otherwise
+  auto CatchUp(Model &slot) const -> void;
+
+  /// Solve the model of the trajectory active at \a time into \a y
+  template <class X, class Y>
+  auto SolveTrajectoryInto(const X &x, Y &y, double time) -> void {
+    if (m_trajectory_start <= 0.) m_trajectory_start = time;
+
+    const auto point =
+        m_trajectory->Locate(time - m_trajectory_start, m_interpolation);
+
+    SolveModelInto(point.index, x, y);
+    if (point.alpha > 0.) {
+      // Linear w.r.t. the models: blending Y is blending the models
+      SolveModelInto(point.index + 1, x, m_blend);
+      y = ((1. - point.alpha) * y) + (point.alpha * m_blend);
+    }
+
+    // Get the next model (not used yet) ready for the next steps
+    m_trajectory->Prefetch(point.index + ((point.alpha > 0.) ? 2 : 1));
+  }
+
+  /// Solve the model \a k of the trajectory into \a y
+  template <class X, class Y>
+  auto SolveModelInto(std::size_t k, const X &x, Y &y) const -> void {
+    const auto rows = static_cast<Eigen::Index>(m_trajectory->Rows());
+    const auto cols = static_cast<Eigen::Index>(m_trajectory->Cols());
+    const auto gains =
+        Eigen::Map<const gains_t>(m_trajectory->Coeffs(k), rows, cols);
+    const auto offset =
+        Eigen::Map<const offset_t>(m_trajectory->Offset(k), rows);
+
+    lfc::SolveInto(TieAsLinearModel(gains, offset), x, y);
+  }
+
+  /// Model solved, written by the model writer, read by the control thread
+  lockfree::Mailbox<Model> m_model;
+  /// Last model posted, whose gains are always dense (column major),
+  /// whatever the kernel used by the control thread
+  Model m_posted = Model{};
+
+  /// Last block patches posted (contiguous versions, ending at
+  /// m_posted.version), replayed to update the model spare buffer
+  std::deque<ModelPatch> m_patches = {};
+  static constexpr std::size_t kMaxPatches = 16;
+
+  GainsKernel m_kernel = GainsKernel::kColMajor;
+  std::optional<Autotuning> m_tuning = std::nullopt;
+
+  input_t m_state = input_t{};    /*!< Preallocated X of Step() */
+  output_t m_command = output_t{}; /*!< Preallocated Y of Step() */
+
+  /// Trajectory only: models solved instead of the model, given the time
+  std::optional<LinearModelTrajectory<double>> m_trajectory = std::nullopt;
+  TrajectoryInterpolation m_interpolation = TrajectoryInterpolation::kHold;
+  double m_trajectory_start = 0.; /*!< Time of the first model, latched if 0 */
+  output_t m_blend = output_t{};  /*!< Preallocated Y of the model k+1 */
+
+  /// Batch only: states solved together, one per stream (column)
+  Eigen::MatrixXd m_batch_state = Eigen::MatrixXd{};   /*!< COLS x STREAMS */
+  Eigen::MatrixXd m_batch_command = Eigen::MatrixXd{}; /*!< ROWS x STREAMS */
+  /// Offsets of each stream (ROWS x STREAMS), added to the model one
+  Eigen::MatrixXd m_batch_offsets = Eigen::MatrixXd{};
+
+  /// Publish-on-change only: suppresses the commands unchanged since the
+  /// last one published
+  std::optional<ChangeFilter> m_on_change = std::nullopt;
+
+  ControlPathStats m_stats;
+
+  /// Hardware counters of the solves (see EnablePerf())
+  std::atomic<PerfState> m_perf_state = PerfState::kDisabled;
+  std::optional<PerfCounters> m_perf = std::nullopt;
+  std::string m_perf_error = {}; /*!< Set before m_perf_state: kUnavailable */
+  PerfSample m_perf_sample = {}; /*!< Preallocated events of a solve */
+
+  std::optional<FlightRecorder> m_recorder = std::nullopt;
+};
+
+} // namespace lfc
@@ -0,0 +1,343 @@
+#pragma once
+
+// SYSTEM
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// INTERNAL
+#include "lfc/linear_model.hpp"
+
+// EXT
+// -- Eigen
+#include "Eigen/Core"
+#include "Eigen/SparseCore"
+
+namespace lfc {
+
+using gains_t = Eigen::MatrixXd;
+using offset_t = Eigen::VectorXd;
+
+/// Kernels (i.e. storage of the gains) used to solve Y = offset + gains * X
+enum class GainsKernel {
+  kColMajor, /*!< Dense, column major (Eigen's default) */
+  kRowMajor, /*!< Dense, row major: each Y_i is a contiguous dot product */
+  kSparse,   /*!< Sparse (row major), for gains mostly made of zeros */
+  kBlocked,  /*!< Dense, column major, solved by panels of rows */
+  kFixed,    /*!< Dense, with a compile time shape (see details::AnyGains) */
+};
+
+constexpr auto ToString(GainsKernel kernel) noexcept -> std::string_view {
+  switch (kernel) {
+    case GainsKernel::kColMajor: return "column_major";
+    case GainsKernel::kRowMajor: return "row_major";
+    case GainsKernel::kSparse: return "sparse";
+    case GainsKernel::kBlocked: return "blocked";
+    case GainsKernel::kFixed: return "fixed";
+  }
+
+  return "";
+}
+
+constexpr std::array kAllGainsKernels = {
+    GainsKernel::kColMajor, GainsKernel::kRowMajor, GainsKernel::kSparse,
+    GainsKernel::kBlocked,  GainsKernel::kFixed,
+};
+
+/// \return The GainsKernel named \a name (see ToString()), if any
+constexpr auto GainsKernelFrom(std::string_view name) noexcept
+    -> std::optional<GainsKernel> {
+  for (auto kernel : kAllGainsKernels) {
+    if (name == ToString(kernel)) return kernel;
+  }
+  return std::nullopt;
+}
+
+namespace details {
+
+using row_major_gains_t =
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+using sparse_gains_t = Eigen::SparseMatrix<double, Eigen::RowMajor>;
+
+/// Column major gains, solved by panels of kRows rows, keeping each panel of
+/// Y in L1 while streaming X
+struct BlockedGains {
+  static constexpr Eigen::Index kRows = 32;
+  gains_t matrix = gains_t{};
+};
+
+/// \return The underlying Eigen matrix of \a gains
+template <class T>
+constexpr auto Matrix(T &gains) -> auto & {
+  if constexpr (std::is_same_v<std::decay_t<T>, BlockedGains>) {
+    return gains.matrix;
+  } else {
+    return gains;
+  }
+}
+
+/// True when matrices of types A and B may have the same shape
+template <class A, class B>
+struct HaveCompatibleShapes
+    : std::bool_constant<((A::RowsAtCompileTime == Eigen::Dynamic) ||
+                          (B::RowsAtCompileTime == Eigen::Dynamic) ||
+                          (A::RowsAtCompileTime == B::RowsAtCompileTime)) &&
+                         ((A::ColsAtCompileTime == Eigen::Dynamic) ||
+                          (B::ColsAtCompileTime == Eigen::Dynamic) ||
+                          (A::ColsAtCompileTime == B::ColsAtCompileTime))> {};
+
+template <int Rows, int Cols>
+using fixed_gains_t = Eigen::Matrix<double, Rows, Cols>;
+
+template <class T>
+struct IsFixedGains : std::false_type {};
+
+template <int Rows, int Cols>
+struct IsFixedGains<fixed_gains_t<Rows, Cols>>
+    : std::bool_constant<(Rows != Eigen::Dynamic) && (Cols != Eigen::Dynamic)> {
+};
+
+/// All the gains storages (the fixed ones are typical [q, v] -> tau shapes)
+using AnyGains =
+    std::variant<gains_t, row_major_gains_t, sparse_gains_t, BlockedGains,
+                 fixed_gains_t<6, 6>, fixed_gains_t<6, 12>, fixed_gains_t<7, 7>,
+                 fixed_gains_t<7, 14>, fixed_gains_t<12, 12>,
+                 fixed_gains_t<12, 24>>;
+
+/// Emplace \a gains into the first fixed alternative of \a out (starting at
+/// I) whose shape matches \a gains
+/// \return False when none matches
+template <std::size_t I = 4>
+auto EmplaceFixedGains(const gains_t &gains, AnyGains &out) -> bool {
+  if constexpr (I == std::variant_size_v<AnyGains>) {
+    return false;
+  } else {
+    using fixed_t = std::variant_alternative_t<I, AnyGains>;
+    if ((gains.rows() == fixed_t::RowsAtCompileTime) &&
+        (gains.cols() == fixed_t::ColsAtCompileTime)) {
+      out.emplace<I>() = gains;
+      return true;
+    }
+    return EmplaceFixedGains<I + 1>(gains, out);
+  }
+}
+
+} // namespace details
+
+/**
+ *  \brief Gains, stored as required by the GainsKernel used to solve them
+ *
+ *  Copying Gains of the same kernel and shape never allocates (except sparse
+ *  gains whose number of non zeros changed).
+ */
+class Gains {
+ public:
+  /// Empty column major gains
+  Gains() = default;
+
+  /**
+   *  \brief Store \a gains as required by \a kernel
+   *
+   *  \pre IsApplicable(kernel, gains)
+   */
+  Gains(const gains_t &gains, GainsKernel kernel) {
+    switch (kernel) {
+      case GainsKernel::kColMajor: m_gains.emplace<gains_t>(gains); break;
+      case GainsKernel::kRowMajor:
+        m_gains.emplace<details::row_major_gains_t>(gains);
+        break;
+      case GainsKernel::kSparse:
+        m_gains.emplace<details::sparse_gains_t>(gains.sparseView());
+        break;
+      case GainsKernel::kBlocked:
+        m_gains.emplace<details::BlockedGains>(details::BlockedGains{gains});
+        break;
+      case GainsKernel::kFixed:
+        details::EmplaceFixedGains(gains, m_gains);
+        break;
+    }
+  }
+
+  /// \return True when \a kernel can be used with \a gains
+  static auto IsApplicable(GainsKernel kernel, const gains_t &gains) -> bool {
+    switch (kernel) {
+      case GainsKernel::kSparse: {
+        // Worth trying with, at most, half of non zeros
+        const auto zeros = (gains.array() == 0.).count();
+        return (zeros * 2) >= gains.size();
+      }
+      case GainsKernel::kBlocked:
+        return gains.rows() > details::BlockedGains::kRows;
+      case GainsKernel::kFixed: {
+        auto fixed = details::AnyGains{};
+        return details::EmplaceFixedGains(gains, fixed);
+      }
+      case GainsKernel::kColMajor:
+      case GainsKernel::kRowMajor: return true;
+    }
+
+    return false;
+  }
+
+  /// \return The kernel used
+  auto Kernel() const -> GainsKernel {
+    return std::visit(
+        [](const auto &gains) {
+          using T = std::decay_t<decltype(gains)>;
+          if constexpr (std::is_same_v<T, gains_t>) {
+            return GainsKernel::kColMajor;
+          } else if constexpr (std::is_same_v<T, details::row_major_gains_t>) {
+            return GainsKernel::kRowMajor;
+          } else if constexpr (std::is_same_v<T, details::sparse_gains_t>) {
+            return GainsKernel::kSparse;
+          } else if constexpr (std::is_same_v<T, details::BlockedGains>) {
+            return GainsKernel::kBlocked;
+          } else {
+            return GainsKernel::kFixed;
+          }
+        },
+        m_gains);
+  }
+
+  auto Rows() const -> Eigen::Index {
+    return std::visit(
+        [](const auto &gains) { return details::Matrix(gains).rows(); },
+        m_gains);
+  }
+
+  auto Cols() const -> Eigen::Index {
+    return std::visit(
+        [](const auto &gains) { return details::Matrix(gains).cols(); },
+        m_gains);
+  }
+
+  /// Replace all the gains by \a values (same shape)
+  template <class Values>
+  auto Assign(const Eigen::MatrixBase<Values> &values) -> void {
+    std::visit([&](auto &gains) { AssignInto(gains, values.derived()); },
+               m_gains);
+  }
+
+  /// Replace all the gains by the ones of \a other (same shape, keeping the
+  /// kernel in use)
+  auto Assign(const Gains &other) -> void {
+    std::visit(
+        [](auto &gains, const auto &source) {
+          AssignInto(gains, details::Matrix(source));
+        },
+        m_gains, other.m_gains);
+  }
+
+  /**
+   *  \brief Replace the block of the gains at (\a row, \a col) by \a values
+   *
+   *  \return False when the kernel doesn't support partial updates (sparse),
+   *          the caller is expected to Assign() all the gains instead
+   */
+  template <class Values>
+  auto AssignBlock(Eigen::Index row, Eigen::Index col,
+                   const Eigen::MatrixBase<Values> &values) -> bool {
+    return std::visit(
+        [&](auto &gains) {
+          using T = std::decay_t<decltype(gains)>;
+          if constexpr (std::is_same_v<T, details::sparse_gains_t>) {
+            return false;
+          } else {
+            auto &matrix = details::Matrix(gains);
+            matrix.block(row, col, values.rows(), values.cols()) = values;
+            return true;
+          }
+        },
+        m_gains);
+  }
+
+  /**
+   *  \brief Solve Y = offset + gains * x into \a y, without allocating
+   *
+   *  \pre x.size() == Cols(), y.size() == offset.size() == Rows()
+   *  \pre x and y are contiguous
+   */
+  template <class X, class Y>
+  auto SolveInto(const offset_t &offset, const X &x, Y &y) const -> void {
+    std::visit(
+        [&](const auto &gains) {
+          using T = std::decay_t<decltype(gains)>;
+          if constexpr (std::is_same_v<T, details::BlockedGains>) {
+            const auto rows = gains.matrix.rows();
+            for (Eigen::Index r = 0; r < rows; r += T::kRows) {
+              const auto n = std::min(T::kRows, rows - r);
+              const auto panel = gains.matrix.middleRows(r, n);
+              const auto panel_offset = offset.segment(r, n);
+              auto panel_y = y.segment(r, n);
+              ::lfc::SolveInto(TieAsLinearModel(panel, panel_offset), x,
+                               panel_y);
+            }
+          } else if constexpr (details::IsFixedGains<T>::value) {
+            // Fixed size views, such that the product is fully unrolled
+            using x_t = Eigen::Matrix<double, T::ColsAtCompileTime, 1>;
+            using y_t = Eigen::Matrix<double, T::RowsAtCompileTime, 1>;
+            const auto fixed_offset = Eigen::Map<const y_t>(offset.data());
+            const auto fixed_x = Eigen::Map<const x_t>(x.data());
+            auto fixed_y = Eigen::Map<y_t>(y.data());
+            ::lfc::SolveInto(TieAsLinearModel(gains, fixed_offset), fixed_x,
+                             fixed_y);
+          } else {
+            ::lfc::SolveInto(TieAsLinearModel(gains, offset), x, y);
+          }
+        },
+        m_gains);
+  }
+
+  /**
+   *  \brief Solve Y = offset + gains * X for a batch of states at once (one
+   *         per column of \a x) into \a y, as a single matrix product
+   *
+   *  Amortizes the gains streaming over all the states of the batch: solving
+   *  N states costs far less than N SolveInto().
+   *
+   *  \pre x.rows() == Cols(), y.rows() == offset.size() == Rows()
+   *  \pre x.cols() == y.cols(), y does not alias x
+   */
+  template <class X, class Y>
+  auto SolveBatchInto(const offset_t &offset, const X &x, Y &y) const
+      -> void {
+    std::visit(
+        [&](const auto &gains) {
+          // The blocked kernel only matters to vectors: GEMM is already
+          // blocked by Eigen
+          y.noalias() = details::Matrix(gains) * x;
+          y.colwise() += offset;
+        },
+        m_gains);
+  }
+
+ private:
+  /// Copy the \a source matrix (of the same shape) into \a gains
+  template <class T, class Source>
+  static auto AssignInto(T &gains, const Source &source) -> void {
+    if constexpr (std::is_same_v<T, details::sparse_gains_t>) {
+      if constexpr (std::is_base_of_v<Eigen::SparseMatrixBase<Source>,
+                                      Source>) {
+        gains = source;
+      } else {
+        gains = source.sparseView();
+      }
+    } else {
+      using M = std::decay_t<decltype(details::Matrix(gains))>;
+      // Fixed shapes only match themselves (or dynamic ones) at runtime
+      constexpr auto kCompatible =
+          details::HaveCompatibleShapes<M, Source>::value;
+      if constexpr (kCompatible) details::Matrix(gains) = source;
+    }
+  }
+
+  details::AnyGains m_gains = gains_t{};
+};
+
+} // namespace lfc
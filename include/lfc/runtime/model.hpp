@@ -0,0 +1,79 @@
+#pragma once
+
+// SYSTEM
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// INTERNAL
+#include "lfc/runtime/gains.hpp"
+
+// EXT
+// -- Eigen
+#include "Eigen/Core"
+
+namespace lfc {
+
+/// The linear model Y = offset + gains * X
+struct Model {
+  Gains gains = Gains{};
+  offset_t offset = offset_t{};
+  std::uint64_t version = 0; /*!< Number of patches applied */
+};
+
+/// A rectangular block of the gains (or a segment of the offset, COLS = 1)
+struct ModelBlock {
+  Eigen::Index row = 0;
+  Eigen::Index col = 0;
+  Eigen::Index rows = 0;
+  Eigen::Index cols = 0;
+
+  /**
+   *  \return The block described by \a values ({ROW, COL, ROWS, COLS}, or
+   *          {START, SIZE} when \a is_segment is set), when it fits within a
+   *          \a max_rows x \a max_cols matrix
+   */
+  static auto From(const std::vector<std::int64_t> &values, bool is_segment,
+                   Eigen::Index max_rows, Eigen::Index max_cols)
+      -> std::optional<ModelBlock> {
+    auto block = ModelBlock{};
+    if (is_segment && (values.size() == 2)) {
+      block = ModelBlock{values[0], 0, values[1], 1};
+    } else if (!is_segment && (values.size() == 4)) {
+      block = ModelBlock{values[0], values[1], values[2], values[3]};
+    } else {
+      return std::nullopt;
+    }
+
+    const auto fits = (block.row >= 0) && (block.rows >= 0) &&
+                      (block.row <= (max_rows - block.rows)) &&
+                      (block.col >= 0) && (block.cols >= 0) &&
+                      (block.col <= (max_cols - block.cols));
+    return fits ? std::make_optional(block) : std::nullopt;
+  }
+};
+
+/// New values of a block of the model
+struct ModelPatch {
+  bool is_offset = false; /*!< Patch the offset instead of the gains */
+  ModelBlock block = ModelBlock{};
+  Eigen::MatrixXd values = Eigen::MatrixXd{}; /*!< block.rows x block.cols */
+  std::uint64_t version = 0; /*!< Model version once applied */
+
+  /**
+   *  \brief Copy the values into the block of \a model (block.size()
+   *         operations)
+   *
+   *  Gains that can't be partially updated (sparse) are entirely copied from
+   *  \a source instead, expected to be already patched.
+   */
+  auto ApplyTo(Model &model, const Model &source) const -> void {
+    if (is_offset) {
+      model.offset.segment(block.row, block.rows) = values.col(0);
+    } else if (!model.gains.AssignBlock(block.row, block.col, values)) {
+      model.gains.Assign(source.gains);
+    }
+  }
+};
+
+} // namespace lfc
@@ -0,0 +1,81 @@
+#pragma once
+
+// SYSTEM
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// INTERNAL
+#include "lfc/export.h"
+#include "lfc/flight_recorder.hpp"
+#include "lfc/lockfree/histogram.hpp"
+#include "lfc/runtime/gains.hpp"
+
+namespace lfc {
+
+/// Outcome of the replay of flight records (see ReplayFlight())
+struct ReplayStats {
+  using histogram_t = lockfree::Histogram<>;
+
+  histogram_t load;    /*!< Record X -> state X (ns) */
+  histogram_t solve;   /*!< State X -> command Y (ns) */
+  histogram_t compare; /*!< Command Y vs Y recorded (ns) */
+
+  double max_diff = 0.;         /*!< Highest |Y - Y recorded| value */
+  double sum_squared_diff = 0.; /*!< Over every value of the commands */
+  std::size_t values = 0;       /*!< Values compared */
+  std::size_t mismatches = 0;   /*!< Commands above the tolerance */
+  std::uint64_t first_mismatch = 0; /*!< Sequence, 0 if none */
+
+  /// \return The root mean square of the |Y - Y recorded| values
+  auto RmsDiff() const noexcept -> double {
+    return (values > 0)
+               ? std::sqrt(sum_squared_diff / static_cast<double>(values))
+               : 0.;
+  }
+
+  /// Add the replay \a other (of records following these ones) to these
+  auto Merge(const ReplayStats &other) noexcept -> void {
+    load.Merge(other.load);
+    solve.Merge(other.solve);
+    compare.Merge(other.compare);
+    max_diff = std::max(max_diff, other.max_diff);
+    sum_squared_diff += other.sum_squared_diff;
+    values += other.values;
+    if ((mismatches == 0) && (other.mismatches > 0)) {
+      first_mismatch = other.first_mismatch;
+    }
+    mismatches += other.mismatches;
+  }
+};
+
+/**
+ *  \brief Keep the \a records of the \a model_version only, as a dump may
+ *         span several models while only one is replayed
+ *
+ *  \return The number of records removed
+ */
+LFC_PUBLIC auto KeepModelVersion(std::vector<FlightRecord> &records,
+                                 std::uint64_t model_version) -> std::size_t;
+
+/**
+ *  \brief Replay the \a records [begin, end[ \a repeat times through the
+ *         solve of the control path: each record X is copied into a
+ *         preallocated state, solved (\a gains, \a offset) into a
+ *         preallocated command, then compared to the Y recorded
+ *
+ *  The records hold the state X gathered by the node: the gather itself
+ *  (e.g. from a JointState) isn't replayed.
+ *
+ *  \param[out] stats Timings of each stage (all passes) and differences
+ *              with the commands recorded (first pass only), added to
+ */
+LFC_PUBLIC auto ReplayFlight(const std::vector<FlightRecord> &records,
+                             std::size_t begin, std::size_t end,
+                             const Gains &gains, const offset_t &offset,
+                             std::size_t repeat, double tolerance,
+                             ReplayStats &stats) -> void;
+
+} // namespace lfc
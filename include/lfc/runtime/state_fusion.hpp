@@ -0,0 +1,119 @@
+#pragma once
+
+// SYSTEM
+#include <chrono>
+#include <cstddef>
+#include <deque>
+
+// INTERNAL
+#include "lfc/lockfree/seqlock.hpp"
+#include "lfc/runtime/control_path_stats.hpp"
+
+namespace lfc {
+
+/**
+ *  \brief Lock free fusion of state sources (e.g. other sensors, at other
+ *         rates) into their own segment of the state X, after the values of
+ *         the main input
+ *
+ *  Threads:
+ *  - ONE writer per source: Store() (wait free);
+ *  - ONE control thread: FuseInto(), never allocating nor waiting;
+ *  - AddSource() only while none of them runs.
+ */
+class StateFusion {
+ public:
+  using clock = ControlPathStats::clock;
+
+  /// Reads of a source being written before giving up on it (see FuseInto())
+  static constexpr std::size_t kLoads = 4;
+
+  /// Age of the main input beyond which it is stale (never when zero)
+  clock::duration max_age = clock::duration::zero();
+
+  /**
+   *  \brief Add the source of the \a size values X[start, start + size),
+   *         stale beyond \a source_max_age (never when zero)
+   *
+   *  \warning Allocates
+   *
+   *  \return Its index (see Store())
+   */
+  auto AddSource(std::size_t start, std::size_t size,
+                 clock::duration source_max_age) -> std::size_t {
+    m_sources.emplace_back(start, size, source_max_age);
+    return m_sources.size() - 1;
+  }
+
+  /// \return The number of sources
+  auto Sources() const noexcept -> std::size_t { return m_sources.size(); }
+
+  /// SOURCE WRITER: Store the newest values of \a source (as many as its
+  /// size), \a values, received at \a received
+  auto Store(std::size_t source, const double *values,
+             clock::time_point received) noexcept -> void {
+    m_sources[source].slot.Store(Sample{received}, values);
+  }
+
+  /**
+   *  \brief CONTROL THREAD: Snapshot the newest values of every source into
+   *         their segment of \a x, the main input being received at
+   *         \a received
+   *
+   *  A source is read at most kLoads times: its writer (e.g. not real-time)
+   *  may be preempted in the middle of a store, and a real-time control
+   *  thread spinning on it would never let it finish (e.g. on the same CPU).
+   *
+   *  \return False when the main input, or any source, is older than its max
+   *          age, when a source hasn't been received yet, or is still being
+   *          written after kLoads reads (its values being torn)
+   */
+  auto FuseInto(double *x, clock::time_point received,
+                clock::time_point now = clock::now()) const noexcept -> bool {
+    const auto is_stale = [&](clock::time_point since, clock::duration limit) {
+      return (limit > clock::duration::zero()) && ((now - since) > limit);
+    };
+
+    if (is_stale(received, max_age)) return false;
+
+    for (const auto &source : m_sources) {
+      auto sample = Sample{};
+      auto loaded = false;
+      for (std::size_t k = 0; !loaded && (k < kLoads); ++k) {
+        loaded = source.slot.TryLoad(sample, x + source.start);
+      }
+
+      if (!loaded || (sample.received == clock::time_point{}) ||
+          is_stale(sample.received, source.max_age)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+ private:
+  /// Header of the values stored, telling how old they are
+  struct Sample {
+    /// When the values were received, never if default constructed
+    clock::time_point received = {};
+  };
+
+  struct Source {
+    Source(std::size_t source_start, std::size_t source_size,
+           clock::duration source_max_age)
+        : start(source_start), max_age(source_max_age), slot(source_size) {}
+
+    std::size_t start;       /*!< First value of the segment of X */
+    clock::duration max_age; /*!< Never stale when zero */
+
+    /// Newest values, written by the source writer, snapshotted by the
+    /// control thread
+    lockfree::SeqlockArray<Sample, double> slot;
+  };
+
+  /// Not movable (seqlocks), hence the deque
+  std::deque<Source> m_sources = {};
+};
+
+} // namespace lfc
@@ -0,0 +1,146 @@
+#pragma once
+
+// SYSTEM
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lfc {
+
+/**
+ *  \brief Assemble the whole command Y of a row partitioned (sharded) model,
+ *         from the partial commands of its shards
+ *
+ *  Each shard solves a range of rows of Y from the same state, its partial
+ *  command being tagged with the sequence id of this state (e.g. its stamp).
+ *  A command is complete once all of its rows are added, in any order.
+ *
+ *  As shards lag differently, a few sequences are assembled at once, within
+ *  preallocated slots: Add() never allocates. Commands are never assembled
+ *  backwards in time:
+ *  - when all the slots are used, the oldest sequence is dropped (see
+ *    Dropped()) to make room for a newer one;
+ *  - once a sequence is complete, the older ones still pending are dropped,
+ *    and the partial commands of sequences not newer than it are ignored
+ *    (see Ignored()).
+ */
+class ShardAssembler {
+ public:
+  /**
+   *  \brief Assemble commands of \a rows values, \a in_flight sequences at
+   *         once (at least 1)
+   *
+   *  \warning Allocates
+   */
+  explicit ShardAssembler(std::size_t rows, std::size_t in_flight = 4)
+      : m_rows(rows),
+        m_slots(std::max<std::size_t>(in_flight, 1),
+                Slot{0, false, 0, std::vector<std::uint8_t>(rows, 0),
+                     std::vector<double>(rows, 0.)}) {}
+
+  /// \return The number of rows of the commands
+  auto Rows() const noexcept -> std::size_t { return m_rows; }
+
+  /**
+   *  \brief Add the \a count \a values of the rows [\a begin, \a begin +
+   *         \a count) of the sequence \a id
+   *
+   *  Rows added twice to the same sequence are overwritten.
+   *
+   *  \return The whole command of \a id when complete (valid until the next
+   *          Add()), nullptr otherwise (or when ignored: out of the command
+   *          rows, or not newer than the last complete sequence)
+   */
+  auto Add(std::uint64_t id, std::size_t begin, const double *values,
+           std::size_t count) noexcept -> const std::vector<double> * {
+    if ((count == 0) || (begin > m_rows) || (count > (m_rows - begin)) ||
+        (m_has_complete && (id <= m_last_complete))) {
+      ++m_ignored;
+      return nullptr;
+    }
+
+    auto *slot = SlotOf(id);
+    if (slot == nullptr) {
+      ++m_ignored; // Older than all the pending sequences
+      return nullptr;
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+      auto &covered = slot->covered[begin + i];
+      slot->filled += (covered == 0) ? 1 : 0;
+      covered = 1;
+      slot->y[begin + i] = values[i];
+    }
+
+    if (slot->filled < m_rows) return nullptr;
+
+    // Complete: the older sequences won't ever be published
+    m_last_complete = id;
+    m_has_complete = true;
+    slot->used = false;
+    for (auto &other : m_slots) {
+      if (other.used && (other.id < id)) {
+        other.used = false;
+        ++m_dropped;
+      }
+    }
+    return &slot->y;
+  }
+
+  /// \return The number of sequences dropped before being complete
+  auto Dropped() const noexcept -> std::uint64_t { return m_dropped; }
+
+  /// \return The number of partial commands ignored (see Add())
+  auto Ignored() const noexcept -> std::uint64_t { return m_ignored; }
+
+ private:
+  /// Sequence being assembled
+  struct Slot {
+    std::uint64_t id;
+    bool used;
+    std::size_t filled;                /*!< Number of rows covered */
+    std::vector<std::uint8_t> covered; /*!< Per row: added or not */
+    std::vector<double> y;
+  };
+
+  /// \return The slot of the sequence \a id, (re)initialized when new,
+  ///         nullptr when older than all the pending ones (no slot left), or
+  ///         without any slot
+  auto SlotOf(std::uint64_t id) noexcept -> Slot * {
+    Slot *free = nullptr;
+    Slot *oldest = nullptr;
+    for (auto &slot : m_slots) {
+      if (!slot.used) {
+        free = &slot;
+      } else if (slot.id == id) {
+        return &slot;
+      } else if ((oldest == nullptr) || (slot.id < oldest->id)) {
+        oldest = &slot;
+      }
+    }
+
+    if (free == nullptr) {
+      if ((oldest == nullptr) || (oldest->id > id)) return nullptr;
+      free = oldest;
+      ++m_dropped;
+    }
+
+    free->id = id;
+    free->used = true;
+    free->filled = 0;
+    std::fill(free->covered.begin(), free->covered.end(), 0);
+    return free;
+  }
+
+  std::size_t m_rows;
+  std::vector<Slot> m_slots;
+
+  bool m_has_complete = false;
+  std::uint64_t m_last_complete = 0;
+
+  std::uint64_t m_dropped = 0;
+  std::uint64_t m_ignored = 0;
+};
+
+} // namespace lfc
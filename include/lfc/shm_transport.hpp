@@ -0,0 +1,506 @@
+#pragma once
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace lfc {
+
+/// How the consumer of a ShmRing waits for its next slot (see Wait())
+enum class ShmWakeup : std::uint32_t {
+  kBusyPoll, /*!< Poll the ring, without ever sleeping */
+  kFutex,    /*!< Poll briefly, then sleep on a futex woken by the producer */
+};
+
+/// Header of a ShmRing slot, directly followed by its values (doubles)
+struct ShmSlot {
+  std::uint64_t sequence = 0; /*!< Set by the driver, echoed in the command */
+  std::int64_t stamp_ns = 0;  /*!< System clock time of the state */
+
+  auto Values() noexcept -> double * {
+    return reinterpret_cast<double *>(this + 1);
+  }
+  auto Values() const noexcept -> const double * {
+    return reinterpret_cast<const double *>(this + 1);
+  }
+};
+
+/// Shared part of a ShmRing: its indices (never wrapping) and wakeup word
+struct ShmRingIndices {
+  alignas(64) std::atomic<std::uint64_t> head = 0; /*!< Next to consume */
+  alignas(64) std::atomic<std::uint64_t> tail = 0; /*!< Next to produce */
+
+  /// Bumped by the producer to wake the consumer, when sleeping
+  alignas(64) std::atomic<std::uint32_t> futex = 0;
+  std::atomic<std::uint32_t> sleepers = 0;
+};
+
+/**
+ *  \brief Header of a ShmTransport mapping, followed by the slots of its
+ *         states ring, then by the ones of its commands ring
+ *
+ *  Openers must check the magic (set last), the version and the size before
+ *  trusting anything else (see ShmTransport::Open()).
+ */
+struct ShmTransportHeader {
+  static constexpr std::uint64_t kMagic = 0x544d485343464c00; /* "\0LFCSHMT" */
+  static constexpr std::uint32_t kVersion = 1;
+
+  std::atomic<std::uint64_t> magic = 0; /*!< kMagic once initialized */
+  std::uint32_t version = kVersion;
+  std::uint32_t size = sizeof(ShmTransportHeader);
+  std::uint64_t x_size = 0;   /*!< Values of a state */
+  std::uint64_t y_size = 0;   /*!< Values of a command */
+  std::uint64_t capacity = 0; /*!< Slots per ring (power of 2) */
+  std::int64_t pid = 0;       /*!< Process of the controller */
+  ShmWakeup wakeup = ShmWakeup::kFutex;
+
+  ShmRingIndices states;   /*!< Driver -> controller */
+  ShmRingIndices commands; /*!< Controller -> driver */
+};
+
+namespace details {
+
+/// Sleep on \a word, up to \a timeout, unless it isn't \a expected anymore
+inline auto FutexWait(std::atomic<std::uint32_t> &word,
+                      std::uint32_t expected,
+                      std::chrono::nanoseconds timeout) noexcept -> void {
+  static_assert(std::atomic<std::uint32_t>::is_always_lock_free &&
+                (sizeof(word) == sizeof(std::uint32_t)));
+
+  auto ts = timespec{};
+  ts.tv_sec = timeout.count() / 1'000'000'000;
+  ts.tv_nsec = timeout.count() % 1'000'000'000;
+  // Not FUTEX_PRIVATE_FLAG: woken from another process
+  ::syscall(SYS_futex, &word, FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+/// Wake every thread sleeping on \a word
+inline auto FutexWake(std::atomic<std::uint32_t> &word) noexcept -> void {
+  ::syscall(SYS_futex, &word, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+} // namespace details
+
+/**
+ *  \brief Bounded ring of fixed-size ShmSlot, in shared memory, between ONE
+ *         producer process and ONE consumer process
+ *
+ *  Same protocol as lockfree::SpscRing (slots filled and consumed in place):
+ *  - The producer grabs a free slot with TryClaim(), fills it, then makes it
+ *    visible to the consumer with Commit();
+ *  - The consumer grabs the oldest committed slot with TryPeek() (or Wait()),
+ *    uses it, then gives it back to the producer with Release().
+ *
+ *  All operations but Wait() are wait-free. With ShmWakeup::kFutex, Commit()
+ *  only makes a syscall when the consumer is actually sleeping.
+ */
+class ShmRing {
+ public:
+  /// Empty ring, see ShmTransport
+  ShmRing() = default;
+
+  /// View of the ring whose shared part is \a indices, its caches being
+  /// seeded from them (e.g. a ring reopened after being used)
+  ShmRing(ShmRingIndices &indices, std::uint8_t *slots,
+          std::size_t slot_bytes, std::size_t values, std::size_t capacity,
+          ShmWakeup wakeup) noexcept
+      : m_indices(&indices),
+        m_slots(slots),
+        m_slot_bytes(slot_bytes),
+        m_values(values),
+        m_mask(capacity - 1),
+        m_wakeup(wakeup),
+        m_head_cache(indices.head.load(std::memory_order_acquire)),
+        m_tail_cache(indices.tail.load(std::memory_order_acquire)) {}
+
+  /// \return The number of values of each slot
+  auto Values() const noexcept -> std::size_t { return m_values; }
+
+  /// \return The number of slots
+  auto Capacity() const noexcept -> std::size_t { return m_mask + 1; }
+
+  /**
+   *  \brief PRODUCER: \return The next free slot, nullptr when the ring is full
+   *
+   *  Calling it again without Commit() returns the same slot.
+   */
+  auto TryClaim() noexcept -> ShmSlot * {
+    const auto tail = m_indices->tail.load(std::memory_order_relaxed);
+    if ((tail - m_head_cache) > m_mask) {
+      m_head_cache = m_indices->head.load(std::memory_order_acquire);
+      if ((tail - m_head_cache) > m_mask) return nullptr;
+    }
+    return SlotAt(tail);
+  }
+
+  /// PRODUCER: Publish the slot returned by TryClaim() to the consumer
+  ///
+  /// \pre TryClaim() returned a slot (not nullptr)
+  auto Commit() noexcept -> void {
+    const auto tail = m_indices->tail.load(std::memory_order_relaxed) + 1;
+    if (m_wakeup == ShmWakeup::kBusyPoll) {
+      m_indices->tail.store(tail, std::memory_order_release);
+      return;
+    }
+
+    // Sequentially consistent with Wait(): either the consumer sees this
+    // slot before sleeping, or this sees the consumer sleeping
+    m_indices->tail.store(tail, std::memory_order_seq_cst);
+    if (m_indices->sleepers.load(std::memory_order_seq_cst) != 0) {
+      m_indices->futex.fetch_add(1, std::memory_order_seq_cst);
+      details::FutexWake(m_indices->futex);
+    }
+  }
+
+  /**
+   *  \brief CONSUMER: \return The oldest committed slot, nullptr when the ring
+   *         is empty
+   *
+   *  Calling it again without Release() returns the same slot.
+   */
+  auto TryPeek() noexcept -> ShmSlot * {
+    const auto head = m_indices->head.load(std::memory_order_relaxed);
+    if (head == m_tail_cache) {
+      m_tail_cache = m_indices->tail.load(std::memory_order_acquire);
+      if (head == m_tail_cache) return nullptr;
+    }
+    return SlotAt(head);
+  }
+
+  /// CONSUMER: Give the slot returned by TryPeek() back to the producer
+  ///
+  /// \pre TryPeek() returned a slot (not nullptr)
+  auto Release() noexcept -> void {
+    m_indices->head.store(m_indices->head.load(std::memory_order_relaxed) + 1,
+                          std::memory_order_release);
+  }
+
+  /// CONSUMER: \return The number of committed slots not released yet
+  auto Pending() noexcept -> std::uint64_t {
+    m_tail_cache = m_indices->tail.load(std::memory_order_acquire);
+    return m_tail_cache - m_indices->head.load(std::memory_order_relaxed);
+  }
+
+  /**
+   *  \brief CONSUMER: Wait, up to \a timeout, for the oldest committed slot
+   *         (see TryPeek()), as set by the ring ShmWakeup
+   *
+   *  \return The slot, nullptr on timeout (possibly earlier, on a spurious
+   *          wakeup)
+   */
+  auto Wait(std::chrono::nanoseconds timeout) noexcept -> ShmSlot * {
+    if (auto *const slot = TryPeek(); slot != nullptr) return slot;
+
+    // Polled first: the next slot is usually a few microseconds away
+    using clock = std::chrono::steady_clock;
+    const auto deadline = clock::now() + timeout;
+    for (std::size_t polls = 1;; ++polls) {
+      if (auto *const slot = TryPeek(); slot != nullptr) return slot;
+      if ((m_wakeup == ShmWakeup::kFutex) && (polls == kPolls)) break;
+      if (((polls % kPolls) == 0) && (clock::now() >= deadline)) {
+        return nullptr;
+      }
+    }
+
+    m_indices->sleepers.fetch_add(1, std::memory_order_seq_cst);
+    const auto word = m_indices->futex.load(std::memory_order_seq_cst);
+    if (m_indices->tail.load(std::memory_order_seq_cst) ==
+        m_indices->head.load(std::memory_order_relaxed)) {
+      const auto left = deadline - clock::now();
+      if (left > clock::duration::zero()) {
+        details::FutexWait(m_indices->futex, word, left);
+      }
+    }
+    m_indices->sleepers.fetch_sub(1, std::memory_order_relaxed);
+
+    return TryPeek();
+  }
+
+ private:
+  /// Polls before sleeping (futex), or between clock reads (busy poll)
+  static constexpr std::size_t kPolls = 1024;
+
+  auto SlotAt(std::uint64_t index) const noexcept -> ShmSlot * {
+    return std::launder(reinterpret_cast<ShmSlot *>(
+        m_slots + ((index & m_mask) * m_slot_bytes)));
+  }
+
+  ShmRingIndices *m_indices = nullptr;
+  std::uint8_t *m_slots = nullptr;
+  std::size_t m_slot_bytes = 0;
+  std::size_t m_values = 0;
+  std::size_t m_mask = 0;
+  ShmWakeup m_wakeup = ShmWakeup::kBusyPoll;
+
+  std::uint64_t m_head_cache = 0; /*!< Producer only */
+  std::uint64_t m_tail_cache = 0; /*!< Consumer only */
+};
+
+/**
+ *  \brief State/command transport between a driver and the controller on
+ *         the same host, through a POSIX shared memory object: no network
+ *         stack, no syscall (unless sleeping), no copy
+ *
+ *  Two ShmRing:
+ *  - States(): the driver pushes its states X (ShmSlot::Values(), XSize()),
+ *    numbered by its own ShmSlot::sequence;
+ *  - Commands(): the controller pushes the commands Y (YSize()), each one
+ *    echoing the sequence and stamp of the state it was solved from.
+ *
+ *  The controller creates the transport (see Create()), drivers open it (see
+ *  Open()), each process being the single producer of one ring, and the
+ *  single consumer of the other.
+ */
+class ShmTransport {
+ public:
+  /**
+   *  \brief CONTROLLER: Create the POSIX shared memory object \a name (e.g.
+   *         "/lfc-transport"), holding rings of \a capacity states of
+   *         \a x_size values, and commands of \a y_size values
+   *
+   *  Fails when \a name already exists: it is never taken over from another
+   *  (live) controller. The shared memory object is unlinked once the
+   *  transport is destroyed.
+   *
+   *  \param[out] reason Reason of the failure, if any
+   *
+   *  \return The transport, std::nullopt on failure
+   */
+  static auto Create(const std::string &name, std::size_t x_size,
+                     std::size_t y_size, std::size_t capacity,
+                     ShmWakeup wakeup, std::string &reason)
+      -> std::optional<ShmTransport> {
+    if ((capacity == 0) || ((capacity & (capacity - 1)) != 0)) {
+      reason = "the capacity must be a power of 2";
+      return std::nullopt;
+    }
+
+    // Drivers may run as another user of the same group
+    constexpr auto kMode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP;
+    const auto fd = ::shm_open(name.c_str(),
+                               O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, kMode);
+    if ((fd < 0) && (errno == EEXIST)) {
+      reason = "'" + name + "' already exists (used by another controller, "
+               "or left by a crashed one: remove /dev/shm" + name + ")";
+      return std::nullopt;
+    }
+    if (fd < 0) {
+      reason = "can't create '" + name + "' (" + std::strerror(errno) + ")";
+      return std::nullopt;
+    }
+
+    // Freshly created: zero filled
+    const auto bytes = Bytes(x_size, y_size, capacity);
+    if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+      reason = "can't resize '" + name + "' (" + std::strerror(errno) + ")";
+      ::close(fd);
+      ::shm_unlink(name.c_str());
+      return std::nullopt;
+    }
+
+    auto transport = Map(fd, bytes, name, reason);
+    if (!transport.has_value()) {
+      ::shm_unlink(name.c_str());
+      return std::nullopt;
+    }
+    transport->m_owner = true;
+
+    auto *const header = new (transport->m_base) ShmTransportHeader{};
+    header->x_size = x_size;
+    header->y_size = y_size;
+    header->capacity = capacity;
+    header->pid = ::getpid();
+    header->wakeup = wakeup;
+    transport->InitRings();
+    header->magic.store(ShmTransportHeader::kMagic, std::memory_order_release);
+
+    return transport;
+  }
+
+  /**
+   *  \brief DRIVER: Map the transport held by the POSIX shared memory object
+   *         \a name, created by Create()
+   *
+   *  \param[out] reason Reason of the failure (e.g. version mismatch), if any
+   *
+   *  \return The transport, std::nullopt on failure
+   */
+  static auto Open(const std::string &name, std::string &reason)
+      -> std::optional<ShmTransport> {
+    const auto fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) {
+      reason = "can't open '" + name + "' (" + std::strerror(errno) + ")";
+      return std::nullopt;
+    }
+
+    struct stat info = {};
+    if (::fstat(fd, &info) != 0) {
+      reason = "can't stat '" + name + "' (" + std::strerror(errno) + ")";
+      ::close(fd);
+      return std::nullopt;
+    }
+
+    const auto bytes = static_cast<std::size_t>(info.st_size);
+    if (bytes < sizeof(ShmTransportHeader)) {
+      reason = "'" + name + "' isn't a transport (size: " +
+               std::to_string(bytes) + ")";
+      ::close(fd);
+      return std::nullopt;
+    }
+
+    auto transport = Map(fd, bytes, name, reason);
+    if (!transport.has_value()) return std::nullopt;
+
+    const auto &header = transport->Header();
+    if ((header.magic.load(std::memory_order_acquire) !=
+         ShmTransportHeader::kMagic) ||
+        (header.version != ShmTransportHeader::kVersion) ||
+        (header.size != sizeof(ShmTransportHeader)) ||
+        (header.capacity == 0) ||
+        ((header.capacity & (header.capacity - 1)) != 0) ||
+        (Bytes(header.x_size, header.y_size, header.capacity) != bytes)) {
+      reason = "'" + name + "' isn't an initialized transport of version " +
+               std::to_string(ShmTransportHeader::kVersion);
+      return std::nullopt;
+    }
+
+    transport->InitRings();
+    return transport;
+  }
+
+  ShmTransport(const ShmTransport &) = delete;
+  ShmTransport &operator=(const ShmTransport &) = delete;
+
+  ShmTransport(ShmTransport &&other) noexcept { Swap(other); }
+
+  ShmTransport &operator=(ShmTransport &&other) noexcept {
+    if (this != &other) {
+      Release();
+      Swap(other);
+    }
+    return *this;
+  }
+
+  ~ShmTransport() noexcept { Release(); }
+
+  /// \return The number of values of a state X
+  auto XSize() const noexcept -> std::size_t { return m_states.Values(); }
+
+  /// \return The number of values of a command Y
+  auto YSize() const noexcept -> std::size_t { return m_commands.Values(); }
+
+  /// \return The number of slots of each ring
+  auto Capacity() const noexcept -> std::size_t {
+    return m_states.Capacity();
+  }
+
+  /// \return The process of the controller
+  auto ControllerPid() const noexcept -> std::int64_t { return Header().pid; }
+
+  /// \return The states ring: DRIVER producing, CONTROLLER consuming
+  auto States() noexcept -> ShmRing & { return m_states; }
+
+  /// \return The commands ring: CONTROLLER producing, DRIVER consuming
+  auto Commands() noexcept -> ShmRing & { return m_commands; }
+
+ private:
+  ShmTransport() = default;
+
+  /// \return The bytes of a slot of \a values, rounded up to cache lines
+  static constexpr auto SlotBytes(std::size_t values) noexcept
+      -> std::size_t {
+    return (((sizeof(ShmSlot) + (values * sizeof(double))) + 63) / 64) * 64;
+  }
+
+  /// \return The bytes of the whole mapping
+  static constexpr auto Bytes(std::size_t x_size, std::size_t y_size,
+                              std::size_t capacity) noexcept -> std::size_t {
+    return sizeof(ShmTransportHeader) +
+           (capacity * (SlotBytes(x_size) + SlotBytes(y_size)));
+  }
+
+  /// Map (read/write) the \a bytes of \a fd, closed, named \a name
+  static auto Map(int fd, std::size_t bytes, const std::string &name,
+                  std::string &reason) -> std::optional<ShmTransport> {
+    void *const base =
+        ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const auto mmap_error = errno;
+    ::close(fd); // The mapping stays valid
+
+    if (base == MAP_FAILED) {
+      reason = "can't mmap '" + name + "' (" + std::strerror(mmap_error) + ")";
+      return std::nullopt;
+    }
+
+    auto transport = ShmTransport{};
+    transport.m_base = static_cast<std::uint8_t *>(base);
+    transport.m_bytes = bytes;
+    transport.m_name = name;
+    return transport;
+  }
+
+  auto Header() const noexcept -> ShmTransportHeader & {
+    return *std::launder(reinterpret_cast<ShmTransportHeader *>(m_base));
+  }
+
+  /// Set up the views of the rings, given the header
+  auto InitRings() noexcept -> void {
+    auto &header = Header();
+    const std::size_t x_size = header.x_size;
+    const std::size_t y_size = header.y_size;
+    const std::size_t capacity = header.capacity;
+
+    auto *const states = m_base + sizeof(ShmTransportHeader);
+    auto *const commands = states + (capacity * SlotBytes(x_size));
+    m_states = ShmRing{header.states, states,   SlotBytes(x_size),
+                       x_size,        capacity, header.wakeup};
+    m_commands = ShmRing{header.commands, commands, SlotBytes(y_size),
+                         y_size,          capacity, header.wakeup};
+  }
+
+  auto Swap(ShmTransport &other) noexcept -> void {
+    std::swap(m_base, other.m_base);
+    std::swap(m_bytes, other.m_bytes);
+    std::swap(m_name, other.m_name);
+    std::swap(m_owner, other.m_owner);
+    std::swap(m_states, other.m_states);
+    std::swap(m_commands, other.m_commands);
+  }
+
+  auto Release() noexcept -> void {
+    if (m_base == nullptr) return;
+
+    if (m_owner) {
+      Header().magic.store(0, std::memory_order_release);
+      ::shm_unlink(m_name.c_str());
+    }
+    ::munmap(m_base, m_bytes);
+    m_base = nullptr;
+  }
+
+  std::uint8_t *m_base = nullptr;
+  std::size_t m_bytes = 0;
+  std::string m_name = {};
+  bool m_owner = false; /*!< Created (and unlinked) by this process */
+
+  ShmRing m_states;
+  ShmRing m_commands;
+};
+
+} // namespace lfc
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+
+// lfc
+#include "lfc/lockfree/histogram.hpp"
+#include "lfc/lockfree/seqlock.hpp"
+#include "lfc/perf_counters.hpp"
+
+namespace lfc {
+
+/// Counters of the control path, updated at each control step
+struct StatsCounters {
+  std::uint64_t ticks = 0;           /*!< Control steps (solve + publish) */
+  std::uint64_t deadline_misses = 0; /*!< Steps exceeding the deadline */
+  std::uint64_t model_version = 0;   /*!< Patches applied to the model */
+  std::int64_t last_tick_ns = 0;     /*!< Steady clock time of the last step */
+  std::array<char, 32> kernel = {};  /*!< Gains kernel (null terminated) */
+};
+
+/**
+ *  \brief Stats of the control path, laid out to be shared with other
+ *         processes (e.g. see CreateSharedStatsPage())
+ *
+ *  Written by the controller only, without any lock nor syscall:
+ *  - counters: by the thread solving, at each control step (seqlock);
+ *  - dropped: by any thread dropping a JointState;
+ *  - histograms (latencies in ns, hardware events per solve): by the thread
+ *    solving (wait free).
+ *
+ *  Readers must check the magic (set last), the version and the size before
+ *  trusting anything else (see OpenSharedStatsPage()).
+ */
+struct StatsPage {
+  static constexpr std::uint64_t kMagic = 0x5441545343464c00; /* "\0LFCSTAT" */
+  static constexpr std::uint32_t kVersion = 2;
+  using histogram_t = lockfree::Histogram<>;
+
+  std::atomic<std::uint64_t> magic = 0; /*!< kMagic once initialized */
+  std::uint32_t version = kVersion;
+  std::uint32_t size = sizeof(StatsPage);
+  std::int64_t pid = 0; /*!< Process of the controller */
+
+  lockfree::Seqlock<StatsCounters> counters;
+  std::atomic<std::uint64_t> dropped = 0; /*!< JointStates dropped */
+
+  histogram_t receive_to_solve; /*!< JointState received -> solve start */
+  histogram_t solve;            /*!< Solve duration */
+  histogram_t solve_to_publish; /*!< Solve end -> command published */
+  histogram_t end_to_end;       /*!< JointState header.stamp -> published */
+
+  /// Hardware events per solve (indexed by PerfEvent), only when measured
+  std::array<histogram_t, kPerfEventCount> perf;
+};
+
+inline auto OpenSharedStatsPage(const std::string &name, std::string &reason)
+    -> std::shared_ptr<const StatsPage>;
+
+namespace details {
+
+/// \return True when \a name holds a StatsPage whose controller is gone
+///         (e.g. crashed, without unlinking it)
+inline auto IsOrphanStatsPage(const std::string &name) -> bool {
+  auto reason = std::string{};
+  const auto page = OpenSharedStatsPage(name, reason);
+  return (page != nullptr) && (::kill(static_cast<pid_t>(page->pid), 0) != 0) &&
+         (errno == ESRCH);
+}
+
+} // namespace details
+
+/**
+ *  \brief Create the POSIX shared memory object \a name (e.g. "/lfc"),
+ *         holding a new StatsPage, mapped read/write
+ *
+ *  The object of another live controller is never taken over: \a name must
+ *  not exist, unless it holds the page of a controller that is gone (which
+ *  is replaced). The shared memory object is unlinked once the page returned
+ *  is released, unless it isn't this one anymore.
+ *
+ *  \param[out] reason Reason of the failure, if any
+ *
+ *  \return The page, nullptr on failure
+ */
+inline auto CreateSharedStatsPage(const std::string &name,
+                                  std::string &reason)
+    -> std::shared_ptr<StatsPage> {
+  // Readable by anyone (monitoring), writable by the controller only
+  constexpr auto kMode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+  constexpr auto kFlags = O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC;
+  auto fd = ::shm_open(name.c_str(), kFlags, kMode);
+  auto error = errno;
+  if ((fd < 0) && (error == EEXIST) && details::IsOrphanStatsPage(name)) {
+    ::shm_unlink(name.c_str());
+    fd = ::shm_open(name.c_str(), kFlags, kMode);
+    error = errno;
+  }
+
+  if (fd < 0) {
+    reason = (error == EEXIST)
+                 ? "'" + name + "' already exists (used by another "
+                       "controller, or not a stats page)"
+                 : "can't open '" + name + "' (" + std::strerror(error) +
+                       ")";
+    return nullptr;
+  }
+
+  constexpr auto kSize = sizeof(StatsPage);
+  struct stat info = {};
+  if ((::ftruncate(fd, static_cast<off_t>(kSize)) != 0) ||
+      (::fstat(fd, &info) != 0)) {
+    reason = "can't resize '" + name + "' (" + std::strerror(errno) + ")";
+    ::close(fd);
+    ::shm_unlink(name.c_str());
+    return nullptr;
+  }
+
+  void *const base =
+      ::mmap(nullptr, kSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  const auto mmap_error = errno;
+  ::close(fd); // The mapping stays valid
+
+  if (base == MAP_FAILED) {
+    reason = "can't mmap '" + name + "' (" + std::strerror(mmap_error) + ")";
+    ::shm_unlink(name.c_str());
+    return nullptr;
+  }
+
+  auto *const page = new (base) StatsPage{};
+  page->pid = ::getpid();
+  page->magic.store(StatsPage::kMagic, std::memory_order_release);
+
+  const auto device = info.st_dev;
+  const auto inode = info.st_ino;
+  return std::shared_ptr<StatsPage>(page, [name, device,
+                                           inode](StatsPage *ptr) {
+    ptr->magic.store(0, std::memory_order_release);
+    ptr->~StatsPage();
+    ::munmap(ptr, kSize);
+
+    // Never unlink the object of another controller (e.g. when this one
+    // has been removed by hand, and the name reused)
+    const auto owned = ::shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (owned < 0) return;
+
+    struct stat current = {};
+    if ((::fstat(owned, &current) == 0) && (current.st_dev == device) &&
+        (current.st_ino == inode)) {
+      ::shm_unlink(name.c_str());
+    }
+    ::close(owned);
+  });
+}
+
+/**
+ *  \brief Map (read only) the StatsPage held by the POSIX shared memory
+ *         object \a name, created by CreateSharedStatsPage()
+ *
+ *  \param[out] reason Reason of the failure (e.g. version mismatch), if any
+ *
+ *  \return The page, nullptr on failure
+ */
+inline auto OpenSharedStatsPage(const std::string &name, std::string &reason)
+    -> std::shared_ptr<const StatsPage> {
+  const auto fd = ::shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+  if (fd < 0) {
+    reason = "can't open '" + name + "' (" + std::strerror(errno) + ")";
+    return nullptr;
+  }
+
+  struct stat info = {};
+  if (::fstat(fd, &info) != 0) {
+    reason = "can't stat '" + name + "' (" + std::strerror(errno) + ")";
+    ::close(fd);
+    return nullptr;
+  }
+
+  constexpr auto kSize = sizeof(StatsPage);
+  if (static_cast<std::size_t>(info.st_size) != kSize) {
+    reason = "'" + name + "' isn't a stats page of this version (size: " +
+             std::to_string(info.st_size) + ", expecting " +
+             std::to_string(kSize) + ")";
+    ::close(fd);
+    return nullptr;
+  }
+
+  void *const base = ::mmap(nullptr, kSize, PROT_READ, MAP_SHARED, fd, 0);
+  const auto mmap_error = errno;
+  ::close(fd); // The mapping stays valid
+
+  if (base == MAP_FAILED) {
+    reason = "can't mmap '" + name + "' (" + std::strerror(mmap_error) + ")";
+    return nullptr;
+  }
+
+  auto page = std::shared_ptr<const StatsPage>(
+      static_cast<const StatsPage *>(base), [](const StatsPage *ptr) {
+        ::munmap(const_cast<StatsPage *>(ptr), kSize);
+      });
+
+  if ((page->magic.load(std::memory_order_acquire) != StatsPage::kMagic) ||
+      (page->version != StatsPage::kVersion) || (page->size != kSize)) {
+    reason = "'" + name + "' isn't an initialized stats page of version " +
+             std::to_string(StatsPage::kVersion);
+    return nullptr;
+  }
+
+  return page;
+}
+
+} // namespace lfc
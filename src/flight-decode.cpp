@@ -0,0 +1,86 @@
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include "lfc/flight_recorder.hpp"
+
+namespace {
+
+constexpr std::string_view kUsage =
+    "Usage: lfc-flight-decode [OPTIONS] <DUMP>\n"
+    "\n"
+    "Decode a flight recorder dump of an lfc node (see its\n"
+    "'flight_recorder/*' parameters and '~/dump_flight_recorder' service)\n"
+    "into CSV, one record per line, oldest first:\n"
+    "  sequence,model_version,time_ns,stamp_ns,x_0,...,x_N,y_0,...,y_M\n"
+    "\n"
+    "Options:\n"
+    "  --summary   Only print the dump header\n";
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  auto path = std::string{};
+  auto summary = false;
+
+  for (int i = 1; i < argc; ++i) {
+    const auto arg = std::string_view{argv[i]};
+    if (arg == "--summary") {
+      summary = true;
+    } else if (path.empty() && !arg.empty() && (arg[0] != '-')) {
+      path = arg;
+    } else {
+      path.clear();
+      break;
+    }
+  }
+
+  if (path.empty()) {
+    std::fputs(kUsage.data(), stderr);
+    return 1;
+  }
+
+  auto header = lfc::FlightDumpHeader{};
+  auto reason = std::string{};
+  const auto records = lfc::LoadFlightDump(path, header, reason);
+  if (!records.has_value()) {
+    std::fprintf(stderr, "lfc-flight-decode: %s\n", reason.c_str());
+    return 1;
+  }
+
+  if (summary) {
+    std::printf("%s: %zu records (of %lu recorded), x: %lu, y: %lu",
+                path.c_str(), records->size(), header.recorded,
+                header.x_size, header.y_size);
+    if (!records->empty()) {
+      std::printf(", sequences: [%lu, %lu], model versions: [%lu, %lu]",
+                  records->front().sequence, records->back().sequence,
+                  records->front().model_version,
+                  records->back().model_version);
+    }
+    std::printf("\n");
+    return 0;
+  }
+
+  std::printf("sequence,model_version,time_ns,stamp_ns");
+  for (std::uint64_t i = 0; i < header.x_size; ++i) std::printf(",x_%lu", i);
+  for (std::uint64_t i = 0; i < header.y_size; ++i) std::printf(",y_%lu", i);
+  std::printf("\n");
+
+  for (const auto &record : *records) {
+    std::printf("%lu,%lu,%ld,%ld", record.sequence, record.model_version,
+                record.time_ns, record.stamp_ns);
+    for (const auto value : record.x) std::printf(",%.17g", value);
+    for (const auto value : record.y) std::printf(",%.17g", value);
+    std::printf("\n");
+  }
+
+  // Records overwritten while being dumped
+  if (records->size() != header.count) {
+    std::fprintf(stderr, "lfc-flight-decode: %lu torn records dropped\n",
+                 header.count - records->size());
+  }
+
+  return 0;
+}
@@ -0,0 +1,106 @@
+#include "diagnostics.hpp"
+
+// System
+#include <array>
+#include <cstdio>
+#include <string_view>
+#include <utility>
+
+namespace lfc::ros {
+
+namespace {
+
+/// Percentiles reported, alongside their key suffix
+constexpr std::array<std::pair<double, const char *>, 4> kPercentiles = {{
+    {50., "p50"},
+    {90., "p90"},
+    {99., "p99"},
+    {99.9, "p99.9"},
+}};
+
+/// \return \a value divided by \a scale, formatted with 1 decimal
+auto Format(double value, double scale) -> std::string {
+  std::array<char, 32> buffer = {};
+  std::snprintf(buffer.data(), buffer.size(), "%.1f", value / scale);
+  return buffer.data();
+}
+
+/**
+ *  \brief Append the count, mean, percentiles and max of \a histogram to
+ *         \a status, as durations (us) when \a is_ns is set, raw values
+ *         otherwise
+ */
+auto AppendHistogram(std::string_view name,
+                     const StatsPage::histogram_t &histogram, bool is_ns,
+                     diagnostic_msgs::msg::DiagnosticStatus &status) -> void {
+  const auto scale = is_ns ? 1e3 : 1.;
+  const auto key = [&](std::string_view suffix) {
+    return std::string{name} + " " + std::string{suffix} +
+           (is_ns ? " (us)" : "");
+  };
+  const auto append = [&](std::string k, std::string v) {
+    auto &value = status.values.emplace_back();
+    value.key = std::move(k);
+    value.value = std::move(v);
+  };
+
+  append(std::string{name} + " count", std::to_string(histogram.Count()));
+  append(key("mean"), Format(histogram.Mean(), scale));
+  for (const auto &[percentile, suffix] : kPercentiles) {
+    append(key(suffix),
+           Format(static_cast<double>(histogram.ValueAtPercentile(percentile)),
+                  scale));
+  }
+  append(key("max"), Format(static_cast<double>(histogram.Max()), scale));
+}
+
+} // namespace
+
+auto MakeDiagnosticStatus(const ControlPathStats &stats,
+                          const std::string &name,
+                          std::uint64_t &reported_misses)
+    -> diagnostic_msgs::msg::DiagnosticStatus {
+  auto status = diagnostic_msgs::msg::DiagnosticStatus{};
+  status.name = name;
+
+  const auto &page = *stats.page;
+  AppendHistogram("receive to solve", page.receive_to_solve, true, status);
+  AppendHistogram("solve", page.solve, true, status);
+  AppendHistogram("solve to publish", page.solve_to_publish, true, status);
+  AppendHistogram("end to end", page.end_to_end, true, status);
+  for (std::size_t i = 0; i < kPerfEventCount; ++i) {
+    if (page.perf[i].Count() == 0) continue;
+    AppendHistogram("solve " + std::string{ToString(PerfEvent{i})},
+                    page.perf[i], false, status);
+  }
+
+  const auto counters = page.counters.Load();
+  const auto misses = counters.deadline_misses;
+  for (const auto &[key, count] : {
+           std::pair{"ticks", counters.ticks},
+           std::pair{"deadline misses", misses},
+           std::pair{"dropped",
+                     page.dropped.load(std::memory_order_relaxed)},
+       }) {
+    auto &value = status.values.emplace_back();
+    value.key = key;
+    value.value = std::to_string(count);
+  }
+
+  if (stats.deadline <= ControlPathStats::clock::duration::zero()) {
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+    status.message = "No deadline";
+  } else if (misses > reported_misses) {
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+    status.message = std::to_string(misses - reported_misses) +
+                     " deadline misses since the last report";
+  } else {
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+    status.message = "No deadline miss since the last report";
+  }
+
+  reported_misses = misses;
+  return status;
+}
+
+} // namespace lfc::ros
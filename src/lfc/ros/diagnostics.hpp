@@ -0,0 +1,29 @@
+#pragma once
+
+// SYSTEM
+#include <cstdint>
+#include <string>
+
+// INTERNAL
+#include "lfc/runtime/control_path_stats.hpp"
+
+// EXT
+// -- ROS
+#include "diagnostic_msgs/msg/diagnostic_status.hpp"
+
+namespace lfc::ros {
+
+/**
+ *  \return The diagnostic (named \a name) of the control path \a stats: the
+ *          percentiles (us) of every latency, the deadline misses, the
+ *          JointStates dropped and the hardware events per solve (if any)
+ *
+ *  \param[inout] reported_misses The deadline misses already reported: the
+ *                status is a WARN when new misses occurred since
+ */
+auto MakeDiagnosticStatus(const ControlPathStats &stats,
+                          const std::string &name,
+                          std::uint64_t &reported_misses)
+    -> diagnostic_msgs::msg::DiagnosticStatus;
+
+} // namespace lfc::ros
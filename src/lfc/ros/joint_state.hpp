@@ -0,0 +1,89 @@
+#pragma once
+
+// SYSTEM
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// EXT
+// -- Eigen
+#include "Eigen/Core"
+
+// -- ROS
+#include "sensor_msgs/msg/joint_state.hpp"
+
+namespace lfc::ros {
+
+/// JointState fields that can be gathered into the state vector X (in the
+/// order of the message definition)
+enum class JointStateField {
+  kPosition,
+  kVelocity,
+  kEffort,
+};
+
+constexpr auto ToString(JointStateField field) noexcept -> std::string_view {
+  switch (field) {
+    case JointStateField::kPosition: return "position";
+    case JointStateField::kVelocity: return "velocity";
+    case JointStateField::kEffort: return "effort";
+  }
+
+  return "";
+}
+
+/// \return The JointStateField named \a name, std::nullopt if unknown
+constexpr auto JointStateFieldFrom(std::string_view name) noexcept
+    -> std::optional<JointStateField> {
+  for (auto field : {JointStateField::kPosition, JointStateField::kVelocity,
+                     JointStateField::kEffort}) {
+    if (ToString(field) == name) return field;
+  }
+  return std::nullopt;
+}
+
+/// \return The values of \a msg associated to \a field
+inline auto ValuesOf(const sensor_msgs::msg::JointState &msg,
+                     JointStateField field) noexcept
+    -> const std::vector<double> & {
+  switch (field) {
+    case JointStateField::kPosition: return msg.position;
+    case JointStateField::kVelocity: return msg.velocity;
+    case JointStateField::kEffort: break;
+  }
+  return msg.effort;
+}
+
+/**
+ *  \brief Concatenate the \a fields values of \a msg into \a x
+ *
+ *  \param[in] msg The JointState we wish to gather values from
+ *  \param[in] fields Ordered list of fields copied into X
+ *  \param[out] x The state vector, untouched when returning false
+ *
+ *  \return True on success, false when the total number of values doesn't
+ *          match x.size()
+ */
+inline auto GatherInto(const sensor_msgs::msg::JointState &msg,
+                       const std::vector<JointStateField> &fields,
+                       Eigen::Ref<Eigen::VectorXd> x) noexcept -> bool {
+  Eigen::Index expected_size = 0;
+  for (auto field : fields) {
+    expected_size += static_cast<Eigen::Index>(ValuesOf(msg, field).size());
+  }
+
+  if (expected_size != x.size()) return false;
+
+  Eigen::Index offset = 0;
+  for (auto field : fields) {
+    const auto &values = ValuesOf(msg, field);
+    const auto size = static_cast<Eigen::Index>(values.size());
+    x.segment(offset, size) =
+        Eigen::Map<const Eigen::VectorXd>(values.data(), size);
+    offset += size;
+  }
+
+  return true;
+}
+
+} // namespace lfc::ros
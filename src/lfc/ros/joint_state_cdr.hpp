@@ -0,0 +1,227 @@
+#pragma once
+
+// SYSTEM
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// INTERNAL
+#include "joint_state.hpp"
+
+// EXT
+// -- Eigen
+#include "Eigen/Core"
+
+// -- ROS
+#include "builtin_interfaces/msg/time.hpp"
+
+namespace lfc::ros {
+
+/**
+ *  \brief Minimal reader of a CDR (XCDR1, little endian) serialized buffer
+ *
+ *  Alignments are relative to the end of the 4 bytes encapsulation header, as
+ *  done by the ROS 2 middlewares. Any out of bound read puts the reader in
+ *  error (see Ok()), and all subsequent reads fail.
+ */
+class CdrReader {
+  static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+                "Only little endian hosts are supported");
+
+ public:
+  /// Wrap the \a size bytes of \a data (including the encapsulation header)
+  CdrReader(const std::uint8_t *data, std::size_t size) noexcept
+      : m_data(data), m_size(size) {
+    // Encapsulation: {0x00, 0x01 (CDR_LE), options (2 bytes)}
+    m_ok = (m_data != nullptr) && (m_size >= kHeaderSize) &&
+           (m_data[0] == 0x00) && (m_data[1] == 0x01);
+    m_pos = kHeaderSize;
+  }
+
+  /// \return False if any of the previous operations failed
+  constexpr auto Ok() const noexcept -> bool { return m_ok; }
+
+  /// \return The current position, in bytes, from the start of the buffer
+  constexpr auto Position() const noexcept -> std::size_t { return m_pos; }
+
+  /// \return A ptr to the byte at \a pos (from the start of the buffer)
+  constexpr auto At(std::size_t pos) const noexcept -> const std::uint8_t * {
+    return m_data + pos;
+  }
+
+  /// Skip the padding needed to read an element of \a alignment bytes
+  constexpr auto Align(std::size_t alignment) noexcept -> bool {
+    // Not even an encapsulation: m_pos may be beyond m_size
+    if (!m_ok) return false;
+
+    const auto misalignment = (m_pos - kHeaderSize) % alignment;
+    return (misalignment == 0) || Skip(alignment - misalignment);
+  }
+
+  /// Skip \a bytes bytes
+  constexpr auto Skip(std::size_t bytes) noexcept -> bool {
+    m_ok = m_ok && (bytes <= (m_size - m_pos));
+    if (m_ok) m_pos += bytes;
+    return m_ok;
+  }
+
+  /// Read a 4 bytes (aligned) unsigned integer into \a v
+  auto Read(std::uint32_t &v) noexcept -> bool {
+    return ReadRaw(&v, sizeof(v));
+  }
+
+  /// Read a 4 bytes (aligned) signed integer into \a v
+  auto Read(std::int32_t &v) noexcept -> bool { return ReadRaw(&v, sizeof(v)); }
+
+  /// Skip a string (length, including the null terminator, then chars)
+  auto SkipString() noexcept -> bool {
+    std::uint32_t length = 0;
+    return Read(length) && Skip(length);
+  }
+
+  /**
+   *  \brief Locate a sequence of doubles, without copying it
+   *
+   *  \param[out] values Ptr to the first (unaligned) value in the buffer
+   *  \param[out] count Number of values
+   */
+  auto LocateDoubles(const std::uint8_t *&values, std::size_t &count) noexcept
+      -> bool {
+    std::uint32_t size = 0;
+    if (!Read(size)) return false;
+
+    count = size;
+    // Padding is only inserted when the sequence isn't empty
+    if ((count > 0) && !Align(sizeof(double))) return false;
+
+    values = At(m_pos);
+    return (count <= ((m_size - m_pos) / sizeof(double))) &&
+           Skip(count * sizeof(double));
+  }
+
+ private:
+  static constexpr std::size_t kHeaderSize = 4;
+
+  auto ReadRaw(void *v, std::size_t bytes) noexcept -> bool {
+    if (!Align(bytes)) return false;
+    if (bytes > (m_size - m_pos)) return (m_ok = false);
+
+    std::memcpy(v, At(m_pos), bytes);
+    m_pos += bytes;
+    return true;
+  }
+
+  const std::uint8_t *m_data;
+  std::size_t m_size;
+  std::size_t m_pos = 0;
+  bool m_ok = false;
+};
+
+/// Cheap fingerprint of the serialized JointState names, compared between
+/// messages instead of decoding (and allocating) the names
+struct JointNamesLayout {
+  std::size_t bytes = 0;   /*!< Size of the serialized names */
+  std::uint64_t hash = 0;  /*!< FNV-1a hash of the serialized names */
+
+  friend constexpr auto operator==(const JointNamesLayout &lhs,
+                                   const JointNamesLayout &rhs) noexcept
+      -> bool {
+    return (lhs.bytes == rhs.bytes) && (lhs.hash == rhs.hash);
+  }
+
+  friend constexpr auto operator!=(const JointNamesLayout &lhs,
+                                   const JointNamesLayout &rhs) noexcept
+      -> bool {
+    return !(lhs == rhs);
+  }
+};
+
+/// \return The 64 bits FNV-1a hash of the \a size bytes of \a data
+constexpr auto Fnv1a(const std::uint8_t *data, std::size_t size) noexcept
+    -> std::uint64_t {
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+  for (std::size_t i = 0; i < size; ++i) {
+    hash = (hash ^ data[i]) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+/// Outcome of the partial parsing of a serialized JointState
+enum class CdrStatus {
+  kOk,
+  kMalformed,    /*!< Not a (little endian) CDR serialized JointState */
+  kSizeMismatch, /*!< The fields values don't match x.size() */
+};
+
+/**
+ *  \brief Partially parse a CDR serialized sensor_msgs/JointState
+ *
+ *  Only the stamp and the requested \a fields are decoded (directly into
+ *  \a x). The frame id and the names are skipped, the names layout being only
+ *  fingerprinted into \a names.
+ *
+ *  \param[in] data The serialized message (including the encapsulation)
+ *  \param[in] size Size of the serialized message, in bytes
+ *  \param[in] fields Ordered list of fields copied into X
+ *  \param[out] x The state vector, untouched unless returning kOk
+ *  \param[out] stamp The message header stamp
+ *  \param[out] names The layout of the message names
+ */
+inline auto GatherSerializedInto(const std::uint8_t *data, std::size_t size,
+                                 const std::vector<JointStateField> &fields,
+                                 Eigen::Ref<Eigen::VectorXd> x,
+                                 builtin_interfaces::msg::Time &stamp,
+                                 JointNamesLayout &names) noexcept
+    -> CdrStatus {
+  auto reader = CdrReader{data, size};
+
+  // header
+  reader.Read(stamp.sec);
+  reader.Read(stamp.nanosec);
+  reader.SkipString(); // frame_id
+
+  // name
+  std::uint32_t names_count = 0;
+  reader.Read(names_count);
+  const auto names_begin = reader.Position();
+  for (std::uint32_t i = 0; reader.Ok() && (i < names_count); ++i) {
+    reader.SkipString();
+  }
+
+  if (!reader.Ok()) return CdrStatus::kMalformed;
+  names.bytes = reader.Position() - names_begin;
+  names.hash = Fnv1a(reader.At(names_begin), names.bytes);
+
+  // position, velocity, effort (same order as JointStateField)
+  struct Span {
+    const std::uint8_t *values = nullptr;
+    std::size_t count = 0;
+  };
+  std::array<Span, 3> spans = {};
+  for (auto &span : spans) {
+    if (!reader.LocateDoubles(span.values, span.count)) {
+      return CdrStatus::kMalformed;
+    }
+  }
+
+  Eigen::Index expected_size = 0;
+  for (auto field : fields) {
+    expected_size +=
+        static_cast<Eigen::Index>(spans[static_cast<std::size_t>(field)].count);
+  }
+
+  if (expected_size != x.size()) return CdrStatus::kSizeMismatch;
+
+  Eigen::Index offset = 0;
+  for (auto field : fields) {
+    const auto &span = spans[static_cast<std::size_t>(field)];
+    std::memcpy(x.data() + offset, span.values, span.count * sizeof(double));
+    offset += static_cast<Eigen::Index>(span.count);
+  }
+
+  return CdrStatus::kOk;
+}
+
+} // namespace lfc::ros
@@ -1,38 +1,622 @@
 #include "lfc/ros/linear_feedback_node.hpp"
+#include "lfc/ros/linear_feedback_lifecycle_node.hpp"
 
 // System
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
 #include <cstdarg>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <deque>
+#include <optional>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <variant>
+#include <vector>
 
 // Internal lfc - PUBLIC
-#include "lfc/linear_model.hpp"
+#include "lfc/flight_recorder.hpp"
+#include "lfc/lockfree/mailbox.hpp"
+#include "lfc/lockfree/spsc_ring.hpp"
+#include "lfc/probes.h"
+#include "lfc/runtime/config.hpp"
+#include "lfc/runtime/control_step.hpp"
+#include "lfc/runtime/gains.hpp"
+#include "lfc/runtime/state_fusion.hpp"
+#include "lfc/shm_transport.hpp"
 
 // Internal lfc - PRIVATE
+#include "diagnostics.hpp"
+#include "joint_state.hpp"
+#include "joint_state_cdr.hpp"
 #include "macros.h"
 #include "params/declare_params.hpp"
 #include "params/eigen.hpp"
+#include "params/raw.hpp"
+#include "shard.hpp"
+#include "state_source.hpp"
 
 // Ext libs
 // -- Eigen
 #include "Eigen/Core"
 
 // -- ROS
+#include "rcl_interfaces/msg/set_parameters_result.hpp"
+#include "rclcpp/create_publisher.hpp"
 #include "rclcpp/exceptions/exceptions.hpp"
 #include "rclcpp/logging.hpp"
 #include "rclcpp/qos.hpp"
+#include "rclcpp/serialized_message.hpp"
+#include "rclcpp/utilities.hpp"
+#include "rclcpp/wait_set.hpp"
 
 namespace lfc::ros {
 
-using gains_t = Eigen::MatrixXd;
-using offset_t = Eigen::VectorXd;
-
 using joint_state_t = sensor_msgs::msg::JointState;
 using input_t = Eigen::VectorXd;
+using output_t = Eigen::VectorXd;
+
+/// State X gathered from a JointState, alongside its stamp
+struct StampedState {
+  builtin_interfaces::msg::Time stamp = builtin_interfaces::msg::Time{};
+  input_t x = input_t{};
+
+  /// When the JointState was received (before being gathered)
+  ControlPathStats::clock::time_point received = {};
+};
+
+/// Outcome of gathering a StampedState from a (serialized) JointState
+enum class GatherStatus {
+  kOk,
+  kSizeMismatch, /*!< The fields values don't match the gains cols */
+  kMalformed,    /*!< Serialized only: not a CDR serialized JointState */
+  kNamesChanged, /*!< Serialized only: names differ from the first message */
+  kStale,        /*!< The JointState, or a state source, is too old (or
+                      being written, see FuseSources()) */
+  kPipelineFull, /*!< Pipelined only: the solver thread lags behind */
+  kSuperseded,   /*!< Shm only: newer state received before being solved */
+  kCommandsFull, /*!< Shm only: the driver doesn't consume its commands */
+  kUnordered,    /*!< Shard only: zero, or not increasing, stamp (see
+                      ShardSequence()) */
+};
+
+/// What a stream of JointState latches from its messages
+struct StreamLatch {
+  /// Serialized only: names layout latched from the first valid message
+  std::optional<JointNamesLayout> names = std::nullopt;
+  /// Shard only: sequence of the last state gathered (see ShardSequence())
+  std::uint64_t shard_sequence = 0;
+};
+
+/// Fusion only: one of the typed inputs (see 'state/sources') gathered into
+/// its own segment of X, after the JointState values (see StateFusion)
+struct StateSource {
+  StateSource(std::string source_name, std::string source_topic,
+              SourceFields source_fields, Eigen::Index source_start,
+              Eigen::Index source_size,
+              ControlPathStats::clock::duration source_max_age)
+      : name(std::move(source_name)),
+        topic(std::move(source_topic)),
+        fields(std::move(source_fields)),
+        start(source_start),
+        size(source_size),
+        max_age(source_max_age),
+        scratch(Eigen::VectorXd::Zero(source_size)) {}
+
+  std::string name;
+  std::string topic;
+  SourceFields fields;
+  Eigen::Index start; /*!< First value of the segment of X */
+  Eigen::Index size;  /*!< Values of the segment of X */
+
+  /// Age beyond which its values are stale (never when zero)
+  ControlPathStats::clock::duration max_age;
+
+  Eigen::VectorXd scratch; /*!< Subscription only: preallocated values */
+};
 
 struct LinearFeedbackNodeImpl {
-  gains_t gains = gains_t{};
-  offset_t offset = offset_t{};
+  /// Model solved by the control path (model writer: the parameters callback
+  /// or the streamed gains, both from the default callback group), alongside
+  /// the latencies, hardware counters and flight recorder of its solves
+  std::unique_ptr<ControlStep> step = nullptr;
+
+  /// Shard only: first row of the gains/offset solved (see 'shard/*')
+  std::optional<std::size_t> shard = std::nullopt;
+
+  /// Parameters only: storage order of the 'gains/values'
+  StorageOrder values_order = StorageOrder::kRowMajor;
+
+  /// Parameters only: blocks patched by the 'gains|offset/patch/values'
+  ModelBlock gains_patch_block = ModelBlock{};
+  ModelBlock offset_patch_block = ModelBlock{0, 0, 0, 1};
+
+  std::vector<JointStateField> fields = {};
+  StampedState state = StampedState{};     /*!< Preallocated state X */
+
+  /// Values of X gathered from the JointState, the sources following them
+  Eigen::Index joint_state_size = 0;
+
+  /// Fusion only: sources (not movable, hence the deque), whose newest
+  /// values are snapshotted into X by the control path (see FuseSources()),
+  /// along with the JointState age check (fixed rate only)
+  std::deque<StateSource> sources = {};
+  StateFusion fusion;
+
+  joint_state_t command = joint_state_t{}; /*!< Preallocated Y (as effort) */
+
+  bool serialized = false;
+  StreamLatch latched = StreamLatch{};
+
+  /// Fixed rate only: newest state, written by the subscription
+  lockfree::Mailbox<StampedState> latest_state;
+  bool has_state = false; /*!< Fixed rate only: a state has been fetched */
+
+  /// Batch only: one of the JointState -> command streams sharing the model
+  struct BatchStream {
+    /// Newest state, written by the stream subscription
+    lockfree::Mailbox<StampedState> latest;
+    ControlStep::Stamps stamps = {}; /*!< Of the newest state fetched */
+
+    StreamLatch latched = StreamLatch{};
+    joint_state_t command = joint_state_t{}; /*!< Preallocated Y */
+  };
+
+  /// Batch only: streams (not movable, hence the deque), whose newest
+  /// states are solved together, as the columns of ControlStep::BatchState()
+  std::deque<BatchStream> streams = {};
+  /// Stamps of each stream, nullptr until a state is fetched (see
+  /// ControlStep::StepBatch())
+  std::vector<const ControlStep::Stamps *> batch_stamps = {};
+
+  /// Debug only: copy of a command, for the debug publisher
+  struct DebugCommand {
+    builtin_interfaces::msg::Time stamp = builtin_interfaces::msg::Time{};
+    output_t y = output_t{};
+  };
+
+  /// Debug only (see 'debug/*'): decimated commands, from the control path
+  /// to the debug publisher (dropped when full, never waiting for it)
+  lockfree::SpscRing<DebugCommand, 8> debug;
+  std::size_t debug_decimation = 0; /*!< Commands per copy, 0: disabled */
+  std::size_t debug_skipped = 0;    /*!< Commands since the last copy */
+  joint_state_t debug_command = joint_state_t{}; /*!< Preallocated copy */
+
+  /// Pipeline only: gathered states, from the control path to the solver
+  lockfree::SpscRing<StampedState, 8> pipeline;
+  std::thread solver = std::thread{};
+  std::atomic<bool> solver_running = false;
+
+  RealtimeConfig realtime = RealtimeConfig{};
+  ControlConfig control = ControlConfig{};
+
+  /// Shared memory loop only: states from, and commands to, the driver
+  std::optional<ShmTransport> transport = std::nullopt;
+
+  /// States received are solved only while active (see SetActive())
+  std::atomic<bool> active = false;
+
+  std::uint64_t reported_misses = 0; /*!< Diagnostics only */
+
+  /// Flight recorder (see 'flight_recorder/*') dumped to (on demand or on
+  /// fault)
+  std::string recorder_path = {};
+
+  /// Number of dummy solves done by ControlStep::WarmUp() when configuring
+  static constexpr std::size_t kWarmUpSolves = 1000;
+
+  /// Trajectory only: clock picking the model, when not using the stamps
+  rclcpp::Clock::SharedPtr clock = nullptr;
+
+  /**
+   *  \return The stamps of the control step of the state stamped \a stamp,
+   *          received at \a received, \a probe being arg0 of its probes
+   *
+   *  Trajectory only: its model is picked by the time of \a stamp, or by
+   *  the node clock (see 'trajectory/time').
+   */
+  auto StampsOf(const builtin_interfaces::msg::Time &stamp,
+                ControlPathStats::clock::time_point received,
+                const void *probe) const -> ControlStep::Stamps {
+    const auto time = rclcpp::Time{stamp};
+    auto stamps = ControlStep::Stamps{received, time.nanoseconds(), 0., probe};
+    if (step->Trajectory() != nullptr) {
+      stamps.time =
+          (clock != nullptr) ? clock->now().seconds() : time.seconds();
+    }
+    return stamps;
+  }
+
+  /**
+   *  \brief Solve the command of \a gathered (see ControlStep::Step()),
+   *         publish it through \a output (unless suppressed as unchanged)
+   *
+   *  Probes (arg0 being \a gathered): the ControlStep::Step() ones, then
+   *  'lfc:publish' (arg1/arg2: stamp sec/nanosec, not fired when
+   *  suppressed)
+   */
+  template <class Publisher>
+  auto SolveAndPublish(const StampedState &gathered, Publisher &output)
+      -> void {
+    auto y = Eigen::Map<output_t>(command.effort.data(), step->Rows());
+    command.header.stamp = gathered.stamp;
+
+    step->Step(gathered.x, y,
+               StampsOf(gathered.stamp, gathered.received, &gathered),
+               [&](bool changed) {
+                 if (changed) {
+                   output.publish(command);
+                   LFC_PROBE(publish, &gathered, gathered.stamp.sec,
+                             gathered.stamp.nanosec);
+                 }
+                 PushDebug(gathered.stamp, command.effort.data());
+               });
+  }
+
+  /**
+   *  \brief Solve the newest state of every stream at once (see
+   *         ControlStep::StepBatch()), and publish each command through its
+   *         publisher of \a outputs
+   *
+   *  Streams without any state yet are skipped. Probes, per stream (arg0
+   *  being its state): the ControlStep::StepBatch() ones, then 'lfc:publish'
+   */
+  template <class Publishers>
+  auto SolveBatchAndPublish(Publishers &outputs) -> void {
+    // Only the states fetched are copied: the others are already there
+    for (std::size_t k = 0; k < streams.size(); ++k) {
+      auto &stream = streams[k];
+      if (stream.latest.Fetch()) {
+        const auto &gathered = stream.latest.Front();
+        step->BatchState().col(static_cast<Eigen::Index>(k)) = gathered.x;
+        stream.stamps = StampsOf(gathered.stamp, gathered.received, &gathered);
+        batch_stamps[k] = &stream.stamps;
+      }
+    }
+
+    step->StepBatch(batch_stamps, [&](std::size_t k) {
+      auto &stream = streams[k];
+      const auto &gathered = stream.latest.Front();
+      auto &msg = stream.command;
+      Eigen::Map<output_t>(msg.effort.data(), step->Rows()) =
+          step->BatchCommand().col(static_cast<Eigen::Index>(k));
+      msg.header.stamp = gathered.stamp;
+
+      outputs[k]->publish(msg);
+      LFC_PROBE(publish, &gathered, gathered.stamp.sec,
+                gathered.stamp.nanosec);
+    });
+  }
+
+  /**
+   *  \brief Solve the command of \a driver_state into the next free slot of
+   *         \a commands (echoing the state sequence and stamp), push it to the
+   *         driver and record the latencies of this control step
+   *
+   *  The state is received when the driver stamped it (system clock, right
+   *  before pushing it): the receive -> solve latency includes the transport
+   *  and the wakeup of this thread.
+   *
+   *  Probes (arg0 being \a driver_state): same as SolveAndPublish(),
+   *  'lfc:publish' being fired once the command is pushed
+   */
+  auto SolveShm(const ShmSlot &driver_state, ShmRing &commands) -> void {
+    const auto age = std::chrono::system_clock::now().time_since_epoch() -
+                     std::chrono::nanoseconds{driver_state.stamp_ns};
+    const auto received =
+        ControlPathStats::clock::now() -
+        std::chrono::duration_cast<ControlPathStats::clock::duration>(
+            std::max(age, std::chrono::system_clock::duration::zero()));
+    auto *const slot = commands.TryClaim();
+    if (slot == nullptr) {
+      // The driver doesn't consume its commands: never wait for it
+      step->Stats().Drop();
+      LFC_PROBE(drop, static_cast<int>(GatherStatus::kCommandsFull));
+      return;
+    }
+
+    const auto x =
+        Eigen::Map<const input_t>(driver_state.Values(), step->Cols());
+    auto y = Eigen::Map<output_t>(slot->Values(), step->Rows());
+    const auto stamp = static_cast<builtin_interfaces::msg::Time>(
+        rclcpp::Time{driver_state.stamp_ns});
+
+    // Never suppressed as unchanged (see 'command/on_change/*'). Only
+    // written by this thread: the command is still recorded once pushed
+    step->Step(x, y, StampsOf(stamp, received, &driver_state),
+               [&](bool /* changed */) {
+                 slot->sequence = driver_state.sequence;
+                 slot->stamp_ns = driver_state.stamp_ns;
+                 commands.Commit();
+                 LFC_PROBE(publish, &driver_state, stamp.sec, stamp.nanosec);
+                 PushDebug(stamp, slot->Values());
+               });
+  }
+
+  /**
+   *  \brief Copy the command \a y (of the model rows), stamped with \a stamp,
+   *         for the debug publisher, once every 'debug/decimation' commands
+   *
+   *  Wait free: the copy is dropped when the debug publisher lags behind
+   *  (ring full), the control path never waiting for it.
+   */
+  auto PushDebug(const builtin_interfaces::msg::Time &stamp,
+                 const double *y) noexcept -> void {
+    if ((debug_decimation == 0) || (++debug_skipped < debug_decimation)) {
+      return;
+    }
+    debug_skipped = 0;
+
+    auto *const slot = debug.TryClaim();
+    if (slot == nullptr) return;
+
+    slot->stamp = stamp;
+    slot->y = Eigen::Map<const output_t>(y, slot->y.size());
+    debug.Commit();
+  }
+
+  /// Publish all the debug copies pushed so far through \a output (see
+  /// PushDebug())
+  template <class Publisher>
+  auto PublishDebug(Publisher &output) -> void {
+    for (auto *slot = debug.TryPeek(); slot != nullptr;
+         slot = debug.TryPeek()) {
+      debug_command.effort.assign(slot->y.data(),
+                                  slot->y.data() + slot->y.size());
+      debug_command.header.stamp = slot->stamp;
+      debug.Release();
+
+      output.publish(debug_command);
+    }
+  }
+
+  /**
+   *  \brief Apply the gains/offset values changes found in \a params to the
+   *         model, and post it to the control path
+   *
+   *  Values are either fully replaced ('gains|offset/values'), or patched
+   *  block-wise ('gains|offset/patch/values', at 'gains/patch/block' or
+   *  'offset/patch/segment').
+   *
+   *  The control path never waits on it (see ControlStep::PostPatches()).
+   *  Rejected with a trajectory, whose models replace this one.
+   *
+   *  \return The reason of the failure, if any (nothing is posted)
+   */
+  auto UpdateModel(const std::vector<rclcpp::Parameter> &params)
+      -> std::optional<std::string> {
+    const auto &current = step->Posted();
+
+    for (const auto &param : params) {
+      const auto &name = param.get_name();
+      if ((step->Trajectory() != nullptr) &&
+          ((name.rfind("gains/", 0) == 0) ||
+           (name.rfind("offset/", 0) == 0))) {
+        return "'" + name + "' can't be changed alongside a trajectory (see "
+               "'trajectory/*')";
+      }
+    }
+
+    // Validate everything first, the model is only touched once all the
+    // changes are known to be valid
+    auto gains_block = gains_patch_block;
+    auto offset_block = offset_patch_block;
+    for (const auto &param : params) {
+      const auto &name = param.get_name();
+
+      if (name == "gains/patch/block") {
+        auto block = ModelBlock::From(param.as_integer_array(), false,
+                                      current.gains.Rows(),
+                                      current.gains.Cols());
+        if (!block.has_value()) {
+          return "'gains/patch/block' must be [ROW, COL, ROWS, COLS], within "
+                 "the gains shape";
+        }
+        gains_block = *block;
+      } else if (name == "offset/patch/segment") {
+        auto block = ModelBlock::From(param.as_integer_array(), true,
+                                      current.offset.size(), 1);
+        if (!block.has_value()) {
+          return "'offset/patch/segment' must be [START, SIZE], within the "
+                 "offset size";
+        }
+        offset_block = *block;
+      }
+    }
+
+    // Full updates aren't patches, but invalidate all the previous ones
+    auto full_update = false;
+    auto pending = std::vector<ModelPatch>{};
+    for (const auto &param : params) {
+      const auto &name = param.get_name();
+
+      if (name == "gains/values") {
+        const auto rows = current.gains.Rows();
+        const auto cols = current.gains.Cols();
+        auto &patch = pending.emplace_back(ModelPatch{
+            false, ModelBlock{0, 0, rows, cols}, Eigen::MatrixXd(rows, cols),
+            0});
+        if (!AssignParamValues(param.as_double_array(), patch.values,
+                               values_order)) {
+          return "'gains/values' must contain exactly ROWS*COLS values";
+        }
+        full_update = true;
+      } else if (name == "offset/values") {
+        auto &patch = pending.emplace_back(ModelPatch{
+            true, ModelBlock{0, 0, current.offset.size(), 1}, current.offset,
+            0});
+        if (!AssignParamValues(param.as_double_array(), patch.values)) {
+          return "'offset/values' must contain exactly SIZE values";
+        }
+        full_update = true;
+      } else if ((name == "gains/patch/values") ||
+                 (name == "offset/patch/values")) {
+        const auto is_offset = (name == "offset/patch/values");
+        const auto &block = is_offset ? offset_block : gains_block;
+        const auto &values = param.as_double_array();
+        const auto size = static_cast<std::size_t>(block.rows * block.cols);
+
+        if (values.size() != size) {
+          return "'" + name + "' must contain exactly ROWS*COLS (or SIZE) "
+                 "values, w.r.t. the patched block";
+        }
+
+        // Patch values are row major
+        using row_major_t =
+            Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic,
+                          Eigen::RowMajor>;
+        pending.push_back(ModelPatch{
+            is_offset, block,
+            Eigen::Map<const row_major_t>(values.data(), block.rows,
+                                          block.cols),
+            0});
+      } else if ((name != "gains/patch/block") &&
+                 (name != "offset/patch/segment") &&
+                 ((name.rfind("gains/", 0) == 0) ||
+                  (name.rfind("offset/", 0) == 0))) {
+        return "'" + name + "' can't be changed at runtime";
+      }
+    }
+
+    if (current.gains.Rows() != current.offset.size()) {
+      return "Size mismatch between the offset and the gains rows";
+    }
+
+    gains_patch_block = gains_block;
+    offset_patch_block = offset_block;
+    step->PostPatches(pending, full_update);
+    return std::nullopt;
+  }
+
+  /**
+   *  \brief Replace the whole model by the streamed \a msg, and post it to
+   *         the control path
+   *
+   *  \a msg is a dense row major ROWS x COLS array of the gains, or a
+   *  ROWS x (COLS + 1) array of the gains followed by the offset (as its last
+   *  column), given the gains shape (ROWS x COLS).
+   *
+   *  \return The reason of the failure, if any (nothing is posted)
+   */
+  auto StreamModel(const std_msgs::msg::Float64MultiArray &msg)
+      -> std::optional<std::string> {
+    const auto rows = step->Rows();
+    const auto cols = step->Cols();
+
+    const auto &dims = msg.layout.dim;
+    const auto has_offset = (dims.size() == 2) && (dims[1].size == (cols + 1));
+    if ((dims.size() != 2) || (dims[0].size != rows) ||
+        ((dims[1].size != cols) && !has_offset) ||
+        (msg.data.size() != (msg.layout.data_offset +
+                             std::size_t{dims[0].size} * dims[1].size))) {
+      return "Expecting a dense ROWS x COLS (gains) or ROWS x (COLS + 1) "
+             "(gains + offset) array";
+    }
+
+    using row_major_t =
+        Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+    const auto values = Eigen::Map<const row_major_t>(
+        msg.data.data() + msg.layout.data_offset, rows,
+        has_offset ? (cols + 1) : cols);
+
+    if (has_offset) {
+      const auto offset = offset_t{values.col(cols)};
+      step->PostModel(values.leftCols(cols), &offset);
+    } else {
+      step->PostModel(values.leftCols(cols));
+    }
+    return std::nullopt;
+  }
+
+  /**
+   *  \brief Snapshot the newest values of every state source into their
+   *         segment of \a out (lock free, see StateFusion::FuseInto())
+   *
+   *  \return GatherStatus::kStale when \a out (fixed rate only), or any
+   *          source, is too old, not received yet, or still being written.
+   *          GatherStatus::kOk otherwise.
+   */
+  auto FuseSources(StampedState &out) const noexcept -> GatherStatus {
+    return fusion.FuseInto(out.x.data(), out.received) ? GatherStatus::kOk
+                                                       : GatherStatus::kStale;
+  }
+
+  /**
+   *  \brief Shard only: latch the sequence of the state stamped \a stamp
+   *         into the \a latch of its stream
+   *
+   *  The shards identify the states through their stamp (see
+   *  ShardSequence()): an unstamped, or repeated, one would be assembled
+   *  once by lfc-aggregator, then ignored forever.
+   *
+   *  \return False when \a stamp is zero, or not newer than the last one
+   */
+  auto LatchShardSequence(const builtin_interfaces::msg::Time &stamp,
+                          StreamLatch &latch) const noexcept -> bool {
+    if (!shard.has_value()) return true;
+
+    const auto sequence = ShardSequence(stamp);
+    if ((sequence == 0) || (sequence <= latch.shard_sequence)) return false;
+    latch.shard_sequence = sequence;
+    return true;
+  }
+
+  /**
+   *  \brief Gather the \a fields of \a joint_state into \a out, \a latch
+   *          being the one of its stream
+   *
+   *  Probes (arg0 being \a out): 'lfc:receive' and 'lfc:gather' (once
+   *  gathered)
+   */
+  auto Gather(const joint_state_t &joint_state, StampedState &out,
+              StreamLatch &latch) -> GatherStatus {
+    LFC_PROBE(receive, &out);
+    out.received = ControlPathStats::clock::now();
+    if (!GatherInto(joint_state, fields, out.x.head(joint_state_size))) {
+      return GatherStatus::kSizeMismatch;
+    }
+
+    out.stamp = joint_state.header.stamp;
+    if (!LatchShardSequence(out.stamp, latch)) return GatherStatus::kUnordered;
+    LFC_PROBE(gather, &out);
+    return GatherStatus::kOk;
+  }
+
+  /// Gather the \a fields of the serialized JointState \a msg into \a out,
+  /// without deserializing it, its names layout being checked against the
+  /// one latched by its stream (same probes)
+  auto Gather(const rclcpp::SerializedMessage &msg, StampedState &out,
+              StreamLatch &latch) -> GatherStatus {
+    LFC_PROBE(receive, &out);
+    out.received = ControlPathStats::clock::now();
+    const auto &raw = msg.get_rcl_serialized_message();
+
+    auto layout = JointNamesLayout{};
+    switch (GatherSerializedInto(raw.buffer, raw.buffer_length, fields,
+                                 out.x.head(joint_state_size), out.stamp,
+                                 layout)) {
+      case CdrStatus::kOk: break;
+      case CdrStatus::kMalformed: return GatherStatus::kMalformed;
+      case CdrStatus::kSizeMismatch: return GatherStatus::kSizeMismatch;
+    }
+
+    // The values are gathered blindly, assuming the joints (names) never
+    // change: only their layout is checked against the first message one
+    if (!latch.names.has_value()) {
+      latch.names = layout;
+    } else if (*latch.names != layout) {
+      return GatherStatus::kNamesChanged;
+    }
+
+    if (!LatchShardSequence(out.stamp, latch)) return GatherStatus::kUnordered;
+    LFC_PROBE(gather, &out);
+    return GatherStatus::kOk;
+  }
 };
 
 namespace {
@@ -65,6 +649,56 @@ __attribute__((format(printf, 1, 2))) auto MakeStringFrom(
   return out;
 }
 
+/// Count into \a stats, and log (throttled) why, a JointState dropped given
+/// its \a status (probe 'lfc:drop', arg0: status)
+template <class NodeT>
+auto WarnDropped(NodeT &node, ControlPathStats &stats, GatherStatus status,
+                 Eigen::Index expected_size) -> void {
+  stats.Drop();
+  LFC_PROBE(drop, static_cast<int>(status));
+  switch (status) {
+    case GatherStatus::kOk: break;
+    case GatherStatus::kSizeMismatch:
+      RCLCPP_WARN_THROTTLE(node.get_logger(), *node.get_clock(), 1000,
+                           "Dropping JointState: the 'state/fields' values "
+                           "don't match the %ld values expected (gains cols, "
+                           "minus the 'state/sources' ones)",
+                           expected_size);
+      break;
+    case GatherStatus::kMalformed:
+      RCLCPP_WARN_THROTTLE(node.get_logger(), *node.get_clock(), 1000,
+                           "Dropping JointState: malformed serialized "
+                           "message");
+      break;
+    case GatherStatus::kNamesChanged:
+      RCLCPP_WARN_THROTTLE(node.get_logger(), *node.get_clock(), 1000,
+                           "Dropping JointState: its names differ from the "
+                           "first JointState received");
+      break;
+    case GatherStatus::kStale:
+      RCLCPP_WARN_THROTTLE(node.get_logger(), *node.get_clock(), 1000,
+                           "Dropping JointState: it, or one of the "
+                           "'state/sources', is older than its max age (or "
+                           "not received yet, or still being written)");
+      break;
+    case GatherStatus::kPipelineFull:
+      RCLCPP_WARN_THROTTLE(node.get_logger(), *node.get_clock(), 1000,
+                           "Dropping JointState: the solver thread is lagging "
+                           "behind (pipeline full)");
+      break;
+    case GatherStatus::kUnordered:
+      RCLCPP_ERROR_THROTTLE(node.get_logger(), *node.get_clock(), 1000,
+                            "Dropping JointState: its stamp is zero, or not "
+                            "newer than the last one, while the shards "
+                            "identify the states through their stamp "
+                            "(lfc-aggregator would ignore its command)");
+      break;
+    case GatherStatus::kSuperseded:
+    case GatherStatus::kCommandsFull:
+      break; // Shm only: counted without logging, see SpinShm()
+  }
+}
+
 template <class ExceptionType,
           std::enable_if_t<
               std::is_base_of_v<std::exception, std::decay_t<ExceptionType>>,
@@ -76,72 +710,1454 @@ auto LogAndThrow(const rclcpp::Logger &logger, ExceptionType &&ex) -> void {
 
 } // namespace
 
-LinearFeedbackNode::LinearFeedbackNode()
-    : LinearFeedbackNode(rclcpp::NodeOptions{}) {}
-
-LinearFeedbackNode::LinearFeedbackNode(const rclcpp::NodeOptions &options)
-    : rclcpp::Node(/* name = */ "linear_feedback", /* ns = */ "", options),
+template <class NodeBase>
+BasicLinearFeedbackNode<NodeBase>::BasicLinearFeedbackNode(
+    const rclcpp::NodeOptions &options)
+    : NodeBase(/* name = */ "linear_feedback", /* ns = */ "", options),
       m_impl(std::make_unique<LinearFeedbackNodeImpl>()),
-      m_input(nullptr) {
-  RCLCPP_DEBUG(get_logger(), "Starting: ...");
+      m_control_group(nullptr),
+      m_input(nullptr),
+      m_output(nullptr),
+      m_timer(nullptr),
+      m_gains_input(nullptr),
+      m_on_set_model(nullptr) {}
 
-  auto &gains = m_impl->gains;
-  auto &offset = m_impl->offset;
+template <class NodeBase>
+auto BasicLinearFeedbackNode<NodeBase>::Configure() -> void {
+  RCLCPP_DEBUG(this->get_logger(), "Starting: ...");
 
   // PARAMETERS
-  RCLCPP_DEBUG(get_logger(), "Declaring parameters: ...");
+  RCLCPP_DEBUG(this->get_logger(), "Declaring parameters: ...");
 
-  // -- > Init the gains/offset
+  // -- > Real-time settings: the memory ones are applied right away, the
+  // thread ones by the process spinning the node
   {
-    std::tie(gains, offset) =
-        DeclareParams(*this, ParamEigenMatrix<gains_t>("gains"),
-                      ParamEigenVector<offset_t>("offset"));
-
-    if (gains.rows() != offset.size()) {
-      LogAndThrow(
-          get_logger(),
-          rclcpp::exceptions::InvalidParametersException{
-              MakeStringFrom("Size mismatch between 'offset/size' and "
-                             "'gains/shape/rows' (%ld vs %ld)",
-                             offset.size(), gains.rows())
-                  .value_or(std::string{FILE_LINE} +
-                            ": MakeStringFrom failed: " + std::strerror(errno)),
+    auto &rt = m_impl->realtime;
+
+    const auto [enabled, priority, cpus, lock_memory, stack_bytes,
+                heap_bytes] =
+        DeclareParams(
+            *this,
+            ParamRaw<bool>("realtime/enabled", rt.enabled)
+                .ReadOnly()
+                .WithDescription("Run the control callback group on a "
+                                 "dedicated SCHED_FIFO thread"),
+            ParamRaw<std::int64_t>("realtime/priority", rt.priority)
+                .ReadOnly()
+                .WithDescription("SCHED_FIFO priority of the control thread")
+                .WithConstraints("Must be in [1, 99]"),
+            ParamRaw<std::vector<std::int64_t>>("realtime/cpus")
+                .ReadOnly()
+                .WithDescription("CPUs the control thread is pinned to (empty "
+                                 "means no pinning)")
+                .WithConstraints("Must be >= 0"),
+            ParamRaw<bool>("realtime/lock_memory", rt.lock_memory)
+                .ReadOnly()
+                .WithDescription("Lock all the process memory (mlockall) "
+                                 "when configuring, before allocating"),
+            ParamRaw<std::int64_t>("realtime/prefault/stack_bytes",
+                                   std::int64_t{256 * 1024})
+                .ReadOnly()
+                .WithDescription("Stack prefaulted by the control thread")
+                .WithConstraints("Must be >= 0 and lower than the thread "
+                                 "stack size"),
+            ParamRaw<std::int64_t>("realtime/prefault/heap_bytes",
+                                   std::int64_t{16 * 1024 * 1024})
+                .ReadOnly()
+                .WithDescription("Heap prefaulted when configuring, "
+                                 "before allocating")
+                .WithConstraints("Must be >= 0"));
+
+    if ((priority < 1) || (priority > 99)) {
+      LogAndThrow(this->get_logger(),
+                  rclcpp::exceptions::InvalidParametersException{
+                      MakeStringFrom("'realtime/priority' must be in [1, 99] "
+                                     "(got %ld)",
+                                     priority)
+                          .value_or(std::string{FILE_LINE} +
+                                    ": MakeStringFrom failed: " +
+                                    std::strerror(errno)),
+                  });
+    }
+
+    if ((stack_bytes < 0) || (heap_bytes < 0) ||
+        std::any_of(cpus.begin(), cpus.end(),
+                    [](std::int64_t cpu) { return cpu < 0; })) {
+      LogAndThrow(this->get_logger(),
+                  rclcpp::exceptions::InvalidParametersException{
+                      "'realtime/cpus' and 'realtime/prefault/*' must be >= 0",
+                  });
+    }
+
+    rt.enabled = enabled;
+    rt.priority = static_cast<int>(priority);
+    rt.cpus.assign(cpus.begin(), cpus.end());
+    rt.lock_memory = lock_memory;
+    rt.stack_bytes = static_cast<std::size_t>(stack_bytes);
+    rt.heap_bytes = static_cast<std::size_t>(heap_bytes);
+
+    RCLCPP_INFO(this->get_logger(), "Real-time control thread: %s",
+                rt.enabled ? "ENABLED" : "DISABLED");
+
+    // Before allocating anything: the allocations below then reuse the
+    // locked, prefaulted, heap
+    if (rt.enabled && rt.lock_memory) {
+      ReportRealtime(this->get_logger(), "mlockall", LockProcessMemory());
+    }
+    if (rt.enabled && (rt.heap_bytes > 0)) {
+      ReportRealtime(this->get_logger(), "prefault heap",
+                     PrefaultHeap(rt.heap_bytes));
+    }
+  }
+
+  // -- > Init the control step: gains/offset, kernel, stats and flight
+  // recorder, all built by the runtime (see ControlStep::Create())
+  auto config = RuntimeConfig{};
+  std::tie(config.gains_rows, config.gains_cols, config.gains_file,
+           config.gains_storage_order, config.gains_values) =
+      DeclareParams(
+          *this,
+          ParamRaw<std::int64_t>("gains/shape/rows", config.gains_rows)
+              .ReadOnly()
+              .WithDescription("The number of rows of the gains (the .npy "
+                               "'gains/file' shape when < 0)"),
+          ParamRaw<std::int64_t>("gains/shape/cols", config.gains_cols)
+              .ReadOnly()
+              .WithDescription("The number of cols of the gains (the .npy "
+                               "'gains/file' shape when < 0)"),
+          ParamRaw<std::string>("gains/file", config.gains_file)
+              .ReadOnly()
+              .WithDescription("Path of a .npy (or raw little endian "
+                               "float64) file holding the initial gains, "
+                               "taking precedence over 'gains/values'"),
+          ParamRaw<std::string>("gains/storage_order",
+                                config.gains_storage_order)
+              .ReadOnly()
+              .WithDescription("The storage order of the gains values "
+                               "(including the ones set at runtime)")
+              .WithConstraints("One of 'row_major' or 'column_major'"),
+          ParamRaw<std::vector<double>>("gains/values", config.gains_values)
+              .WithDescription("The initial gains, stored as set by "
+                               "'gains/storage_order' (ZERO if empty)")
+              .WithConstraints("Must contain exactly ROWS*COLS values"));
+
+  std::tie(config.offset_file, config.offset_values) = DeclareParams(
+      *this,
+      ParamRaw<std::string>("offset/file", config.offset_file)
+          .ReadOnly()
+          .WithDescription("Path of a .npy (or raw little endian float64) "
+                           "file holding the initial offset, taking "
+                           "precedence over 'offset/values'"),
+      ParamRaw<std::vector<double>>("offset/values", config.offset_values)
+          .WithDescription("The initial offset (ZERO if empty)")
+          .WithConstraints("Must contain exactly ROWS values"));
+
+  const auto [rows_begin, rows_end] = DeclareParams(
+      *this,
+      ParamRaw<std::int64_t>("shard/rows_begin", config.shard_rows_begin)
+          .ReadOnly()
+          .WithDescription("First row of the gains/offset solved by this "
+                           "node, as a shard of a row partitioned model. "
+                           "Its partial commands are tagged with this row "
+                           "(frame_id) and assembled by lfc-aggregator. "
+                           "Live updates of the model then address the "
+                           "shard rows only")
+          .WithConstraints("Must be in [0, 'shard/rows_end'). The "
+                           "JointState stamps must then be non zero and "
+                           "increasing, identifying the states across the "
+                           "shards"),
+      ParamRaw<std::int64_t>("shard/rows_end", config.shard_rows_end)
+          .ReadOnly()
+          .WithDescription("Row after the last one solved by this node. "
+                           "-1 means the gains rows (i.e. no shard, with "
+                           "'shard/rows_begin' at 0)")
+          .WithConstraints("-1, or in ('shard/rows_begin', gains rows]"));
+  config.shard_rows_begin = rows_begin;
+  config.shard_rows_end = rows_end;
+
+  std::tie(config.kernel, config.autotune_budget_ms, config.autotune_cache) =
+      DeclareParams(
+          *this,
+          ParamRaw<std::string>("model/kernel", config.kernel)
+              .ReadOnly()
+              .WithDescription("Kernel (i.e. storage of the gains) used "
+                               "when solving. With 'auto', the fastest one "
+                               "is timed on the actual model at startup")
+              .WithConstraints("One of 'auto', 'column_major', "
+                               "'row_major', 'sparse', 'blocked' or "
+                               "'fixed'"),
+          ParamRaw<std::int64_t>("model/autotune/budget_ms",
+                                 config.autotune_budget_ms)
+              .ReadOnly()
+              .WithDescription("'auto' only: time (ms) spent timing all the "
+                               "kernels")
+              .WithConstraints("Must be > 0"),
+          ParamRaw<std::string>("model/autotune/cache", config.autotune_cache)
+              .ReadOnly()
+              .WithDescription("'auto' only: file caching the kernel chosen "
+                               "per model shape and CPU model, skipping the "
+                               "timing on the next startups. Not cached if "
+                               "empty"));
+
+  const auto [diagnostics, diagnostics_period] = DeclareParams(
+      *this,
+      ParamRaw<bool>("diagnostics/enabled", true)
+          .ReadOnly()
+          .WithDescription("Periodically publish the control path latencies "
+                           "(receive to solve, solve, solve to publish and "
+                           "end to end percentiles) and the deadline misses "
+                           "on '/diagnostics'"),
+      ParamRaw<double>("diagnostics/period", 1.)
+          .ReadOnly()
+          .WithDescription("Period (s) of the diagnostics publication")
+          .WithConstraints("Must be > 0"));
+
+  std::tie(config.deadline, config.shm, config.perf) = DeclareParams(
+      *this,
+      ParamRaw<double>("diagnostics/deadline", config.deadline)
+          .ReadOnly()
+          .WithDescription("Maximum latency (s) from a JointState receipt to "
+                           "its command publication, counted as a deadline "
+                           "miss when exceeded. 0 means the control "
+                           "period with 'control/rate', no deadline "
+                           "otherwise")
+          .WithConstraints("Must be >= 0"),
+      ParamRaw<std::string>("diagnostics/shm", config.shm)
+          .ReadOnly()
+          .WithDescription("POSIX shared memory object (e.g. '/lfc') "
+                           "exposing the control path stats to other "
+                           "processes, without any syscall from the control "
+                           "path (see lfc-top). Disabled when empty")
+          .WithConstraints("Must not be used by another live node"),
+      ParamRaw<bool>("diagnostics/perf", config.perf)
+          .ReadOnly()
+          .WithDescription("Count the hardware events (cycles, instructions, "
+                           "LLC misses and branch misses) of each solve, "
+                           "through perf_event_open (read with rdpmc when "
+                           "permitted). The counters are opened by the "
+                           "thread solving, on its first solve, and ignored "
+                           "when unavailable (see the diagnostics)")
+          .WithConstraints("Only with a dedicated solving thread: "
+                           "'control/loop: wait_set' or 'shm', or "
+                           "'control/pipeline/enabled'"));
+
+  if (diagnostics_period <= 0.) {
+    LogAndThrow(this->get_logger(),
+                rclcpp::exceptions::InvalidParametersException{
+                    "'diagnostics/period' must be > 0",
+                });
+  }
+
+  // Unique default, as several nodes may run on a host (or in a process)
+  config.flight_path = "/tmp/lfc-flight" + std::string{
+      this->get_fully_qualified_name()} + ".bin";
+  std::replace(config.flight_path.begin() + 5, config.flight_path.end(), '/',
+               '-');
+
+  std::tie(config.flight_records, config.flight_path,
+           config.flight_dump_on_fault) =
+      DeclareParams(
+          *this,
+          ParamRaw<std::int64_t>("flight_recorder/records",
+                                 config.flight_records)
+              .ReadOnly()
+              .WithDescription("Number of the last control steps (model "
+                               "version, state X, command Y) kept in a "
+                               "preallocated ring, dumped on demand "
+                               "('~/dump_flight_recorder') or on fault (see "
+                               "lfc-flight-decode). Disabled when 0")
+              .WithConstraints("Must be >= 0"),
+          ParamRaw<std::string>("flight_recorder/path", config.flight_path)
+              .ReadOnly()
+              .WithDescription("File the flight recorder is dumped to "
+                               "(replaced). Defaults to "
+                               "'/tmp/lfc-flight-<namespace>-<name>.bin', "
+                               "'/tmp/lfc-flight-<pid>.bin' when empty"),
+          ParamRaw<bool>("flight_recorder/dump_on_fault",
+                         config.flight_dump_on_fault)
+              .ReadOnly()
+              .WithDescription("Dump the flight recorder when the process "
+                               "receives a fault signal (SIGSEGV, SIGBUS, "
+                               "SIGFPE, SIGILL or SIGABRT)"));
+
+  // -- > The (optional) trajectory of models replacing the model, batch of
+  // streams sharing the model, and commands published on change: set up by
+  // the control step too
+  std::tie(config.trajectory_file, config.trajectory_values,
+           config.trajectory_start, config.trajectory_period,
+           config.trajectory_interpolation) =
+      DeclareParams(
+          *this,
+          ParamRaw<std::string>("trajectory/file", config.trajectory_file)
+              .ReadOnly()
+              .WithDescription("Path of a .npy (or raw little endian "
+                               "float64) file holding the models of the "
+                               "trajectory (as 'trajectory/values'), memory "
+                               "mapped and taking precedence over "
+                               "'trajectory/values'"),
+          ParamRaw<std::vector<double>>("trajectory/values",
+                                        config.trajectory_values)
+              .ReadOnly()
+              .WithDescription("Models of the trajectory, one after the "
+                               "other, each one being the gains (stored as "
+                               "set by 'gains/storage_order') followed by the "
+                               "offset. When set, they replace the "
+                               "gains/offset values")
+              .WithConstraints("Must hold a whole number of models, w.r.t. "
+                               "the gains shape. Can't be used alongside "
+                               "'shard/*'"),
+          ParamRaw<double>("trajectory/start", config.trajectory_start)
+              .ReadOnly()
+              .WithDescription("Time (s) of the first model. When <= 0, the "
+                               "time of the first state solved"),
+          ParamRaw<double>("trajectory/period", config.trajectory_period)
+              .ReadOnly()
+              .WithDescription("Time (s) between 2 consecutive models")
+              .WithConstraints("Must be > 0 when 'trajectory/values' is set"),
+          ParamRaw<std::string>("trajectory/interpolation",
+                                config.trajectory_interpolation)
+              .ReadOnly()
+              .WithDescription("How the models are sampled between 2 "
+                               "consecutive models")
+              .WithConstraints("One of 'hold' or 'linear'"));
+
+  const auto trajectory_time = DeclareParams(
+      *this, ParamRaw<std::string>("trajectory/time", "stamp")
+                 .ReadOnly()
+                 .WithDescription("Time used to pick the active model: the "
+                                  "JointState stamp ('stamp') or the node "
+                                  "clock when solving ('clock')")
+                 .WithConstraints("One of 'stamp' or 'clock'"));
+
+  auto batch_inputs = std::vector<std::string>{};
+  auto batch_outputs = std::vector<std::string>{};
+  std::tie(batch_inputs, batch_outputs, config.batch_offsets) = DeclareParams(
+      *this,
+      ParamRaw<std::vector<std::string>>("batch/inputs")
+          .ReadOnly()
+          .WithDescription("JointState topics of the streams sharing the "
+                           "model (e.g. one per robot), replacing "
+                           "'joint_state'. On each 'control/rate' tick, "
+                           "their newest states are solved together, as a "
+                           "single matrix product")
+          .WithConstraints("Requires 'control/rate' > 0, and can't be used "
+                           "alongside a trajectory nor 'state/sources'"),
+      ParamRaw<std::vector<std::string>>("batch/outputs")
+          .ReadOnly()
+          .WithDescription("Command topics of the 'batch/inputs' streams "
+                           "(same order), replacing 'command'")
+          .WithConstraints("Exactly one topic per 'batch/inputs' topic"),
+      ParamRaw<std::vector<double>>("batch/offsets", config.batch_offsets)
+          .ReadOnly()
+          .WithDescription("Offsets of the 'batch/inputs' streams, one "
+                           "after the other, added to the model offset. "
+                           "None when empty")
+          .WithConstraints("Empty, or exactly ROWS values per stream"));
+  config.batch_streams = static_cast<std::int64_t>(batch_inputs.size());
+
+  std::tie(config.on_change, config.on_change_epsilon,
+           config.on_change_keep_alive) =
+      DeclareParams(
+          *this,
+          ParamRaw<bool>("command/on_change/enabled", config.on_change)
+              .ReadOnly()
+              .WithDescription("Only publish the commands that changed since "
+                               "the last one published (beyond "
+                               "'command/on_change/epsilon'), or once "
+                               "'command/on_change/keep_alive' elapsed")
+              .WithConstraints("Can't be used alongside 'batch/*', "
+                               "'shard/*' (the partial commands must all be "
+                               "published for lfc-aggregator to assemble "
+                               "them), nor 'control/loop: shm'"),
+          ParamRaw<double>("command/on_change/epsilon",
+                           config.on_change_epsilon)
+              .ReadOnly()
+              .WithDescription("Change of any value of the command beyond "
+                               "which it is published")
+              .WithConstraints("Must be >= 0"),
+          ParamRaw<double>("command/on_change/keep_alive",
+                           config.on_change_keep_alive)
+              .ReadOnly()
+              .WithDescription("Period (s) after which an unchanged command "
+                               "is published anyway. Never when 0")
+              .WithConstraints("Must be >= 0"));
+
+  {
+    auto reason = std::string{};
+    m_impl->step = ControlStep::Create(config, reason);
+    if (m_impl->step == nullptr) {
+      LogAndThrow(this->get_logger(),
+                  rclcpp::exceptions::InvalidParametersException{reason});
+    }
+
+    const auto &step = *m_impl->step;
+    RCLCPP_INFO(this->get_logger(),
+                "Model: [%ldx%ld] (ROWSxCOLS) gains, [%ld] offset",
+                step.Rows(), step.Cols(), step.Rows());
+
+    if ((rows_begin != 0) || (rows_end >= 0)) {
+      m_impl->shard = static_cast<std::size_t>(rows_begin);
+      RCLCPP_INFO(this->get_logger(), "Shard: rows [%ld, %ld)", rows_begin,
+                  rows_begin + step.Rows());
+    }
+
+    const auto &tuning = step.Tuning();
+    if (tuning.has_value() && tuning->cached) {
+      RCLCPP_INFO(this->get_logger(),
+                  "Gains kernel autotuning: '%s' read from '%s'",
+                  std::string{ToString(tuning->kernel)}.c_str(),
+                  config.autotune_cache.c_str());
+    } else if (tuning.has_value()) {
+      for (const auto &timing : tuning->timings) {
+        RCLCPP_INFO(this->get_logger(),
+                    "Gains kernel autotuning: %s: %.1fns/solve",
+                    std::string{ToString(timing.kernel)}.c_str(),
+                    timing.ns_per_solve);
+      }
+      if (tuning->cache_failed) {
+        RCLCPP_WARN(this->get_logger(),
+                    "Gains kernel autotuning: can't write '%s'",
+                    config.autotune_cache.c_str());
+      }
+    }
+
+    RCLCPP_INFO(this->get_logger(), "Gains kernel: %s",
+                std::string{ToString(step.Kernel())}.c_str());
+
+    // Validated by ControlStep::Create()
+    m_impl->values_order = StorageOrderFrom(config.gains_storage_order)
+                               .value_or(StorageOrder::kRowMajor);
+
+    if (!config.shm.empty()) {
+      RCLCPP_INFO(this->get_logger(), "Stats shared through '%s'",
+                  config.shm.c_str());
+    }
+    if (config.flight_records > 0) {
+      m_impl->recorder_path = FlightPathOf(config);
+    }
+
+    if (const auto *trajectory = step.Trajectory(); trajectory != nullptr) {
+      if ((trajectory_time != "stamp") && (trajectory_time != "clock")) {
+        LogAndThrow(this->get_logger(),
+                    rclcpp::exceptions::InvalidParametersException{
+                        "Unknown 'trajectory/time' value '" +
+                            trajectory_time + "'",
+                    });
+      }
+      m_impl->clock =
+          (trajectory_time == "clock") ? this->get_clock() : nullptr;
+
+      RCLCPP_INFO(this->get_logger(), "Trajectory: %zu models (every %gs, %s)",
+                  trajectory->Count(), trajectory->Period(),
+                  config.trajectory_interpolation.c_str());
+    }
+
+    if (config.on_change) {
+      RCLCPP_INFO(this->get_logger(),
+                  "Commands published on change (epsilon: %g, keep alive: "
+                  "%gs)",
+                  config.on_change_epsilon, config.on_change_keep_alive);
+    }
+  }
+
+  // -- > Init the state gathered from the JointState
+  {
+    const auto names = DeclareParams(
+        *this, ParamRaw<std::vector<std::string>>("state/fields",
+                                                  {"position", "velocity"})
+                   .ReadOnly()
+                   .WithDescription("Ordered JointState fields concatenated "
+                                    "into the state X")
+                   .WithConstraints("Each one of 'position', 'velocity' or "
+                                    "'effort'"));
+
+    m_impl->serialized = DeclareParams(
+        *this,
+        ParamRaw<bool>("state/serialized", m_impl->serialized)
+            .ReadOnly()
+            .WithDescription("Subscribe to the serialized JointState, only "
+                             "decoding the 'state/fields' values (the names "
+                             "are expected to never change)"));
+
+    m_impl->fields.clear();
+    for (const auto &name : names) {
+      if (auto field = JointStateFieldFrom(name); field.has_value()) {
+        m_impl->fields.push_back(*field);
+      } else {
+        LogAndThrow(
+            this->get_logger(),
+            rclcpp::exceptions::InvalidParametersException{
+                "Unknown JointState field '" + name + "' in 'state/fields'",
+            });
+      }
+    }
+
+    const auto [sources, max_age] = DeclareParams(
+        *this,
+        ParamRaw<std::vector<std::string>>("state/sources")
+            .ReadOnly()
+            .WithDescription("Names of the typed inputs (JointState, Imu or "
+                             "WrenchStamped, e.g. at other rates) fused into "
+                             "the state X, after the 'state/fields' values, "
+                             "in this order. Their newest values are "
+                             "snapshotted whenever a JointState is solved "
+                             "(see 'state/sources/<name>/*')"),
+        ParamRaw<double>("state/max_age", 0.)
+            .ReadOnly()
+            .WithDescription("'control/rate' > 0 only: age (s) of the newest "
+                             "JointState beyond which it is dropped instead "
+                             "of solved. No limit when 0")
+            .WithConstraints("Must be >= 0"));
+
+    if (max_age < 0.) {
+      LogAndThrow(this->get_logger(),
+                  rclcpp::exceptions::InvalidParametersException{
+                      "'state/max_age' must be >= 0",
+                  });
+    }
+    m_impl->fusion.max_age = std::chrono::duration_cast<
+        ControlPathStats::clock::duration>(
+        std::chrono::duration<double>{max_age});
+
+    // Sources are appended to X in order, sized once all of them are known
+    auto sources_size = Eigen::Index{0};
+    for (const auto &name : sources) {
+      const auto prefix = "state/sources/" + name + "/";
+      const auto type = DeclareParams(
+          *this, ParamRaw<std::string>(prefix + "type", "joint_state")
+                     .ReadOnly()
+                     .WithDescription("Message of the source")
+                     .WithConstraints("One of 'joint_state' (JointState), "
+                                      "'imu' (Imu) or 'wrench' "
+                                      "(WrenchStamped)"));
+
+      auto default_fields = std::vector<std::string>{"position", "velocity"};
+      if (type == "imu") {
+        default_fields = {"orientation", "angular_velocity"};
+      } else if (type == "wrench") {
+        default_fields = {"force", "torque"};
+      }
+
+      const auto [topic, field_names, size, source_max_age] = DeclareParams(
+          *this,
+          ParamRaw<std::string>(prefix + "topic", name)
+              .ReadOnly()
+              .WithDescription("Topic of the source"),
+          ParamRaw<std::vector<std::string>>(prefix + "fields",
+                                             default_fields)
+              .ReadOnly()
+              .WithDescription("Ordered fields of the source concatenated "
+                               "into X")
+              .WithConstraints("'joint_state': 'position', 'velocity' or "
+                               "'effort'. 'imu': 'orientation' (x, y, z, w), "
+                               "'angular_velocity' or 'linear_acceleration'. "
+                               "'wrench': 'force' or 'torque'"),
+          ParamRaw<std::int64_t>(prefix + "size", 0)
+              .ReadOnly()
+              .WithDescription("'joint_state' only: values gathered (i.e. "
+                               "joints x fields)")
+              .WithConstraints("Must be > 0 for a 'joint_state' source"),
+          ParamRaw<double>(prefix + "max_age", 0.)
+              .ReadOnly()
+              .WithDescription("Age (s) of the newest values of the source "
+                               "beyond which the JointStates are dropped "
+                               "instead of solved. No limit when 0")
+              .WithConstraints("Must be >= 0"));
+
+      auto fields = SourceFieldsFrom(type, field_names);
+      if (!fields.has_value()) {
+        LogAndThrow(this->get_logger(),
+                    rclcpp::exceptions::InvalidParametersException{
+                        "Unknown '" + prefix + "type' or '" + prefix +
+                            "fields' value",
+                    });
+      }
+
+      const auto fixed_size = FixedSizeOf(*fields);
+      const auto source_size = fixed_size.value_or(size);
+      if ((source_size <= 0) || (source_max_age < 0.)) {
+        LogAndThrow(this->get_logger(),
+                    rclcpp::exceptions::InvalidParametersException{
+                        "Invalid '" + prefix +
+                            "*' parameters (see their constraints)",
+                    });
+      }
+
+      m_impl->sources.emplace_back(
+          name, topic, std::move(*fields), sources_size, source_size,
+          std::chrono::duration_cast<ControlPathStats::clock::duration>(
+              std::chrono::duration<double>{source_max_age}));
+      sources_size += source_size;
+    }
+
+    m_impl->joint_state_size = m_impl->step->Cols() - sources_size;
+    if (m_impl->joint_state_size < 0) {
+      LogAndThrow(this->get_logger(),
+                  rclcpp::exceptions::InvalidParametersException{
+                      "The 'state/sources' values exceed the gains cols",
+                  });
+    }
+    for (auto &source : m_impl->sources) {
+      source.start += m_impl->joint_state_size;
+      m_impl->fusion.AddSource(static_cast<std::size_t>(source.start),
+                               static_cast<std::size_t>(source.size),
+                               source.max_age);
+      RCLCPP_INFO(this->get_logger(),
+                  "State source '%s' ('%s'): X[%ld, %ld)%s",
+                  source.name.c_str(), source.topic.c_str(), source.start,
+                  source.start + source.size,
+                  (source.max_age > ControlPathStats::clock::duration::zero())
+                      ? " (with max age)"
+                      : "");
+    }
+
+    m_impl->state.x.setZero(m_impl->step->Cols());
+    m_impl->latest_state.ForEachSlot(
+        [&](StampedState &slot) { slot.x.setZero(m_impl->step->Cols()); });
+    m_impl->pipeline.ForEachSlot(
+        [&](StampedState &slot) { slot.x.setZero(m_impl->step->Cols()); });
+    m_impl->command.effort.assign(
+        static_cast<std::size_t>(m_impl->step->Rows()), 0.);
+    if (m_impl->shard.has_value()) {
+      m_impl->command.header.frame_id = ShardFrameId(*m_impl->shard);
+    }
+  }
+
+  // -- > Control loop
+  {
+    auto &control = m_impl->control;
+
+    const auto [loop, busy_poll, rate, pipeline, pipeline_cpus] = DeclareParams(
+        *this,
+        ParamRaw<std::string>("control/loop",
+                              std::string{ToString(control.loop)})
+            .ReadOnly()
+            .WithDescription("How the control path is driven: through the "
+                             "executor ('executor'), through an inline "
+                             "take/solve/publish loop ('wait_set'), or "
+                             "through the shared memory transport of a "
+                             "co-located driver ('shm', no JointState)")
+            .WithConstraints("One of 'executor', 'wait_set' or 'shm'"),
+        ParamRaw<bool>("control/busy_poll", control.busy_poll)
+            .ReadOnly()
+            .WithDescription("'wait_set' or 'shm' only: poll the "
+                             "subscription (or the transport) continuously, "
+                             "without ever sleeping"),
+        ParamRaw<double>("control/rate", control.rate)
+            .ReadOnly()
+            .WithDescription("'executor' only: when > 0, commands are "
+                             "computed by a steady timer at this rate (Hz), "
+                             "from the newest JointState received. Otherwise, "
+                             "they are computed for each JointState received")
+            .WithConstraints("Must be >= 0"),
+        ParamRaw<bool>("control/pipeline/enabled", control.pipeline)
+            .ReadOnly()
+            .WithDescription("Split the control path in 2 threads: the "
+                             "control path only gathers the states, handed "
+                             "over to a dedicated solver thread that solves "
+                             "and publishes"),
+        ParamRaw<std::vector<std::int64_t>>("control/pipeline/cpus")
+            .ReadOnly()
+            .WithDescription("CPUs the solver thread is pinned to (empty "
+                             "means no pinning). Should not overlap with "
+                             "'realtime/cpus'")
+            .WithConstraints("Must be >= 0"));
+
+    if (loop == ToString(ControlLoop::kExecutor)) {
+      control.loop = ControlLoop::kExecutor;
+    } else if (loop == ToString(ControlLoop::kWaitSet)) {
+      control.loop = ControlLoop::kWaitSet;
+    } else if (loop == ToString(ControlLoop::kShm)) {
+      control.loop = ControlLoop::kShm;
+    } else {
+      LogAndThrow(this->get_logger(),
+                  rclcpp::exceptions::InvalidParametersException{
+                      "Unknown 'control/loop' value '" + loop + "'",
+                  });
+    }
+    control.busy_poll = busy_poll;
+
+    if ((rate < 0.) ||
+        ((rate > 0.) && (control.loop != ControlLoop::kExecutor))) {
+      LogAndThrow(this->get_logger(),
+                  rclcpp::exceptions::InvalidParametersException{
+                      "'control/rate' must be >= 0, and can only be set with "
+                      "'control/loop: executor'",
+                  });
+    }
+    control.rate = rate;
+
+    if ((pipeline && ((rate > 0.) || (control.loop == ControlLoop::kShm))) ||
+        std::any_of(pipeline_cpus.begin(), pipeline_cpus.end(),
+                    [](std::int64_t cpu) { return cpu < 0; })) {
+      LogAndThrow(this->get_logger(),
+                  rclcpp::exceptions::InvalidParametersException{
+                      "'control/pipeline/cpus' must be >= 0, and "
+                      "'control/pipeline/enabled' can't be used alongside "
+                      "'control/rate' or 'control/loop: shm'",
+                  });
+    }
+    control.pipeline = pipeline;
+    control.pipeline_cpus.assign(pipeline_cpus.begin(), pipeline_cpus.end());
+
+    // The counters only count the thread opening them: executor callbacks
+    // may run on any thread of the executor
+    if (config.perf && (control.loop == ControlLoop::kExecutor) &&
+        !control.pipeline) {
+      LogAndThrow(this->get_logger(),
+                  rclcpp::exceptions::InvalidParametersException{
+                      "'diagnostics/perf' requires a dedicated solving "
+                      "thread: 'control/loop: wait_set' or 'shm', or "
+                      "'control/pipeline/enabled'",
+                  });
+    }
+
+    const auto [shm_name, shm_capacity] = DeclareParams(
+        *this,
+        ParamRaw<std::string>("control/shm/name", control.shm_name)
+            .ReadOnly()
+            .WithDescription("'shm' only: POSIX shared memory object of the "
+                             "states/commands transport, created by the node "
+                             "and opened by the driver (see lfc-shm-driver)")
+            .WithConstraints("Must not exist yet (one node per transport)"),
+        ParamRaw<std::int64_t>(
+            "control/shm/capacity",
+            static_cast<std::int64_t>(control.shm_capacity))
+            .ReadOnly()
+            .WithDescription("'shm' only: slots of the states (and commands) "
+                             "ring of the transport")
+            .WithConstraints("Must be a power of 2"));
+    control.shm_name = shm_name;
+
+    if ((control.loop == ControlLoop::kShm) &&
+        (m_impl->shard.has_value() || !m_impl->sources.empty())) {
+      LogAndThrow(this->get_logger(),
+                  rclcpp::exceptions::InvalidParametersException{
+                      "'control/loop: shm' can't be used alongside 'shard/*' "
+                      "(its commands aren't tagged), nor 'state/sources' "
+                      "(the driver states are solved as is)",
+                  });
+    }
+
+    if (control.loop == ControlLoop::kShm) {
+      auto reason = std::string{};
+      m_impl->transport = ShmTransport::Create(
+          shm_name, static_cast<std::size_t>(m_impl->step->Cols()),
+          static_cast<std::size_t>(m_impl->step->Rows()),
+          static_cast<std::size_t>(std::max<std::int64_t>(shm_capacity, 0)),
+          control.busy_poll ? ShmWakeup::kBusyPoll : ShmWakeup::kFutex,
+          reason);
+      if (!m_impl->transport.has_value()) {
+        LogAndThrow(this->get_logger(),
+                    rclcpp::exceptions::InvalidParametersException{
+                        "Can't create the 'control/shm/name' transport: " +
+                            reason,
+                    });
+      }
+      control.shm_capacity = m_impl->transport->Capacity();
+    }
+
+    RCLCPP_INFO(this->get_logger(), "Control loop: %s%s%s%s%s",
+                std::string{ToString(control.loop)}.c_str(),
+                (control.loop == ControlLoop::kShm)
+                    ? (" ('" + control.shm_name + "')").c_str()
+                    : "",
+                control.busy_poll ? " (busy poll)" : "",
+                control.rate > 0. ? " (fixed rate)" : "",
+                control.pipeline ? " (pipelined)" : "");
+  }
+
+  // -- > Batch of streams sharing the model (e.g. identical robots)
+  {
+    if (!batch_inputs.empty() &&
+        ((m_impl->control.rate <= 0.) || !m_impl->sources.empty() ||
+         (batch_outputs.size() != batch_inputs.size()))) {
+      LogAndThrow(this->get_logger(),
+                  rclcpp::exceptions::InvalidParametersException{
+                      "Invalid 'batch/*' parameters (see their constraints)",
+                  });
+    }
+
+    for (std::size_t k = 0; k < batch_inputs.size(); ++k) {
+      auto &stream = m_impl->streams.emplace_back();
+      stream.latest.ForEachSlot(
+          [&](StampedState &slot) { slot.x.setZero(m_impl->step->Cols()); });
+      stream.command.effort.assign(
+          static_cast<std::size_t>(m_impl->step->Rows()), 0.);
+      stream.command.header.frame_id = m_impl->command.header.frame_id;
+    }
+    m_impl->batch_stamps.assign(batch_inputs.size(), nullptr);
+
+    if (!batch_inputs.empty()) {
+      RCLCPP_INFO(this->get_logger(), "Batch: %zu streams%s",
+                  batch_inputs.size(),
+                  config.batch_offsets.empty() ? "" : " (with offsets)");
+    }
+  }
+
+  // -- > Decimated debug copies of the commands
+  {
+    const auto [debug, decimation, period] = DeclareParams(
+        *this,
+        ParamRaw<bool>("debug/enabled", false)
+            .ReadOnly()
+            .WithDescription("Publish a decimated copy of the commands on "
+                             "'command/debug' (best effort), from the default "
+                             "callback group: the control path only copies "
+                             "them into a lock-free ring, never waiting for "
+                             "the debug subscribers")
+            .WithConstraints("Can't be used alongside 'batch/*'"),
+        ParamRaw<std::int64_t>("debug/decimation", 10)
+            .ReadOnly()
+            .WithDescription("Commands solved per debug copy")
+            .WithConstraints("Must be > 0"),
+        ParamRaw<double>("debug/period", 0.05)
+            .ReadOnly()
+            .WithDescription("Period (s) at which the debug copies are "
+                             "published")
+            .WithConstraints("Must be > 0"));
+
+    if ((config.on_change && (m_impl->control.loop == ControlLoop::kShm)) ||
+        (debug && (!m_impl->streams.empty() || (decimation <= 0) ||
+                   (period <= 0.)))) {
+      LogAndThrow(this->get_logger(),
+                  rclcpp::exceptions::InvalidParametersException{
+                      "Invalid 'command/on_change/*' or 'debug/*' parameters "
+                      "(see their constraints)",
+                  });
+    }
+
+    if (debug) {
+      m_impl->debug_decimation = static_cast<std::size_t>(decimation);
+      m_impl->debug.ForEachSlot(
+          [&](LinearFeedbackNodeImpl::DebugCommand &slot) {
+            slot.y.setZero(m_impl->step->Rows());
           });
+      m_impl->debug_command.effort.assign(
+          static_cast<std::size_t>(m_impl->step->Rows()), 0.);
+      m_impl->debug_command.header.frame_id = m_impl->command.header.frame_id;
+      RCLCPP_INFO(this->get_logger(), "Debug: 1 command every %ld", decimation);
     }
+  }
+
+  // -- > Live block-wise updates of the gains/offset values (see UpdateModel)
+  DeclareParams(
+      *this,
+      ParamRaw<std::vector<std::int64_t>>("gains/patch/block", {0, 0, 0, 0})
+          .WithDescription("Block of the gains patched by "
+                           "'gains/patch/values'")
+          .WithConstraints("[ROW, COL, ROWS, COLS], within the gains shape"),
+      ParamRaw<std::vector<double>>("gains/patch/values")
+          .WithDescription("New values (row major) of the 'gains/patch/block' "
+                           "of the gains, applied when set")
+          .WithConstraints("Must contain exactly ROWS*COLS values. Can't be "
+                           "set alongside a trajectory"),
+      ParamRaw<std::vector<std::int64_t>>("offset/patch/segment", {0, 0})
+          .WithDescription("Segment of the offset patched by "
+                           "'offset/patch/values'")
+          .WithConstraints("[START, SIZE], within the offset size"),
+      ParamRaw<std::vector<double>>("offset/patch/values")
+          .WithDescription("New values of the 'offset/patch/segment' of the "
+                           "offset, applied when set")
+          .WithConstraints("Must contain exactly SIZE values. Can't be set "
+                           "alongside a trajectory"));
 
-    RCLCPP_INFO(get_logger(),
-                "Initial shapes:"
-                "\n - Gains : [%ldx%ld] (ROWSxCOLS)"
-                "\n - Offset: [%ld]",
-                gains.rows(), gains.cols(), offset.size());
+  const auto stream_model = DeclareParams(
+      *this, ParamRaw<bool>("gains/stream/enabled", false)
+                 .ReadOnly()
+                 .WithDescription("Subscribe to the 'gains' topic, streaming "
+                                  "the whole model (Float64MultiArray, row "
+                                  "major gains, optionally followed by the "
+                                  "offset as the last column)")
+                 .WithConstraints("Can't be used alongside a trajectory"));
 
-    RCLCPP_DEBUG_STREAM(get_logger(), "Initial values:\n - Gains :\n"
-                                          << gains << "\n - Offset:\n"
-                                          << offset);
+  if (stream_model && (m_impl->step->Trajectory() != nullptr)) {
+    LogAndThrow(this->get_logger(),
+                rclcpp::exceptions::InvalidParametersException{
+                    "'gains/stream/enabled' can't be used alongside a "
+                    "trajectory (see 'trajectory/*'), whose models replace "
+                    "the streamed one",
+                });
   }
 
-  RCLCPP_INFO(get_logger(), "Declaring parameters: DONE");
+  // -- > Diagnostics: 'diagnostics/deadline' defaults to the control period
+  if ((config.deadline <= 0.) && (m_impl->control.rate > 0.)) {
+    m_impl->step->Stats().deadline =
+        std::chrono::duration_cast<ControlPathStats::clock::duration>(
+            std::chrono::duration<double>{1. / m_impl->control.rate});
+  }
+
+  // -- > Live updates of the gains/offset values
+  // Runs on the thread setting the parameters (never the control thread)
+  m_on_set_model = this->add_on_set_parameters_callback(
+      [this](const std::vector<rclcpp::Parameter> &params) {
+        auto result = rcl_interfaces::msg::SetParametersResult{};
+        if (auto error = m_impl->UpdateModel(params); error.has_value()) {
+          RCLCPP_WARN(this->get_logger(), "Model update REJECTED: %s",
+                      error->c_str());
+          result.successful = false;
+          result.reason = std::move(*error);
+        } else {
+          RCLCPP_DEBUG(this->get_logger(), "Model update: DONE");
+        }
+        return result;
+      });
+
+  RCLCPP_INFO(this->get_logger(), "Declaring parameters: DONE");
+
+  // CALLBACK GROUPS
+  // When running in real-time, the control group is spun by a dedicated
+  // executor/thread, and must not be picked up by the default one. Same goes
+  // with the wait set loop, that never uses any executor.
+  m_control_group = this->create_callback_group(
+      rclcpp::CallbackGroupType::MutuallyExclusive,
+      /* automatically_add_to_executor_with_node = */
+      !m_impl->realtime.enabled &&
+          (m_impl->control.loop == ControlLoop::kExecutor));
 
   // PUBLISHERS
-  RCLCPP_DEBUG(get_logger(), "Declaring publishers: ...");
-  RCLCPP_INFO(get_logger(), "Declaring publishers: DONE");
+  RCLCPP_DEBUG(this->get_logger(), "Declaring publishers: ...");
+  // Not a lifecycle publisher: only SetActive() gates the control path.
+  // The shared memory loop pushes its commands to the driver instead.
+  for (std::size_t k = 0; k < m_impl->streams.size(); ++k) {
+    m_batch_outputs.push_back(rclcpp::create_publisher<joint_state_t>(
+        *this, batch_outputs[k], rclcpp::QoS{/* depth = */ 5}));
+  }
+
+  if (m_impl->streams.empty() &&
+      (m_impl->control.loop != ControlLoop::kShm)) {
+    m_output = rclcpp::create_publisher<joint_state_t>(
+        *this, "command", rclcpp::QoS{/* depth = */ 5});
+  }
+
+  // Best effort: the debug subscribers never slow down the debug publisher,
+  // which never slows down the control path
+  if (m_impl->debug_decimation > 0) {
+    m_debug_output = rclcpp::create_publisher<joint_state_t>(
+        *this, "command/debug", rclcpp::QoS{/* depth = */ 5}.best_effort());
+  }
+  RCLCPP_INFO(this->get_logger(), "Declaring publishers: DONE");
 
   // SUBSCRIBERS
-  RCLCPP_DEBUG(get_logger(), "Declaring subscribers: ...");
-  // m_input = create_subscription<joint_state_t>(
-  //     "joint_state", rclcpp::QoS{/* depth = */ 5},
-  //     [](const joint_state_t &joint_state) {
-  //       // TODO
-  //       (void)joint_state;
-  //     });
-  RCLCPP_INFO(get_logger(), "Declaring subscribers: DONE");
+  RCLCPP_DEBUG(this->get_logger(), "Declaring subscribers: ...");
+
+  // Forward either the JointState or the serialized JointState of \a topic to
+  // the generic \a on_joint_state
+  const auto subscribe = [this](
+                             const std::string &topic, auto &&on_joint_state,
+                             const rclcpp::SubscriptionOptions &sub_options) {
+    const auto qos = rclcpp::QoS{/* depth = */ 5};
+    if (m_impl->serialized) {
+      return this->template create_subscription<joint_state_t>(
+          topic, qos,
+          [on_joint_state](const rclcpp::SerializedMessage &msg) {
+            on_joint_state(msg);
+          },
+          sub_options);
+    }
+
+    return this->template create_subscription<joint_state_t>(
+        topic, qos,
+        [on_joint_state](const joint_state_t &msg) { on_joint_state(msg); },
+        sub_options);
+  };
+
+  if (m_impl->control.loop == ControlLoop::kShm) {
+    // States are read from the driver transport (see SpinShm())
+  } else if (!m_impl->streams.empty()) {
+    // Batch: same as the fixed rate, per stream, the timer solving all their
+    // newest states at once
+    for (std::size_t k = 0; k < batch_inputs.size(); ++k) {
+      m_batch_inputs.push_back(subscribe(
+          batch_inputs[k],
+          [this, k](const auto &joint_state) {
+            StoreBatchState(k, joint_state);
+          },
+          rclcpp::SubscriptionOptions{}));
+    }
+
+    m_timer = this->create_wall_timer(
+        std::chrono::nanoseconds{
+            static_cast<std::int64_t>(1e9 / m_impl->control.rate)},
+        [this]() { OnBatchTick(); }, m_control_group);
+  } else if (m_impl->control.rate > 0.) {
+    // Fixed rate: the subscription (default group) only stores the newest
+    // state, consumed by the timer of the control group
+    m_input = subscribe(
+        "joint_state",
+        [this](const auto &joint_state) { StoreJointState(joint_state); },
+        rclcpp::SubscriptionOptions{});
+
+    m_timer = this->create_wall_timer(
+        std::chrono::nanoseconds{
+            static_cast<std::int64_t>(1e9 / m_impl->control.rate)},
+        [this]() { OnControlTick(); }, m_control_group);
+  } else {
+    auto sub_options = rclcpp::SubscriptionOptions{};
+    sub_options.callback_group = m_control_group;
+
+    m_input = subscribe(
+        "joint_state",
+        [this](const auto &joint_state) { OnJointState(joint_state); },
+        sub_options);
+  }
+
+  // State sources (default group): each subscription only stores the newest
+  // values of its source, snapshotted by the control path (lock free)
+  for (std::size_t k = 0; k < m_impl->sources.size(); ++k) {
+    const auto &source = m_impl->sources[k];
+    std::visit(
+        [&](const auto &fields) {
+          using field_t = typename std::decay_t<decltype(fields)>::value_type;
+          using msg_t = SourceMessage_t<field_t>;
+          m_source_inputs.push_back(this->template create_subscription<msg_t>(
+              source.topic, rclcpp::QoS{/* depth = */ 5},
+              [this, k, fields](const msg_t &msg) {
+                StoreSourceState(k, msg, fields);
+              }));
+        },
+        source.fields);
+  }
+  if (stream_model) {
+    // Default group: the model is only written by the default callback group,
+    // never concurrently (see also 'gains/patch/*' parameters)
+    using gains_msg_t = std_msgs::msg::Float64MultiArray;
+    m_gains_input = this->template create_subscription<gains_msg_t>(
+        "gains", rclcpp::QoS{/* depth = */ 1},
+        [this](const gains_msg_t &msg) {
+          if (auto error = m_impl->StreamModel(msg); error.has_value()) {
+            RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(),
+                                 1000, "Dropping gains: %s", error->c_str());
+          }
+        });
+  }
+  RCLCPP_INFO(this->get_logger(), "Declaring subscribers: DONE");
+
+  // DIAGNOSTICS
+  // Default group: never competes with the control path, only reading the
+  // latencies recorded (wait free)
+  if (diagnostics) {
+    using diagnostics_msg_t = diagnostic_msgs::msg::DiagnosticArray;
+    m_diagnostics_output = rclcpp::create_publisher<diagnostics_msg_t>(
+        *this, "/diagnostics", rclcpp::QoS{/* depth = */ 10});
+
+    m_diagnostics_timer = this->create_wall_timer(
+        std::chrono::nanoseconds{
+            static_cast<std::int64_t>(1e9 * diagnostics_period)},
+        [this]() {
+          auto msg = diagnostics_msg_t{};
+          msg.header.stamp = this->now();
+          auto &status = msg.status.emplace_back(MakeDiagnosticStatus(
+              m_impl->step->Stats(),
+              std::string{this->get_fully_qualified_name()} +
+                  ": control path",
+              m_impl->reported_misses));
+
+          if (const auto *error = m_impl->step->PerfError();
+              error != nullptr) {
+            auto &value = status.values.emplace_back();
+            value.key = "perf counters";
+            value.value = "unavailable: " + *error;
+          }
+
+          if (const auto *on_change = m_impl->step->OnChange();
+              on_change != nullptr) {
+            auto &value = status.values.emplace_back();
+            value.key = "commands suppressed (unchanged)";
+            value.value = std::to_string(on_change->Suppressed());
+          }
+          m_diagnostics_output->publish(msg);
+        });
+  }
+
+  // DEBUG
+  // Default group: publishes the copies pushed by the control path (wait
+  // free), see 'debug/*'
+  if (m_debug_output != nullptr) {
+    const auto period = this->get_parameter("debug/period").as_double();
+    m_debug_timer = this->create_wall_timer(
+        std::chrono::nanoseconds{static_cast<std::int64_t>(1e9 * period)},
+        [this]() { m_impl->PublishDebug(*m_debug_output); });
+  }
+
+  // FLIGHT RECORDER
+  // Default group: dumping only reads the ring, never blocking the control
+  // path (records overwritten while dumped are dropped by the decoder)
+  if (m_impl->step->Recorder() != nullptr) {
+    using trigger_t = std_srvs::srv::Trigger;
+    m_dump_flight = this->template create_service<trigger_t>(
+        "~/dump_flight_recorder",
+        [this](std::shared_ptr<trigger_t::Request> /* request */,
+               std::shared_ptr<trigger_t::Response> response) {
+          const auto &path = m_impl->recorder_path;
+          response->success = m_impl->step->Recorder()->DumpTo(path.c_str());
+          response->message =
+              response->success
+                  ? ("Dumped into '" + path + "'")
+                  : ("Can't dump into '" + path + "' (" +
+                     std::strerror(errno) + ")");
+        });
+  }
+
+  // THREADS
+  if (m_impl->control.pipeline) {
+    m_impl->solver_running = true;
+    m_impl->solver = std::thread([this]() { SpinSolver(); });
+  }
+
+  // WARM UP
+  // Fault in the pages and train the branch predictors of the control path
+  m_impl->step->WarmUp(LinearFeedbackNodeImpl::kWarmUpSolves);
+
+  RCLCPP_INFO(this->get_logger(), "Starting: DONE");
+}
+
+template <class NodeBase>
+auto BasicLinearFeedbackNode<NodeBase>::Cleanup() -> void {
+  RCLCPP_DEBUG(this->get_logger(), "Cleaning up: ...");
+
+  SetActive(false);
+  if (m_impl->solver.joinable()) {
+    m_impl->solver_running = false;
+    m_impl->solver.join();
+  }
+
+  m_dump_flight.reset();
+  m_diagnostics_timer.reset();
+  m_diagnostics_output.reset();
+  m_debug_timer.reset();
+  m_debug_output.reset();
+  m_on_set_model.reset();
+  m_gains_input.reset();
+  m_timer.reset();
+  m_batch_inputs.clear();
+  m_batch_outputs.clear();
+  m_source_inputs.clear();
+  m_input.reset();
+  m_output.reset();
+  m_control_group.reset();
+  m_impl = std::make_unique<LinearFeedbackNodeImpl>();
+
+  RCLCPP_INFO(this->get_logger(), "Cleaning up: DONE");
+}
+
+template <class NodeBase>
+auto BasicLinearFeedbackNode<NodeBase>::SetActive(bool active) noexcept
+    -> void {
+  m_impl->active.store(active, std::memory_order_release);
+}
+
+template <class NodeBase>
+BasicLinearFeedbackNode<NodeBase>::~BasicLinearFeedbackNode() noexcept {
+  RCLCPP_DEBUG(this->get_logger(), "Shutdown: ...");
+
+  if (m_impl->solver.joinable()) {
+    m_impl->solver_running = false;
+    m_impl->solver.join();
+  }
+
+  RCLCPP_INFO(this->get_logger(), "Shutdown: DONE");
+}
+
+template <class NodeBase>
+auto BasicLinearFeedbackNode<NodeBase>::ControlCallbackGroup() const
+    -> rclcpp::CallbackGroup::SharedPtr {
+  return m_control_group;
+}
+
+template <class NodeBase>
+auto BasicLinearFeedbackNode<NodeBase>::RealtimeSettings() const
+    -> const RealtimeConfig & {
+  return m_impl->realtime;
+}
+
+template <class NodeBase>
+auto BasicLinearFeedbackNode<NodeBase>::ControlSettings() const
+    -> const ControlConfig & {
+  return m_impl->control;
+}
+
+template <class NodeBase>
+auto BasicLinearFeedbackNode<NodeBase>::SpinWaitSet() -> void {
+  assert(m_impl->control.loop == ControlLoop::kWaitSet);
+
+  // Reused by every take(), keeping the buffers capacity between messages
+  auto joint_state = joint_state_t{};
+  auto serialized = rclcpp::SerializedMessage{};
+  auto info = rclcpp::MessageInfo{};
+
+  const auto take_all = [&]() {
+    if (m_impl->serialized) {
+      while (m_input->take_serialized(serialized, info)) {
+        OnJointState(serialized);
+      }
+    } else {
+      while (m_input->take(joint_state, info)) {
+        OnJointState(joint_state);
+      }
+    }
+  };
+
+  if (m_impl->control.busy_poll) {
+    while (rclcpp::ok()) {
+      take_all();
+    }
+  } else {
+    using wait_set_t = rclcpp::StaticWaitSet<1, 0, 0, 0, 0, 0>;
+    auto wait_set = wait_set_t{
+        std::array<wait_set_t::SubscriptionEntry, 1>{{{m_input}}},
+    };
+
+    // Bounded wait, in order to periodically check rclcpp::ok()
+    constexpr auto kTimeout = std::chrono::milliseconds{100};
+    while (rclcpp::ok()) {
+      if (wait_set.wait(kTimeout).kind() == rclcpp::WaitResultKind::Ready) {
+        take_all();
+      }
+    }
+  }
+}
+
+template <class NodeBase>
+auto BasicLinearFeedbackNode<NodeBase>::SpinShm() -> void {
+  assert(m_impl->control.loop == ControlLoop::kShm);
+  auto &impl = *m_impl;
+  auto &states = impl.transport->States();
+  auto &commands = impl.transport->Commands();
+
+  // Bounded wait, in order to periodically check rclcpp::ok()
+  constexpr auto kTimeout = std::chrono::milliseconds{100};
+  while (rclcpp::ok()) {
+    if (states.Wait(kTimeout) == nullptr) continue;
+
+    // Only the newest state matters: the older ones are dropped
+    for (auto pending = states.Pending(); pending > 1; --pending) {
+      states.Release();
+      impl.step->Stats().Drop();
+      LFC_PROBE(drop, static_cast<int>(GatherStatus::kSuperseded));
+    }
+    const auto *const state = states.TryPeek();
+
+    // Inactive (lifecycle node only): dropped without being solved
+    if (impl.active.load(std::memory_order_acquire)) {
+      impl.SolveShm(*state, commands);
+    }
+    states.Release();
+  }
+}
+
+template <class NodeBase>
+template <class JointStateMsg>
+auto BasicLinearFeedbackNode<NodeBase>::OnJointState(
+    const JointStateMsg &joint_state) -> void {
+  auto &impl = *m_impl;
+
+  // Inactive (lifecycle node only): dropped without even being gathered
+  if (!impl.active.load(std::memory_order_acquire)) return;
+
+  if (impl.control.pipeline) {
+    PushJointState(joint_state);
+    return;
+  }
+
+  if (auto status = impl.Gather(joint_state, impl.state, impl.latched);
+      (status != GatherStatus::kOk) ||
+      ((status = impl.FuseSources(impl.state)) != GatherStatus::kOk)) {
+    WarnDropped(*this, impl.step->Stats(), status, impl.joint_state_size);
+    return;
+  }
+
+  impl.SolveAndPublish(impl.state, *m_output);
+}
+
+template <class NodeBase>
+template <class JointStateMsg>
+auto BasicLinearFeedbackNode<NodeBase>::StoreJointState(
+    const JointStateMsg &joint_state) -> void {
+  auto &slot = m_impl->latest_state.Back();
+
+  if (const auto status = m_impl->Gather(joint_state, slot, m_impl->latched);
+      status != GatherStatus::kOk) {
+    WarnDropped(*this, m_impl->step->Stats(), status,
+                m_impl->joint_state_size);
+    return;
+  }
+
+  m_impl->latest_state.Post();
+}
+
+template <class NodeBase>
+auto BasicLinearFeedbackNode<NodeBase>::OnControlTick() -> void {
+  auto &impl = *m_impl;
+  if (!impl.active.load(std::memory_order_acquire)) return;
+
+  // Older states are skipped: only the newest is fetched
+  impl.has_state = impl.latest_state.Fetch() || impl.has_state;
+  if (!impl.has_state) return;
+
+  // The sources are snapshotted on each tick, even without a new JointState
+  auto &latest = impl.latest_state.Front();
+  if (const auto status = impl.FuseSources(latest);
+      status != GatherStatus::kOk) {
+    WarnDropped(*this, impl.step->Stats(), status, impl.joint_state_size);
+    return;
+  }
+
+  impl.SolveAndPublish(latest, *m_output);
+}
+
+template <class NodeBase>
+template <class SourceMsg, class Field>
+auto BasicLinearFeedbackNode<NodeBase>::StoreSourceState(
+    std::size_t source, const SourceMsg &msg,
+    const std::vector<Field> &fields) -> void {
+  auto &state_source = m_impl->sources[source];
+  const auto received = ControlPathStats::clock::now();
+
+  if (!GatherInto(msg, fields, state_source.scratch)) {
+    RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 1000,
+                         "Dropping '%s' state source message: its fields "
+                         "values don't match its 'size' (%ld)",
+                         state_source.name.c_str(), state_source.size);
+    return;
+  }
+
+  m_impl->fusion.Store(source, state_source.scratch.data(), received);
+}
+
+template <class NodeBase>
+template <class JointStateMsg>
+auto BasicLinearFeedbackNode<NodeBase>::StoreBatchState(
+    std::size_t stream, const JointStateMsg &joint_state) -> void {
+  auto &batch = m_impl->streams[stream];
+  auto &slot = batch.latest.Back();
+
+  if (const auto status = m_impl->Gather(joint_state, slot, batch.latched);
+      status != GatherStatus::kOk) {
+    WarnDropped(*this, m_impl->step->Stats(), status,
+                m_impl->joint_state_size);
+    return;
+  }
+
+  batch.latest.Post();
+}
+
+template <class NodeBase>
+auto BasicLinearFeedbackNode<NodeBase>::OnBatchTick() -> void {
+  if (!m_impl->active.load(std::memory_order_acquire)) return;
+  m_impl->SolveBatchAndPublish(m_batch_outputs);
+}
+
+template <class NodeBase>
+template <class JointStateMsg>
+auto BasicLinearFeedbackNode<NodeBase>::PushJointState(
+    const JointStateMsg &joint_state) -> void {
+  auto *const slot = m_impl->pipeline.TryClaim();
+  if (slot == nullptr) {
+    WarnDropped(*this, m_impl->step->Stats(), GatherStatus::kPipelineFull,
+                m_impl->step->Cols());
+    return;
+  }
+
+  if (auto status = m_impl->Gather(joint_state, *slot, m_impl->latched);
+      (status != GatherStatus::kOk) ||
+      ((status = m_impl->FuseSources(*slot)) != GatherStatus::kOk)) {
+    WarnDropped(*this, m_impl->step->Stats(), status,
+                m_impl->joint_state_size);
+    return;
+  }
+
+  m_impl->pipeline.Commit();
+}
+
+template <class NodeBase>
+auto BasicLinearFeedbackNode<NodeBase>::SpinSolver() -> void {
+  auto &impl = *m_impl;
+
+  if (impl.realtime.enabled) {
+    ReportRealtime(this->get_logger(), "solver SCHED_FIFO",
+                   SetThreadFifoPriority(impl.realtime.priority));
+  }
+
+  if (!impl.control.pipeline_cpus.empty()) {
+    ReportRealtime(this->get_logger(), "solver CPU affinity",
+                   SetThreadAffinity(impl.control.pipeline_cpus));
+  }
+
+  // Busy poll the pipeline, only yielding the CPU once it stays empty for a
+  // while. The solver is expected to be pinned to its own CPU.
+  constexpr int kSpinsBeforeYield = 1024;
+  int spins = 0;
+
+  while (impl.solver_running.load(std::memory_order_relaxed)) {
+    auto *const slot = impl.pipeline.TryPeek();
+    if (slot == nullptr) {
+      if (++spins >= kSpinsBeforeYield) {
+        spins = 0;
+        std::this_thread::yield();
+      }
+      continue;
+    }
+
+    spins = 0;
+    impl.SolveAndPublish(*slot, *m_output);
+    impl.pipeline.Release();
+  }
+}
+
+template struct BasicLinearFeedbackNode<rclcpp::Node>;
+template struct BasicLinearFeedbackNode<rclcpp_lifecycle::LifecycleNode>;
+
+LinearFeedbackNode::LinearFeedbackNode()
+    : LinearFeedbackNode(rclcpp::NodeOptions{}) {}
+
+LinearFeedbackNode::LinearFeedbackNode(const rclcpp::NodeOptions &options)
+    : BasicLinearFeedbackNode(options) {
+  Configure();
+  SetActive(true);
+}
+
+LinearFeedbackLifecycleNode::LinearFeedbackLifecycleNode()
+    : LinearFeedbackLifecycleNode(rclcpp::NodeOptions{}) {}
+
+LinearFeedbackLifecycleNode::LinearFeedbackLifecycleNode(
+    const rclcpp::NodeOptions &options)
+    : BasicLinearFeedbackNode(options) {}
+
+auto LinearFeedbackLifecycleNode::on_configure(const rclcpp_lifecycle::State &)
+    -> CallbackReturn {
+  try {
+    Configure();
+  } catch (const std::exception &) {
+    // Already logged: leave the node as it was before configuring
+    Cleanup();
+    return CallbackReturn::FAILURE;
+  }
+  return CallbackReturn::SUCCESS;
+}
+
+auto LinearFeedbackLifecycleNode::on_activate(const rclcpp_lifecycle::State &)
+    -> CallbackReturn {
+  SetActive(true);
+  return CallbackReturn::SUCCESS;
+}
+
+auto LinearFeedbackLifecycleNode::on_deactivate(
+    const rclcpp_lifecycle::State &) -> CallbackReturn {
+  SetActive(false);
+  return CallbackReturn::SUCCESS;
+}
 
-  RCLCPP_INFO(get_logger(), "Starting: DONE");
+auto LinearFeedbackLifecycleNode::on_cleanup(const rclcpp_lifecycle::State &)
+    -> CallbackReturn {
+  Cleanup();
+  return CallbackReturn::SUCCESS;
 }
 
-LinearFeedbackNode::~LinearFeedbackNode() noexcept {
-  RCLCPP_DEBUG(get_logger(), "Shutdown: ...");
-  RCLCPP_INFO(get_logger(), "Shutdown: DONE");
+auto LinearFeedbackLifecycleNode::on_shutdown(const rclcpp_lifecycle::State &)
+    -> CallbackReturn {
+  Cleanup();
+  return CallbackReturn::SUCCESS;
 }
 
 } // namespace lfc::ros
@@ -0,0 +1,14 @@
+#include <memory>
+
+#include "lfc/ros/shard_aggregator_node.hpp"
+#include "rclcpp/rclcpp.hpp"
+
+int main(int argc, char *argv[]) {
+  rclcpp::init(argc, argv);
+
+  auto node = std::make_shared<lfc::ros::ShardAggregatorNode>();
+  rclcpp::spin(node);
+
+  rclcpp::shutdown();
+  return 0;
+}
@@ -1,9 +1,246 @@
+#include <cstdint>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "lfc/ros/linear_feedback_lifecycle_node.hpp"
 #include "lfc/ros/linear_feedback_node.hpp"
+#include "lfc/ros/realtime.hpp"
+#include "lifecycle_msgs/msg/state.hpp"
 #include "rclcpp/rclcpp.hpp"
 
+namespace {
+
+constexpr std::string_view kUsage =
+    "Usage: lfc [OPTIONS] [--ros-args ...]\n"
+    "\n"
+    "  --lifecycle            Run the managed (lifecycle) node, configured on\n"
+    "                         startup then (de)activated through its\n"
+    "                         lifecycle services\n"
+    "\n"
+    "Real-time options (shortcuts for the 'realtime/*' node parameters):\n"
+    "  --realtime             Run the control path on a SCHED_FIFO thread\n"
+    "  --rt-priority <1-99>   SCHED_FIFO priority of the control thread\n"
+    "  --rt-cpus <cpu,...>    CPUs the control thread is pinned to\n"
+    "  --no-mlockall          Don't lock the process memory\n"
+    "\n"
+    "Options (shortcuts for the 'control/*' node parameters):\n"
+    "  --wait-set             Drive the control path from a wait set loop\n"
+    "  --shm <NAME>           Exchange the states/commands with a co-located\n"
+    "                         driver through the shared memory object NAME\n"
+    "  --busy-poll            Poll the wait set (or shm) loop without "
+    "sleeping\n"
+    "\n"
+    "Options (shortcuts for the 'shard/*' node parameters):\n"
+    "  --shard <BEGIN,END>    Only solve the rows [BEGIN, END) of the model,\n"
+    "                         publishing partial commands (see lfc-aggregator)"
+    "\n";
+
+/// Parse a comma separated list of integers (e.g. "2,3")
+auto ParseIntList(std::string_view str, std::vector<std::int64_t> &out)
+    -> bool {
+  auto stream = std::istringstream{std::string{str}};
+  for (std::string item; std::getline(stream, item, ',');) {
+    try {
+      out.push_back(std::stoll(item));
+    } catch (const std::exception &) {
+      return false;
+    }
+  }
+  return !out.empty();
+}
+
+/**
+ *  \brief Translate the CLI flags (without ROS args) into parameter overrides
+ *
+ *  \param[out] lifecycle Whether the lifecycle node is requested
+ *
+ *  \return False when the args are invalid
+ */
+auto AppendCliOverrides(const std::vector<std::string> &args,
+                        rclcpp::NodeOptions &options, bool &lifecycle)
+    -> bool {
+  // args[0] is the program name
+  for (std::size_t i = 1; i < args.size(); ++i) {
+    const auto &arg = args[i];
+    const auto has_value = (i + 1) < args.size();
+
+    if (arg == "--lifecycle") {
+      lifecycle = true;
+    } else if (arg == "--realtime") {
+      options.append_parameter_override("realtime/enabled", true);
+    } else if (arg == "--no-mlockall") {
+      options.append_parameter_override("realtime/lock_memory", false);
+    } else if (arg == "--wait-set") {
+      options.append_parameter_override("control/loop",
+                                        std::string{"wait_set"});
+    } else if ((arg == "--shm") && has_value) {
+      options.append_parameter_override("control/loop", std::string{"shm"});
+      options.append_parameter_override("control/shm/name", args[++i]);
+    } else if (arg == "--busy-poll") {
+      options.append_parameter_override("control/busy_poll", true);
+    } else if ((arg == "--rt-priority") && has_value) {
+      try {
+        options.append_parameter_override(
+            "realtime/priority", std::int64_t{std::stoll(args[++i])});
+      } catch (const std::exception &) {
+        return false;
+      }
+    } else if ((arg == "--shard") && has_value) {
+      auto rows = std::vector<std::int64_t>{};
+      if (!ParseIntList(args[++i], rows) || (rows.size() != 2)) return false;
+      options.append_parameter_override("shard/rows_begin", rows[0]);
+      options.append_parameter_override("shard/rows_end", rows[1]);
+    } else if ((arg == "--rt-cpus") && has_value) {
+      auto cpus = std::vector<std::int64_t>{};
+      if (!ParseIntList(args[++i], cpus)) return false;
+      options.append_parameter_override("realtime/cpus", cpus);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ *  \brief Lifecycle node (see --lifecycle) whose control path may be spun by
+ *         lfc, on a dedicated thread (see SpinControlThread())
+ *
+ *  This thread keeps spinning the control path configured on startup: the
+ *  node then refuses to be cleaned up (or shut down) while lfc runs.
+ */
+struct ManagedNode final : public lfc::ros::LinearFeedbackLifecycleNode {
+  using LinearFeedbackLifecycleNode::LinearFeedbackLifecycleNode;
+
+  auto on_cleanup(const rclcpp_lifecycle::State &state)
+      -> CallbackReturn override {
+    if (RefuseCleanup()) return CallbackReturn::FAILURE;
+    return LinearFeedbackLifecycleNode::on_cleanup(state);
+  }
+
+  auto on_shutdown(const rclcpp_lifecycle::State &state)
+      -> CallbackReturn override {
+    if (RefuseCleanup()) return CallbackReturn::FAILURE;
+    return LinearFeedbackLifecycleNode::on_shutdown(state);
+  }
+
+  bool control_thread = false; /*!< Set before spinning the node */
+
+ private:
+  auto RefuseCleanup() const -> bool {
+    if (control_thread) {
+      RCLCPP_ERROR(get_logger(), "Can't clean up the node: its control path "
+                                 "is spun by lfc on a dedicated thread");
+    }
+    return control_thread;
+  }
+};
+
+/// \return True when the control path of \a node needs a dedicated thread
+template <class NodeT>
+auto NeedsControlThread(const NodeT &node) -> bool {
+  return node.RealtimeSettings().enabled ||
+         (node.ControlSettings().loop != lfc::ros::ControlLoop::kExecutor);
+}
+
+/**
+ *  \brief Spin the node, with its control path on a dedicated thread
+ *
+ *  The control path is either the control callback group, spun by its own
+ *  executor, the node's wait set loop, or its shared memory loop (see
+ *  'control/loop').
+ *
+ *  When 'realtime/enabled' is set, this thread is also configured for
+ *  real-time (the process memory being already locked by the node, when
+ *  configured). Every real-time setting is best effort: failures (e.g.
+ *  missing privileges) are reported and the node runs anyway.
+ *
+ *  \tparam NodeT Either a LinearFeedbackNode or a (configured)
+ *          LinearFeedbackLifecycleNode
+ */
+template <class NodeT>
+auto SpinControlThread(const std::shared_ptr<NodeT> &node) -> void {
+  const auto &rt = node->RealtimeSettings();
+  const auto &control = node->ControlSettings();
+  const auto logger = node->get_logger();
+
+  rclcpp::executors::SingleThreadedExecutor control_executor;
+  if (control.loop == lfc::ros::ControlLoop::kExecutor) {
+    control_executor.add_callback_group(node->ControlCallbackGroup(),
+                                        node->get_node_base_interface());
+  }
+
+  auto control_thread = std::thread([&]() {
+    if (rt.enabled) {
+      lfc::ros::ReportRealtime(logger, "SCHED_FIFO",
+                               lfc::ros::SetThreadFifoPriority(rt.priority));
+
+      if (!rt.cpus.empty()) {
+        lfc::ros::ReportRealtime(logger, "CPU affinity",
+                                 lfc::ros::SetThreadAffinity(rt.cpus));
+      }
+
+      lfc::ros::PrefaultStack(rt.stack_bytes);
+    }
+
+    switch (control.loop) {
+      case lfc::ros::ControlLoop::kExecutor: control_executor.spin(); break;
+      case lfc::ros::ControlLoop::kWaitSet: node->SpinWaitSet(); break;
+      case lfc::ros::ControlLoop::kShm: node->SpinShm(); break;
+    }
+  });
+
+  // Everything else (parameters, ...) runs on the default, non-RT, thread
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(node->get_node_base_interface());
+  executor.spin();
+
+  control_executor.cancel();
+  control_thread.join();
+}
+
+/// Spin \a node, its control path on a dedicated thread when needed
+template <class NodeT>
+auto Spin(const std::shared_ptr<NodeT> &node) -> void {
+  if (NeedsControlThread(*node)) {
+    SpinControlThread(node);
+  } else {
+    rclcpp::spin(node->get_node_base_interface());
+  }
+}
+
+} // namespace
+
 int main(int argc, char *argv[]) {
   rclcpp::init(argc, argv);
-  rclcpp::spin(std::make_shared<lfc::ros::LinearFeedbackNode>());
+
+  auto options = rclcpp::NodeOptions{};
+  auto lifecycle = false;
+  if (!AppendCliOverrides(rclcpp::remove_ros_arguments(argc, argv), options,
+                          lifecycle)) {
+    std::fputs(kUsage.data(), stderr);
+    rclcpp::shutdown();
+    return 1;
+  }
+
+  if (lifecycle) {
+    // The control path (and its settings) only exists once configured
+    auto node = std::make_shared<ManagedNode>(options);
+    if (node->configure().id() !=
+        lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE) {
+      rclcpp::shutdown();
+      return 1;
+    }
+
+    node->control_thread = NeedsControlThread(*node);
+    Spin(node);
+  } else {
+    Spin(std::make_shared<lfc::ros::LinearFeedbackNode>(options));
+  }
+
   rclcpp::shutdown();
   return 0;
 }
@@ -18,8 +18,9 @@ using DeclareParamIntoFreeFunction = decltype(DeclareParamInto(
 
 }
 
-template <class AnyParam, class... Others>
-auto DeclareParams(rclcpp::Node &node, AnyParam &&param, Others &&...others) {
+/// Declare all the params into \a node (any rclcpp::Node like node)
+template <class NodeT, class AnyParam, class... Others>
+auto DeclareParams(NodeT &node, AnyParam &&param, Others &&...others) {
   static_assert(
       (internal::HasTrait_v<details::DeclareParamIntoFreeFunction, AnyParam> &&
        ... &&
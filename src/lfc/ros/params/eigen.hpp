@@ -1,7 +1,10 @@
 #pragma once
 
 // SYSTEM
+#include <optional>
+#include <string_view>
 #include <type_traits>
+#include <vector>
 
 // INTERNAL
 #include "declare_params.hpp"
@@ -17,6 +20,30 @@
 
 namespace lfc::ros {
 
+/// Storage order of the values of a matrix parameter (e.g. gains/values)
+enum class StorageOrder {
+  kRowMajor,
+  kColMajor,
+};
+
+constexpr auto ToString(StorageOrder order) noexcept -> std::string_view {
+  switch (order) {
+    case StorageOrder::kRowMajor: return "row_major";
+    case StorageOrder::kColMajor: return "column_major";
+  }
+
+  return "";
+}
+
+/// \return The StorageOrder named \a name (see ToString()), if any
+constexpr auto StorageOrderFrom(std::string_view name) noexcept
+    -> std::optional<StorageOrder> {
+  for (auto order : {StorageOrder::kRowMajor, StorageOrder::kColMajor}) {
+    if (name == ToString(order)) return order;
+  }
+  return std::nullopt;
+}
+
 namespace details {
 
 /// TODO
@@ -49,99 +76,34 @@ constexpr bool IsMatrixBase_v = IsMatrixBase<T>::value;
 
 } // namespace details
 
-template <class T>
-struct ParamEigenMatrix : public ParamWithName {
-  static_assert(details::IsDenseBase_v<T> && (T::NumDimensions == 2));
-
-  constexpr ParamEigenMatrix() = delete;
-  constexpr ParamEigenMatrix(std::string_view name) : ParamWithName(name) {}
-};
-
-template <class T>
-auto DeclareParamInto(rclcpp::Node &node,
-                      const ParamEigenMatrix<T> &param) -> T {
-  T matrix;
-
-  auto [rows, cols] = DeclareParams(
-      node,
-      ParamRaw<std::int64_t>(std::string{param.Name()} + "/shape/rows")
-          .ReadOnly(T::RowsAtCompileTime != Eigen::Dynamic)
-          .DefaultTo(T::RowsAtCompileTime)
-          .WithDescription("The number of rows of the matrix")
-          .WithConstraints("Must to be >= 0"),
-      ParamRaw<std::int64_t>(std::string{param.Name()} + "/shape/cols")
-          .ReadOnly(T::ColsAtCompileTime != Eigen::Dynamic)
-          .DefaultTo(T::ColsAtCompileTime)
-          .WithDescription("The number of cols of the matrix")
-          .WithConstraints("Must to be >= 0"));
-
-  if ((T::SizeAtCompileTime == Eigen::Dynamic) && (rows >= 0 && cols >= 0)) {
-    matrix.resize(rows, cols);
-  }
-
-  using value_type = std::conditional_t<std::is_integral_v<typename T::Scalar>,
-                                        std::int64_t, double>;
-  auto values = DeclareParams(
-      node,
-      ParamRaw(std::string{param.Name()} + "/values", std::vector<value_type>{})
-          .WithDescription("The initial values (row major) (default to ZERO if "
-                           "not provided or invalid w.r.t. the shape)"));
-
-  if (values.size() == static_cast<std::size_t>(matrix.size())) {
-    matrix = Eigen::Map<T>(values.data(), matrix.rows(), matrix.cols());
+/**
+ *  \brief Copy the \a values of a matrix/vector parameter into \a out,
+ *         stored as set by \a order (irrelevant for vectors), keeping its
+ *         shape
+ *
+ *  \return False, leaving \a out untouched, when \a values size doesn't match
+ *          \a out size
+ */
+template <class T, class V>
+auto AssignParamValues(const std::vector<V> &values, T &out,
+                       StorageOrder order = StorageOrder::kRowMajor) -> bool {
+  static_assert(details::IsDenseBase_v<T>);
+
+  if (values.size() != static_cast<std::size_t>(out.size())) return false;
+
+  using row_major_t =
+      Eigen::Matrix<V, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+  using col_major_t =
+      Eigen::Matrix<V, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor>;
+
+  if (order == StorageOrder::kRowMajor) {
+    out = Eigen::Map<const row_major_t>(values.data(), out.rows(), out.cols())
+              .template cast<typename T::Scalar>();
   } else {
-    matrix.setZero();
+    out = Eigen::Map<const col_major_t>(values.data(), out.rows(), out.cols())
+              .template cast<typename T::Scalar>();
   }
-
-  return matrix;
-}
-
-template <class T>
-struct ParamEigenVector : public ParamWithName {
-  static_assert(details::IsDenseBase_v<T> && (T::NumDimensions < 2));
-
-  constexpr ParamEigenVector() = delete;
-  constexpr ParamEigenVector(std::string_view name) : ParamWithName(name) {}
-};
-
-template <class T>
-auto DeclareParamInto(rclcpp::Node &node,
-                      const ParamEigenVector<T> &param) -> T {
-  T vector;
-
-  auto size = DeclareParams(
-      node, ParamRaw<std::int64_t>(std::string{param.Name()} + "/size")
-                .ReadOnly(T::SizeAtCompileTime != Eigen::Dynamic)
-                .DefaultTo(T::SizeAtCompileTime)
-                .WithDescription("The size of the vector")
-                .WithConstraints("Must to be >= 0"));
-
-  if ((T::SizeAtCompileTime == Eigen::Dynamic) && (size > 0)) {
-    vector.resize(size);
-  }
-
-  using value_type = std::conditional_t<std::is_integral_v<typename T::Scalar>,
-                                        std::int64_t, double>;
-
-  auto values = DeclareParams(
-      node,
-      ParamRaw(std::string{param.Name()} + "/values", std::vector<value_type>{})
-          .WithDescription("The initial values (default to ZERO if not "
-                           "provided or invalid w.r.t. the size)"));
-
-  // Induce the size from values when /size is not set
-  if ((T::SizeAtCompileTime == Eigen::Dynamic) &&
-      ((vector.size() == 0) && !values.empty())) {
-    vector.resize(static_cast<Eigen::Index>(values.size()));
-  }
-
-  if (values.size() == static_cast<std::size_t>(vector.size())) {
-    vector = Eigen::Map<T>(values.data(), vector.size());
-  } else {
-    vector.setZero();
-  }
-
-  return vector;
+  return true;
 }
 
 } // namespace lfc::ros
@@ -69,11 +69,21 @@ template <class T, std::enable_if_t<std::is_constructible_v<std::string, T>,
                                     bool> = true>
 ParamRaw(std::string_view, T) -> ParamRaw<std::string>;
 
-template <class T>
-constexpr auto DeclareParamInto(rclcpp::Node &node,
-                                const ParamRaw<T> &param) -> T {
-  return node.declare_parameter<T>(param.Name(), param.DefaultValue(),
-                                   param.Descr());
+/**
+ *  \brief Declare \a param into \a node (any rclcpp::Node like node)
+ *
+ *  A parameter already declared (e.g. by a previous configuration of a
+ *  lifecycle node) is not declared again, its current value is returned.
+ */
+template <class T, class NodeT>
+constexpr auto DeclareParamInto(NodeT &node, const ParamRaw<T> &param) -> T {
+  const auto &name = param.Name();
+  if (node.has_parameter(name)) {
+    return node.get_parameter(name).template get_value<T>();
+  }
+
+  return node.template declare_parameter<T>(name, param.DefaultValue(),
+                                            param.Descr());
 }
 
 } // namespace lfc::ros
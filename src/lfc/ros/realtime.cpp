@@ -0,0 +1,106 @@
+#include "lfc/ros/realtime.hpp"
+
+// System
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#ifdef __GLIBC__
+#  include <malloc.h>
+#endif
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+// ROS
+#include "rclcpp/logging.hpp"
+
+namespace lfc::ros {
+
+namespace {
+
+/// Granularity used to touch memory (lower or equal to any page size)
+constexpr std::size_t kTouchStep = 4096;
+
+/**
+ *  \brief Recursively consume \a chunks * kTouchStep bytes of stack
+ *
+ *  The volatile frame is read AFTER the recursive call, preventing the compiler
+ *  from turning the recursion into a loop reusing the same frame.
+ */
+[[gnu::noinline]] auto TouchStack(std::size_t chunks) noexcept
+    -> unsigned char {
+  volatile unsigned char frame[kTouchStep];
+  frame[0] = 1;
+  frame[kTouchStep - 1] = 1;
+
+  const unsigned char below = (chunks > 1) ? TouchStack(chunks - 1) : 0;
+  return static_cast<unsigned char>(below + frame[0] + frame[kTouchStep - 1]);
+}
+
+} // namespace
+
+auto LockProcessMemory() noexcept -> int {
+#ifdef __GLIBC__
+  // Never trim the heap nor use mmap() for big allocations: freed memory stays
+  // in the (locked) arena and is reused without page faults.
+  mallopt(M_TRIM_THRESHOLD, -1);
+  mallopt(M_MMAP_MAX, 0);
+#endif
+
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+    return errno;
+  }
+  return 0;
+}
+
+auto PrefaultHeap(std::size_t bytes) noexcept -> int {
+  if (bytes == 0) return 0;
+
+  auto *const buffer = static_cast<unsigned char *>(std::malloc(bytes));
+  if (buffer == nullptr) return ENOMEM;
+
+  const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  for (std::size_t i = 0; i < bytes; i += page_size) {
+    // volatile: the writes must not be optimized away before the free()
+    static_cast<volatile unsigned char *>(buffer)[i] = 0;
+  }
+
+  std::free(buffer);
+  return 0;
+}
+
+auto PrefaultStack(std::size_t bytes) noexcept -> void {
+  if (bytes == 0) return;
+  (void)TouchStack((bytes + kTouchStep - 1) / kTouchStep);
+}
+
+auto SetThreadFifoPriority(int priority) noexcept -> int {
+  sched_param param{};
+  param.sched_priority = priority;
+  return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+}
+
+auto SetThreadAffinity(const std::vector<int> &cpus) noexcept -> int {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (const auto cpu : cpus) {
+    if ((cpu < 0) || (cpu >= CPU_SETSIZE)) return EINVAL;
+    CPU_SET(static_cast<std::size_t>(cpu), &set);
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+auto ReportRealtime(const rclcpp::Logger &logger, const char *setting,
+                    int error) -> void {
+  if (error == 0) {
+    RCLCPP_INFO(logger, "Real-time: %s: OK", setting);
+  } else {
+    RCLCPP_WARN(logger, "Real-time: %s: FAILED (%s), continuing without it",
+                setting, std::strerror(error));
+  }
+}
+
+} // namespace lfc::ros
@@ -0,0 +1,50 @@
+#pragma once
+
+// SYSTEM
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// EXT
+// -- ROS
+#include "builtin_interfaces/msg/time.hpp"
+
+namespace lfc::ros {
+
+/// Prefix of the frame_id of the partial commands published by a shard (see
+/// 'shard/*'), followed by the first row of the shard
+constexpr std::string_view kShardFramePrefix = "lfc/shard/rows/";
+
+/// \return The frame_id of the partial commands of the shard starting at the
+///         row \a begin
+inline auto ShardFrameId(std::size_t begin) -> std::string {
+  return std::string{kShardFramePrefix} + std::to_string(begin);
+}
+
+/// Parse the first row of a shard from the \a frame_id of its partial
+/// commands (see ShardFrameId()) into \a begin
+/// \return False when \a frame_id isn't the one of a shard
+inline auto ParseShardFrameId(std::string_view frame_id, std::size_t &begin)
+    -> bool {
+  if (frame_id.substr(0, kShardFramePrefix.size()) != kShardFramePrefix) {
+    return false;
+  }
+
+  const auto row = frame_id.substr(kShardFramePrefix.size());
+  const auto *const end = row.data() + row.size();
+  const auto [ptr, error] = std::from_chars(row.data(), end, begin);
+  return !row.empty() && (error == std::errc{}) && (ptr == end);
+}
+
+/// \return The sequence id of the state stamped with \a stamp: all the shards
+///         solve the same states, their stamp identifying them
+constexpr auto ShardSequence(const builtin_interfaces::msg::Time &stamp)
+    -> std::uint64_t {
+  return (std::uint64_t{static_cast<std::uint32_t>(stamp.sec)} *
+          1'000'000'000u) +
+         stamp.nanosec;
+}
+
+} // namespace lfc::ros
@@ -0,0 +1,105 @@
+#include "lfc/ros/shard_aggregator_node.hpp"
+
+// System
+#include <cstdint>
+#include <string>
+#include <utility>
+
+// Internal lfc - PRIVATE
+#include "params/declare_params.hpp"
+#include "params/raw.hpp"
+#include "shard.hpp"
+
+// Ext libs
+// -- ROS
+#include "rclcpp/create_publisher.hpp"
+#include "rclcpp/exceptions/exceptions.hpp"
+#include "rclcpp/logging.hpp"
+#include "rclcpp/qos.hpp"
+
+namespace lfc::ros {
+
+using joint_state_t = sensor_msgs::msg::JointState;
+
+ShardAggregatorNode::ShardAggregatorNode()
+    : ShardAggregatorNode(rclcpp::NodeOptions{}) {}
+
+ShardAggregatorNode::ShardAggregatorNode(const rclcpp::NodeOptions &options)
+    : rclcpp::Node(/* name = */ "lfc_aggregator", /* ns = */ "", options),
+      m_assembler(nullptr),
+      m_output(nullptr) {
+  const auto [inputs, rows, in_flight] = DeclareParams(
+      *this,
+      ParamRaw<std::vector<std::string>>("shards/inputs")
+          .ReadOnly()
+          .WithDescription("Partial command topics of the shards (see the "
+                           "'shard/*' parameters of lfc)")
+          .WithConstraints("Must not be empty"),
+      ParamRaw<std::int64_t>("shards/rows", 0)
+          .ReadOnly()
+          .WithDescription("Rows of the whole model, i.e. of the commands "
+                           "published")
+          .WithConstraints("Must be > 0"),
+      ParamRaw<std::int64_t>("shards/in_flight", 4)
+          .ReadOnly()
+          .WithDescription("Commands assembled at once, the oldest one being "
+                           "dropped when a partial command of a newer one "
+                           "is received while none is left")
+          .WithConstraints("Must be > 0"));
+
+  if (inputs.empty() || (rows <= 0) || (in_flight <= 0)) {
+    RCLCPP_FATAL(this->get_logger(),
+                 "Invalid 'shards/*' parameters (see their constraints)");
+    throw rclcpp::exceptions::InvalidParametersException{
+        "Invalid 'shards/*' parameters (see their constraints)"};
+  }
+
+  m_assembler = std::make_unique<ShardAssembler>(
+      static_cast<std::size_t>(rows), static_cast<std::size_t>(in_flight));
+  m_command.effort.assign(static_cast<std::size_t>(rows), 0.);
+
+  m_output = rclcpp::create_publisher<joint_state_t>(
+      *this, "command", rclcpp::QoS{/* depth = */ 5});
+
+  // Default (mutually exclusive) group: the assembler is never accessed
+  // concurrently
+  for (const auto &topic : inputs) {
+    m_inputs.push_back(this->create_subscription<joint_state_t>(
+        topic, rclcpp::QoS{/* depth = */ 5},
+        [this](const joint_state_t &partial) { OnPartialCommand(partial); }));
+  }
+
+  RCLCPP_INFO(this->get_logger(), "Assembling %ld rows from %zu shards",
+              rows, inputs.size());
+}
+
+auto ShardAggregatorNode::OnPartialCommand(const joint_state_t &partial)
+    -> void {
+  auto begin = std::size_t{0};
+  if (!ParseShardFrameId(partial.header.frame_id, begin)) {
+    RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 1000,
+                         "Dropping partial command: its frame_id ('%s') isn't "
+                         "the one of a shard",
+                         partial.header.frame_id.c_str());
+    return;
+  }
+
+  const auto dropped = m_assembler->Dropped();
+  const auto *const y =
+      m_assembler->Add(ShardSequence(partial.header.stamp), begin,
+                       partial.effort.data(), partial.effort.size());
+
+  if (m_assembler->Dropped() != dropped) {
+    RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 1000,
+                         "Dropped %lu incomplete commands so far (some "
+                         "shards are lagging behind)",
+                         m_assembler->Dropped());
+  }
+  if (y == nullptr) return;
+
+  m_command.effort.assign(y->begin(), y->end());
+  m_command.header.stamp = partial.header.stamp;
+  m_output->publish(m_command);
+}
+
+} // namespace lfc::ros
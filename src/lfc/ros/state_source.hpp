@@ -0,0 +1,248 @@
+#pragma once
+
+// SYSTEM
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+// INTERNAL
+#include "joint_state.hpp"
+
+// EXT
+// -- Eigen
+#include "Eigen/Core"
+
+// -- ROS
+#include "geometry_msgs/msg/quaternion.hpp"
+#include "geometry_msgs/msg/vector3.hpp"
+#include "geometry_msgs/msg/wrench_stamped.hpp"
+#include "sensor_msgs/msg/imu.hpp"
+#include "sensor_msgs/msg/joint_state.hpp"
+
+namespace lfc::ros {
+
+/// Imu fields that can be gathered into the state vector X (in the order of
+/// the message definition)
+enum class ImuField {
+  kOrientation,        /*!< x, y, z, w */
+  kAngularVelocity,    /*!< x, y, z */
+  kLinearAcceleration, /*!< x, y, z */
+};
+
+constexpr auto ToString(ImuField field) noexcept -> std::string_view {
+  switch (field) {
+    case ImuField::kOrientation: return "orientation";
+    case ImuField::kAngularVelocity: return "angular_velocity";
+    case ImuField::kLinearAcceleration: return "linear_acceleration";
+  }
+
+  return "";
+}
+
+/// WrenchStamped fields that can be gathered into the state vector X (in the
+/// order of the message definition)
+enum class WrenchField {
+  kForce,  /*!< x, y, z */
+  kTorque, /*!< x, y, z */
+};
+
+constexpr auto ToString(WrenchField field) noexcept -> std::string_view {
+  switch (field) {
+    case WrenchField::kForce: return "force";
+    case WrenchField::kTorque: return "torque";
+  }
+
+  return "";
+}
+
+/// \return The number of values of \a field
+constexpr auto SizeOf(ImuField field) noexcept -> Eigen::Index {
+  return (field == ImuField::kOrientation) ? 4 : 3;
+}
+
+/// \return The number of values of \a field
+constexpr auto SizeOf(WrenchField /* field */) noexcept -> Eigen::Index {
+  return 3;
+}
+
+/// \return The field of type Field named \a name, std::nullopt if unknown
+template <class Field>
+constexpr auto FieldFrom(std::string_view name) noexcept
+    -> std::optional<Field>;
+
+template <>
+constexpr auto FieldFrom<JointStateField>(std::string_view name) noexcept
+    -> std::optional<JointStateField> {
+  return JointStateFieldFrom(name);
+}
+
+template <>
+constexpr auto FieldFrom<ImuField>(std::string_view name) noexcept
+    -> std::optional<ImuField> {
+  for (auto field : {ImuField::kOrientation, ImuField::kAngularVelocity,
+                     ImuField::kLinearAcceleration}) {
+    if (ToString(field) == name) return field;
+  }
+  return std::nullopt;
+}
+
+template <>
+constexpr auto FieldFrom<WrenchField>(std::string_view name) noexcept
+    -> std::optional<WrenchField> {
+  for (auto field : {WrenchField::kForce, WrenchField::kTorque}) {
+    if (ToString(field) == name) return field;
+  }
+  return std::nullopt;
+}
+
+/// Ordered fields of a state source, whose type is given by the message
+/// gathered: JointState, Imu or WrenchStamped (see SourceMessage)
+using SourceFields =
+    std::variant<std::vector<JointStateField>, std::vector<ImuField>,
+                 std::vector<WrenchField>>;
+
+/// Type names of the state sources (same order as SourceFields)
+constexpr auto kSourceTypes =
+    std::array<std::string_view, 3>{"joint_state", "imu", "wrench"};
+
+/// Message gathered by the state sources whose fields are Field
+template <class Field>
+struct SourceMessage;
+
+template <>
+struct SourceMessage<JointStateField> {
+  using type = sensor_msgs::msg::JointState;
+};
+
+template <>
+struct SourceMessage<ImuField> {
+  using type = sensor_msgs::msg::Imu;
+};
+
+template <>
+struct SourceMessage<WrenchField> {
+  using type = geometry_msgs::msg::WrenchStamped;
+};
+
+template <class Field>
+using SourceMessage_t = typename SourceMessage<Field>::type;
+
+/**
+ *  \return The fields named \a names of the state source of type \a type
+ *          (one of kSourceTypes), std::nullopt if the type or any name is
+ *          unknown
+ */
+inline auto SourceFieldsFrom(std::string_view type,
+                             const std::vector<std::string> &names)
+    -> std::optional<SourceFields> {
+  const auto parse = [&](auto fields) -> std::optional<SourceFields> {
+    using field_t = typename decltype(fields)::value_type;
+    for (const auto &name : names) {
+      const auto field = FieldFrom<field_t>(name);
+      if (!field.has_value()) return std::nullopt;
+      fields.push_back(*field);
+    }
+    return fields;
+  };
+
+  if (type == kSourceTypes[0]) return parse(std::vector<JointStateField>{});
+  if (type == kSourceTypes[1]) return parse(std::vector<ImuField>{});
+  if (type == kSourceTypes[2]) return parse(std::vector<WrenchField>{});
+  return std::nullopt;
+}
+
+/// \return The number of values gathered from \a fields, std::nullopt when
+///         it depends on the message (JointState: number of joints)
+inline auto FixedSizeOf(const SourceFields &fields) noexcept
+    -> std::optional<Eigen::Index> {
+  return std::visit(
+      [](const auto &typed) -> std::optional<Eigen::Index> {
+        using field_t = typename std::decay_t<decltype(typed)>::value_type;
+        if constexpr (std::is_same_v<field_t, JointStateField>) {
+          return std::nullopt;
+        } else {
+          Eigen::Index size = 0;
+          for (auto field : typed) size += SizeOf(field);
+          return size;
+        }
+      },
+      fields);
+}
+
+namespace details {
+
+inline auto Assign(const geometry_msgs::msg::Vector3 &v,
+                   Eigen::Ref<Eigen::VectorXd> x) noexcept -> void {
+  x << v.x, v.y, v.z;
+}
+
+inline auto Assign(const geometry_msgs::msg::Quaternion &q,
+                   Eigen::Ref<Eigen::VectorXd> x) noexcept -> void {
+  x << q.x, q.y, q.z, q.w;
+}
+
+} // namespace details
+
+/**
+ *  \brief Concatenate the \a fields values of \a msg into \a x
+ *
+ *  \return True on success, false when the total number of values doesn't
+ *          match x.size() (x is left untouched)
+ */
+inline auto GatherInto(const sensor_msgs::msg::Imu &msg,
+                       const std::vector<ImuField> &fields,
+                       Eigen::Ref<Eigen::VectorXd> x) noexcept -> bool {
+  Eigen::Index expected_size = 0;
+  for (auto field : fields) expected_size += SizeOf(field);
+  if (expected_size != x.size()) return false;
+
+  Eigen::Index offset = 0;
+  for (auto field : fields) {
+    auto values = x.segment(offset, SizeOf(field));
+    switch (field) {
+      case ImuField::kOrientation:
+        details::Assign(msg.orientation, values);
+        break;
+      case ImuField::kAngularVelocity:
+        details::Assign(msg.angular_velocity, values);
+        break;
+      case ImuField::kLinearAcceleration:
+        details::Assign(msg.linear_acceleration, values);
+        break;
+    }
+    offset += SizeOf(field);
+  }
+
+  return true;
+}
+
+/// Same as GatherInto() for the WrenchStamped \a msg
+inline auto GatherInto(const geometry_msgs::msg::WrenchStamped &msg,
+                       const std::vector<WrenchField> &fields,
+                       Eigen::Ref<Eigen::VectorXd> x) noexcept -> bool {
+  Eigen::Index expected_size = 0;
+  for (auto field : fields) expected_size += SizeOf(field);
+  if (expected_size != x.size()) return false;
+
+  Eigen::Index offset = 0;
+  for (auto field : fields) {
+    auto values = x.segment(offset, SizeOf(field));
+    switch (field) {
+      case WrenchField::kForce:
+        details::Assign(msg.wrench.force, values);
+        break;
+      case WrenchField::kTorque:
+        details::Assign(msg.wrench.torque, values);
+        break;
+    }
+    offset += SizeOf(field);
+  }
+
+  return true;
+}
+
+} // namespace lfc::ros
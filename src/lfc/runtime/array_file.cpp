@@ -0,0 +1,195 @@
+#include "lfc/runtime/array_file.hpp"
+
+// System
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace lfc {
+
+namespace {
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "Only little endian hosts are supported");
+
+constexpr std::string_view kNpyMagic = "\x93NUMPY";
+
+/// \return The value of \a key (e.g. "'descr':") in the .npy \a header dict,
+///         up to the next ',' (or the matching ')' for tuples)
+auto NpyHeaderValue(std::string_view header, std::string_view key)
+    -> std::optional<std::string_view> {
+  auto begin = header.find(key);
+  if (begin == std::string_view::npos) return std::nullopt;
+
+  begin = header.find_first_not_of(' ', begin + key.size());
+  if (begin == std::string_view::npos) return std::nullopt;
+
+  const auto end = (header[begin] == '(') ? header.find(')', begin) + 1
+                                          : header.find(',', begin);
+  if ((end == std::string_view::npos) || (end < begin)) return std::nullopt;
+
+  return header.substr(begin, end - begin);
+}
+
+/// Parse a .npy shape tuple (e.g. "(3, 4)", "(12,)" or "()")
+auto ParseNpyShape(std::string_view tuple)
+    -> std::optional<std::vector<std::size_t>> {
+  if ((tuple.size() < 2) || (tuple.front() != '(') || (tuple.back() != ')')) {
+    return std::nullopt;
+  }
+
+  auto shape = std::vector<std::size_t>{};
+  auto dim = std::optional<std::size_t>{};
+  for (auto c : tuple.substr(1)) {
+    if ((c >= '0') && (c <= '9')) {
+      dim = (dim.value_or(0) * 10) + static_cast<std::size_t>(c - '0');
+    } else if ((c == ',') || (c == ')')) {
+      if (dim.has_value()) shape.push_back(*dim);
+      dim.reset();
+    } else if (c != ' ') {
+      return std::nullopt;
+    }
+  }
+  return shape;
+}
+
+/**
+ *  \brief Validate the .npy header of the \a size bytes of \a bytes
+ *
+ *  \return The offset (in bytes) of the values, std::nullopt on failure
+ */
+auto ParseNpyHeader(const std::uint8_t *bytes, std::size_t size,
+                    ArrayFile &array, std::string &reason)
+    -> std::optional<std::size_t> {
+  if ((size < 10) || (std::memcmp(bytes, kNpyMagic.data(), 6) != 0)) {
+    reason = "not a .npy file (bad magic string)";
+    return std::nullopt;
+  }
+
+  // Version 1.0 has a 2 bytes header length, 2.0 and 3.0 a 4 bytes one
+  const auto major = bytes[6];
+  auto header_begin = std::size_t{0};
+  auto header_size = std::size_t{0};
+  if (major == 1) {
+    header_begin = 10;
+    header_size = bytes[8] | (std::size_t{bytes[9]} << 8);
+  } else if (((major == 2) || (major == 3)) && (size >= 12)) {
+    header_begin = 12;
+    header_size = bytes[8] | (std::size_t{bytes[9]} << 8) |
+                  (std::size_t{bytes[10]} << 16) |
+                  (std::size_t{bytes[11]} << 24);
+  } else {
+    reason = "unsupported .npy version " +
+             std::to_string(unsigned{major});
+    return std::nullopt;
+  }
+
+  if (header_size > (size - header_begin)) {
+    reason = "truncated .npy header";
+    return std::nullopt;
+  }
+
+  const auto header = std::string_view{
+      reinterpret_cast<const char *>(bytes + header_begin), header_size};
+
+  const auto descr = NpyHeaderValue(header, "'descr':");
+  if (!descr.has_value() || (*descr != "'<f8'")) {
+    reason = "the .npy values must be little endian float64 ('<f8')";
+    return std::nullopt;
+  }
+
+  const auto fortran_order = NpyHeaderValue(header, "'fortran_order':");
+  const auto shape = NpyHeaderValue(header, "'shape':");
+  auto dims = shape.has_value() ? ParseNpyShape(*shape) : std::nullopt;
+  if (!fortran_order.has_value() || !dims.has_value() ||
+      ((*fortran_order != "True") && (*fortran_order != "False"))) {
+    reason = "malformed .npy header";
+    return std::nullopt;
+  }
+
+  array.fortran_order = (*fortran_order == "True");
+  array.shape = std::move(*dims);
+  return header_begin + header_size;
+}
+
+} // namespace
+
+auto MapArrayFile(const std::string &path, std::string &reason)
+    -> std::optional<ArrayFile> {
+  const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    reason = "can't open '" + path + "' (" + std::strerror(errno) + ")";
+    return std::nullopt;
+  }
+
+  struct stat info = {};
+  if (::fstat(fd, &info) != 0) {
+    reason = "can't stat '" + path + "' (" + std::strerror(errno) + ")";
+    ::close(fd);
+    return std::nullopt;
+  }
+
+  const auto size = static_cast<std::size_t>(info.st_size);
+  void *const base =
+      (size > 0) ? ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)
+                 : nullptr;
+  const auto mmap_error = errno;
+  ::close(fd); // The mapping stays valid
+
+  if (base == MAP_FAILED) {
+    reason = "can't mmap '" + path + "' (" + std::strerror(mmap_error) + ")";
+    return std::nullopt;
+  }
+
+  auto array = ArrayFile{};
+  array.mapping = std::shared_ptr<const void>(
+      base, [size](const void *ptr) {
+        if (ptr != nullptr) ::munmap(const_cast<void *>(ptr), size);
+      });
+
+  const auto *const bytes = static_cast<const std::uint8_t *>(base);
+  auto values_begin = std::size_t{0};
+
+  const auto is_npy = (path.size() >= 4) &&
+                      (path.compare(path.size() - 4, 4, ".npy") == 0);
+  if (is_npy) {
+    const auto offset = ParseNpyHeader(bytes, size, array, reason);
+    if (!offset.has_value()) return std::nullopt;
+    values_begin = *offset;
+  }
+
+  // Values are read in place: they must be aligned (.npy headers are padded)
+  if (((size - values_begin) % sizeof(double)) != 0 ||
+      ((values_begin % alignof(double)) != 0)) {
+    reason = "'" + path + "' doesn't hold a whole number of aligned float64";
+    return std::nullopt;
+  }
+
+  array.data = reinterpret_cast<const double *>(bytes + values_begin);
+  array.size = (size - values_begin) / sizeof(double);
+
+  if (!is_npy) {
+    array.shape = {array.size};
+  } else {
+    auto expected = std::size_t{1};
+    for (auto dim : array.shape) expected *= dim;
+
+    if (expected != array.size) {
+      reason = "'" + path + "' values don't match its .npy shape";
+      return std::nullopt;
+    }
+  }
+
+  // Values are expected to be read sequentially, from start to end
+  if (size > 0) ::madvise(base, size, MADV_SEQUENTIAL);
+
+  return array;
+}
+
+} // namespace lfc
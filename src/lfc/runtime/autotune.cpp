@@ -0,0 +1,157 @@
+#include "lfc/runtime/autotune.hpp"
+
+// System
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string_view>
+
+namespace lfc {
+
+namespace {
+
+/// Field separator of the cache file lines: ROWSxCOLS, CPU model, kernel
+constexpr char kSeparator = '\t';
+
+/// \return The mean time of solving the model with \a gains, for \a budget
+auto NsPerSolve(const Gains &gains, const offset_t &offset,
+                std::chrono::nanoseconds budget) -> double {
+  using clock = std::chrono::steady_clock;
+
+  const Eigen::VectorXd x = Eigen::VectorXd::Ones(gains.Cols());
+  auto y = Eigen::VectorXd(offset.size());
+
+  // Warm up the caches
+  gains.SolveInto(offset, x, y);
+
+  const auto start = clock::now();
+  auto solves = std::int64_t{0};
+  auto elapsed = clock::duration::zero();
+  do {
+    gains.SolveInto(offset, x, y);
+    ++solves;
+    elapsed = clock::now() - start;
+  } while (elapsed < budget);
+
+  return static_cast<double>(
+             std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                 .count()) /
+         static_cast<double>(solves);
+}
+
+} // namespace
+
+auto TimeGainsKernels(const gains_t &gains, const offset_t &offset,
+                      std::chrono::nanoseconds budget)
+    -> std::vector<KernelTiming> {
+  auto kernels = std::vector<GainsKernel>{};
+  for (auto kernel : kAllGainsKernels) {
+    if (Gains::IsApplicable(kernel, gains)) kernels.push_back(kernel);
+  }
+
+  const auto per_kernel =
+      budget / static_cast<std::int64_t>(std::max<std::size_t>(
+                   kernels.size(), 1));
+
+  auto timings = std::vector<KernelTiming>{};
+  for (auto kernel : kernels) {
+    timings.push_back(KernelTiming{
+        kernel, NsPerSolve(Gains{gains, kernel}, offset, per_kernel)});
+  }
+
+  std::stable_sort(timings.begin(), timings.end(),
+                   [](const auto &lhs, const auto &rhs) {
+                     return lhs.ns_per_solve < rhs.ns_per_solve;
+                   });
+  return timings;
+}
+
+auto CpuModelName() -> std::string {
+  constexpr std::string_view kModelName = "model name";
+
+  auto cpuinfo = std::ifstream{"/proc/cpuinfo"};
+  auto line = std::string{};
+  while (std::getline(cpuinfo, line)) {
+    if (line.compare(0, kModelName.size(), kModelName) != 0) continue;
+
+    const auto colon = line.find(':');
+    const auto begin = line.find_first_not_of(' ', colon + 1);
+    if ((colon == std::string::npos) || (begin == std::string::npos)) break;
+    return line.substr(begin);
+  }
+
+  return "unknown";
+}
+
+auto AutotuneKey(Eigen::Index rows, Eigen::Index cols) -> std::string {
+  auto cpu = CpuModelName();
+  std::replace(cpu.begin(), cpu.end(), kSeparator, ' ');
+  return std::to_string(rows) + "x" + std::to_string(cols) + kSeparator + cpu;
+}
+
+auto ReadCachedKernel(const std::string &path, const std::string &key)
+    -> std::optional<GainsKernel> {
+  auto file = std::ifstream{path};
+  auto line = std::string{};
+  while (std::getline(file, line)) {
+    const auto last = line.rfind(kSeparator);
+    if ((last != key.size()) || (line.compare(0, key.size(), key) != 0)) {
+      continue;
+    }
+    return GainsKernelFrom(std::string_view{line}.substr(last + 1));
+  }
+
+  return std::nullopt;
+}
+
+auto WriteCachedKernel(const std::string &path, const std::string &key,
+                       GainsKernel kernel) -> bool {
+  // Keep all the other entries
+  auto lines = std::vector<std::string>{};
+  {
+    auto file = std::ifstream{path};
+    auto line = std::string{};
+    while (std::getline(file, line)) {
+      const auto is_key = (line.rfind(kSeparator) == key.size()) &&
+                          (line.compare(0, key.size(), key) == 0);
+      if (!line.empty() && !is_key) lines.push_back(std::move(line));
+    }
+  }
+  lines.push_back(key + kSeparator + std::string{ToString(kernel)});
+
+  // Written aside, then renamed, such that readers never see a partial file
+  const auto tmp_path = path + ".tmp";
+  {
+    auto file = std::ofstream{tmp_path, std::ios::trunc};
+    for (const auto &line : lines) file << line << '\n';
+    if (!file.flush()) return false;
+  }
+
+  return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+auto AutotuneKernel(const gains_t &gains, const offset_t &offset,
+                    std::chrono::nanoseconds budget, const std::string &cache)
+    -> Autotuning {
+  auto tuning = Autotuning{};
+
+  const auto key = AutotuneKey(gains.rows(), gains.cols());
+  if (!cache.empty()) {
+    const auto cached = ReadCachedKernel(cache, key);
+    if (cached.has_value() && Gains::IsApplicable(*cached, gains)) {
+      tuning.kernel = *cached;
+      tuning.cached = true;
+      return tuning;
+    }
+  }
+
+  // Column major is always applicable
+  tuning.timings = TimeGainsKernels(gains, offset, budget);
+  tuning.kernel = tuning.timings.front().kernel;
+  tuning.cache_failed =
+      !cache.empty() && !WriteCachedKernel(cache, key, tuning.kernel);
+  return tuning;
+}
+
+} // namespace lfc
@@ -0,0 +1,232 @@
+#include "lfc/runtime/config.hpp"
+
+// System
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace lfc {
+
+namespace {
+
+/// \return \a text without its leading/trailing blanks
+auto Trim(std::string_view text) -> std::string_view {
+  const auto begin = text.find_first_not_of(" \t\r");
+  if (begin == std::string_view::npos) return {};
+  const auto end = text.find_last_not_of(" \t\r");
+  return text.substr(begin, end - begin + 1);
+}
+
+/// \return \a line without its comment ('#' outside of quotes)
+auto StripComment(std::string_view line) -> std::string_view {
+  char quote = '\0';
+  for (std::size_t i = 0; i < line.size(); ++i) {
+    const auto c = line[i];
+    if (quote != '\0') {
+      if (c == quote) quote = '\0';
+    } else if ((c == '\'') || (c == '"')) {
+      quote = c;
+    } else if (c == '#') {
+      return line.substr(0, i);
+    }
+  }
+  return line;
+}
+
+auto ParseString(std::string_view value, std::string &out) -> bool {
+  if ((value.size() >= 2) && ((value.front() == '\'') ||
+                              (value.front() == '"'))) {
+    if (value.back() != value.front()) return false;
+    value = value.substr(1, value.size() - 2);
+  }
+  out = value;
+  return true;
+}
+
+auto ParseBool(std::string_view value, bool &out) -> bool {
+  if ((value != "true") && (value != "false")) return false;
+  out = (value == "true");
+  return true;
+}
+
+auto ParseInt(std::string_view value, std::int64_t &out) -> bool {
+  const auto text = std::string{value};
+  char *end = nullptr;
+  errno = 0;
+  const auto parsed = std::strtoll(text.c_str(), &end, 10);
+  if (text.empty() || (errno != 0) || (*end != '\0')) return false;
+  out = parsed;
+  return true;
+}
+
+auto ParseDouble(std::string_view value, double &out) -> bool {
+  const auto text = std::string{value};
+  char *end = nullptr;
+  errno = 0;
+  const auto parsed = std::strtod(text.c_str(), &end);
+  if (text.empty() || (errno != 0) || (*end != '\0')) return false;
+  out = parsed;
+  return true;
+}
+
+auto ParseDoubles(std::string_view value, std::vector<double> &out) -> bool {
+  if ((value.size() < 2) || (value.front() != '[') || (value.back() != ']')) {
+    return false;
+  }
+
+  out.clear();
+  value = Trim(value.substr(1, value.size() - 2));
+  while (!value.empty()) {
+    const auto comma = value.find(',');
+    auto number = 0.;
+    if (!ParseDouble(Trim(value.substr(0, comma)), number)) return false;
+    out.push_back(number);
+
+    if (comma == std::string_view::npos) break;
+    value = Trim(value.substr(comma + 1));
+    if (value.empty()) return false; // Trailing ','
+  }
+  return true;
+}
+
+/// Set the \a key of \a config to \a value
+/// \return False when \a key is unknown or \a value is invalid
+auto Set(RuntimeConfig &config, std::string_view key, std::string_view value)
+    -> bool {
+  if (key == "gains/shape/rows") return ParseInt(value, config.gains_rows);
+  if (key == "gains/shape/cols") return ParseInt(value, config.gains_cols);
+  if (key == "gains/file") return ParseString(value, config.gains_file);
+  if (key == "gains/values") return ParseDoubles(value, config.gains_values);
+  if (key == "gains/storage_order") {
+    return ParseString(value, config.gains_storage_order);
+  }
+  if (key == "offset/file") return ParseString(value, config.offset_file);
+  if (key == "offset/values") {
+    return ParseDoubles(value, config.offset_values);
+  }
+  if (key == "shard/rows_begin") {
+    return ParseInt(value, config.shard_rows_begin);
+  }
+  if (key == "shard/rows_end") return ParseInt(value, config.shard_rows_end);
+  if (key == "trajectory/file") {
+    return ParseString(value, config.trajectory_file);
+  }
+  if (key == "trajectory/values") {
+    return ParseDoubles(value, config.trajectory_values);
+  }
+  if (key == "trajectory/start") {
+    return ParseDouble(value, config.trajectory_start);
+  }
+  if (key == "trajectory/period") {
+    return ParseDouble(value, config.trajectory_period);
+  }
+  if (key == "trajectory/interpolation") {
+    return ParseString(value, config.trajectory_interpolation);
+  }
+  if (key == "batch/streams") return ParseInt(value, config.batch_streams);
+  if (key == "batch/offsets") {
+    return ParseDoubles(value, config.batch_offsets);
+  }
+  if (key == "command/on_change/enabled") {
+    return ParseBool(value, config.on_change);
+  }
+  if (key == "command/on_change/epsilon") {
+    return ParseDouble(value, config.on_change_epsilon);
+  }
+  if (key == "command/on_change/keep_alive") {
+    return ParseDouble(value, config.on_change_keep_alive);
+  }
+  if (key == "model/kernel") return ParseString(value, config.kernel);
+  if (key == "model/autotune/budget_ms") {
+    return ParseInt(value, config.autotune_budget_ms);
+  }
+  if (key == "model/autotune/cache") {
+    return ParseString(value, config.autotune_cache);
+  }
+  if (key == "diagnostics/deadline") {
+    return ParseDouble(value, config.deadline);
+  }
+  if (key == "diagnostics/shm") return ParseString(value, config.shm);
+  if (key == "diagnostics/perf") return ParseBool(value, config.perf);
+  if (key == "flight_recorder/records") {
+    return ParseInt(value, config.flight_records);
+  }
+  if (key == "flight_recorder/path") {
+    return ParseString(value, config.flight_path);
+  }
+  if (key == "flight_recorder/dump_on_fault") {
+    return ParseBool(value, config.flight_dump_on_fault);
+  }
+  return false;
+}
+
+} // namespace
+
+auto ParseRuntimeConfig(std::string_view text, RuntimeConfig &config,
+                        std::string &reason) -> bool {
+  auto number = std::size_t{0};
+  auto lines = std::istringstream{std::string{text}};
+  auto line = std::string{};
+  while (std::getline(lines, line)) {
+    ++number;
+    const auto content = Trim(StripComment(line));
+    if (content.empty()) continue;
+
+    const auto colon = content.find(':');
+    if (colon == std::string_view::npos) {
+      reason = "line " + std::to_string(number) + ": expecting 'key: value'";
+      return false;
+    }
+
+    // Copied: the next lines of a list are read into the same buffer
+    const auto key = std::string{Trim(content.substr(0, colon))};
+    auto value = std::string{Trim(content.substr(colon + 1))};
+
+    // Lists may span several lines, up to their closing ']'
+    const auto first = number;
+    while (!value.empty() && (value.front() == '[') &&
+           (value.back() != ']') && std::getline(lines, line)) {
+      ++number;
+      value += ' ';
+      value += Trim(StripComment(line));
+    }
+
+    if (!Set(config, key, value)) {
+      reason = "line " + std::to_string(first) + ": unknown key, or invalid "
+               "value, '" + key + ": " + value + "'";
+      return false;
+    }
+  }
+
+  return true;
+}
+
+auto FlightPathOf(const RuntimeConfig &config) -> std::string {
+  if (!config.flight_path.empty()) return config.flight_path;
+  return "/tmp/lfc-flight-" + std::to_string(::getpid()) + ".bin";
+}
+
+auto LoadRuntimeConfig(const std::string &path, std::string &reason)
+    -> std::optional<RuntimeConfig> {
+  auto file = std::ifstream{path};
+  if (!file) {
+    reason = "can't open '" + path + "' (" + std::strerror(errno) + ")";
+    return std::nullopt;
+  }
+
+  auto text = std::stringstream{};
+  text << file.rdbuf();
+
+  auto config = RuntimeConfig{};
+  if (!ParseRuntimeConfig(text.str(), config, reason)) {
+    reason = "'" + path + "': " + reason;
+    return std::nullopt;
+  }
+  return config;
+}
+
+} // namespace lfc
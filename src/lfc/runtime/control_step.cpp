@@ -0,0 +1,362 @@
+#include "lfc/runtime/control_step.hpp"
+
+// System
+#include <chrono>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// INTERNAL
+#include "lfc/runtime/array_file.hpp"
+#include "lfc/runtime/autotune.hpp"
+#include "lfc/stats_page.hpp"
+
+namespace lfc {
+
+namespace {
+
+using row_major_t =
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+/// \return The gains described by \a config ('gains/*'), std::nullopt (with
+///         \a reason) when invalid
+auto LoadGains(const RuntimeConfig &config, std::string &reason)
+    -> std::optional<gains_t> {
+  // Checked even without values, as it also applies to the runtime updates
+  const auto &order = config.gains_storage_order;
+  if ((order != "row_major") && (order != "column_major")) {
+    reason = "Unknown 'gains/storage_order' value '" + order + "'";
+    return std::nullopt;
+  }
+
+  auto rows = config.gains_rows;
+  auto cols = config.gains_cols;
+
+  if (!config.gains_file.empty()) {
+    const auto file = MapArrayFile(config.gains_file, reason);
+    if (!file.has_value()) return std::nullopt;
+
+    // The .npy shape is used when not explicitly set
+    if ((file->shape.size() == 2) && (rows < 0) && (cols < 0)) {
+      rows = static_cast<std::int64_t>(file->shape[0]);
+      cols = static_cast<std::int64_t>(file->shape[1]);
+    }
+
+    if ((rows < 0) || (cols < 0) ||
+        (file->size != static_cast<std::size_t>(rows * cols)) ||
+        ((file->shape.size() == 2) &&
+         ((file->shape[0] != static_cast<std::size_t>(rows)) ||
+          (file->shape[1] != static_cast<std::size_t>(cols))))) {
+      reason = "'gains/file' values don't match the shape";
+      return std::nullopt;
+    }
+
+    if (file->fortran_order) {
+      return gains_t{Eigen::Map<const gains_t>(file->data, rows, cols)};
+    }
+    return gains_t{Eigen::Map<const row_major_t>(file->data, rows, cols)};
+  }
+
+  if ((rows < 0) || (cols < 0)) {
+    reason = "'gains/shape/rows|cols' must be >= 0";
+    return std::nullopt;
+  }
+
+  const auto &values = config.gains_values;
+  if (values.empty()) return gains_t{gains_t::Zero(rows, cols)};
+  if (values.size() != static_cast<std::size_t>(rows * cols)) {
+    reason = "'gains/values' must contain exactly ROWS*COLS values";
+    return std::nullopt;
+  }
+
+  if (order == "row_major") {
+    return gains_t{Eigen::Map<const row_major_t>(values.data(), rows, cols)};
+  }
+  return gains_t{Eigen::Map<const gains_t>(values.data(), rows, cols)};
+}
+
+/// \return The offset described by \a config ('offset/*') of \a size values,
+///         std::nullopt (with \a reason) when invalid
+auto LoadOffset(const RuntimeConfig &config, Eigen::Index size,
+                std::string &reason) -> std::optional<offset_t> {
+  if (!config.offset_file.empty()) {
+    const auto file = MapArrayFile(config.offset_file, reason);
+    if (!file.has_value()) return std::nullopt;
+
+    if ((file->shape.size() > 1) ||
+        (file->size != static_cast<std::size_t>(size))) {
+      reason = "'offset/file' values don't match the gains rows";
+      return std::nullopt;
+    }
+    return offset_t{Eigen::Map<const offset_t>(file->data, size)};
+  }
+
+  const auto &values = config.offset_values;
+  if (values.empty()) return offset_t{offset_t::Zero(size)};
+  if (values.size() != static_cast<std::size_t>(size)) {
+    reason = "'offset/values' must contain exactly ROWS values";
+    return std::nullopt;
+  }
+  return offset_t{Eigen::Map<const offset_t>(values.data(), size)};
+}
+
+/// \return The trajectory described by \a config ('trajectory/*', set) of
+///         \a rows x \a cols models, std::nullopt (with \a reason) when
+///         invalid
+auto LoadTrajectory(const RuntimeConfig &config, std::size_t rows,
+                    std::size_t cols, std::string &reason)
+    -> std::optional<LinearModelTrajectory<double>> {
+  // Validated by LoadGains()
+  const auto row_major = (config.gains_storage_order == "row_major");
+  const auto period = config.trajectory_period;
+
+  auto trajectory = std::optional<LinearModelTrajectory<double>>{};
+  if (!config.trajectory_file.empty()) {
+    const auto file = MapArrayFile(config.trajectory_file, reason);
+    if (!file.has_value()) return std::nullopt;
+    if (file->fortran_order && (file->shape.size() > 1)) {
+      reason = "'trajectory/file' must not be a Fortran ordered array";
+      return std::nullopt;
+    }
+
+    // The models of a file are used in place, from the mapping, when their
+    // gains are column major (as solved). Otherwise, they are reordered once
+    if (!row_major) {
+      trajectory = MakeLinearModelTrajectory(rows, cols, 0., period,
+                                             file->data, file->size,
+                                             file->mapping);
+    } else if (auto models = std::vector<double>(file->data,
+                                                 file->data + file->size);
+               RowMajorToColumnMajorModels(rows, cols, models)) {
+      trajectory =
+          MakeLinearModelTrajectory(rows, cols, 0., period, std::move(models));
+    }
+  } else {
+    auto models = config.trajectory_values;
+    if (!row_major || RowMajorToColumnMajorModels(rows, cols, models)) {
+      trajectory =
+          MakeLinearModelTrajectory(rows, cols, 0., period, std::move(models));
+    }
+  }
+
+  if (!trajectory.has_value() || (trajectory->Count() == 0)) {
+    reason = "'trajectory/values|file' must hold a whole number of models "
+             "(w.r.t. the gains shape), and 'trajectory/period' be > 0";
+    return std::nullopt;
+  }
+  return trajectory;
+}
+
+} // namespace
+
+auto ControlStep::Create(const RuntimeConfig &config, std::string &reason)
+    -> std::unique_ptr<ControlStep> {
+  // MODEL
+  auto gains = LoadGains(config, reason);
+  if (!gains.has_value()) return nullptr;
+
+  auto offset = LoadOffset(config, gains->rows(), reason);
+  if (!offset.has_value()) return nullptr;
+
+  // Shard of a row partitioned model: only its rows are ever solved
+  const auto sharded =
+      (config.shard_rows_begin != 0) || (config.shard_rows_end >= 0);
+  if (sharded) {
+    const auto begin = config.shard_rows_begin;
+    const auto end =
+        (config.shard_rows_end < 0) ? gains->rows() : config.shard_rows_end;
+    if ((begin < 0) || (begin >= end) || (end > gains->rows())) {
+      reason = "'shard/rows_begin|end' must be a non empty range of the "
+               "gains rows";
+      return nullptr;
+    }
+
+    *gains = gains_t{gains->middleRows(begin, end - begin)};
+    *offset = offset_t{offset->segment(begin, end - begin)};
+  }
+
+  auto step = std::make_unique<ControlStep>();
+  auto kernel = GainsKernelFrom(config.kernel);
+  if (config.kernel == "auto") {
+    if (config.autotune_budget_ms <= 0) {
+      reason = "'model/autotune/budget_ms' must be > 0";
+      return nullptr;
+    }
+    step->m_tuning = AutotuneKernel(*gains, *offset,
+                                    std::chrono::milliseconds{
+                                        config.autotune_budget_ms},
+                                    config.autotune_cache);
+    kernel = step->m_tuning->kernel;
+  } else if (!kernel.has_value() || !Gains::IsApplicable(*kernel, *gains)) {
+    reason = "Unknown (or not applicable to the gains shape) 'model/kernel' "
+             "value '" +
+             config.kernel + "'";
+    return nullptr;
+  }
+
+  step->Reset(*gains, *offset, *kernel);
+
+  // TRAJECTORY: its models replace the model
+  if (!config.trajectory_file.empty() || !config.trajectory_values.empty()) {
+    const auto &interpolation = config.trajectory_interpolation;
+    if ((interpolation != "hold") && (interpolation != "linear")) {
+      reason = "Unknown 'trajectory/interpolation' value '" + interpolation +
+               "'";
+      return nullptr;
+    }
+    if (sharded) {
+      reason = "'trajectory/*' can't be used alongside 'shard/*'";
+      return nullptr;
+    }
+
+    step->m_trajectory = LoadTrajectory(
+        config, static_cast<std::size_t>(gains->rows()),
+        static_cast<std::size_t>(gains->cols()), reason);
+    if (!step->m_trajectory.has_value()) return nullptr;
+
+    step->m_interpolation = (interpolation == "linear")
+                                ? TrajectoryInterpolation::kLinear
+                                : TrajectoryInterpolation::kHold;
+    step->m_trajectory_start = config.trajectory_start;
+    step->m_stats.SetKernel("trajectory");
+  }
+
+  // BATCH
+  const auto streams = config.batch_streams;
+  if ((streams < 0) || ((streams > 0) && step->m_trajectory.has_value())) {
+    reason = "'batch/*' streams must be >= 0, and can't be used alongside a "
+             "trajectory";
+    return nullptr;
+  }
+  if (!config.batch_offsets.empty() &&
+      (config.batch_offsets.size() !=
+       static_cast<std::size_t>(gains->rows() * streams))) {
+    reason = "'batch/offsets' must be empty, or contain exactly ROWS values "
+             "per stream";
+    return nullptr;
+  }
+
+  step->m_batch_state.setZero(gains->cols(), streams);
+  step->m_batch_command.setZero(gains->rows(), streams);
+  if (!config.batch_offsets.empty()) {
+    step->m_batch_offsets = Eigen::Map<const Eigen::MatrixXd>(
+        config.batch_offsets.data(), gains->rows(), streams);
+  }
+
+  // PUBLISH ON CHANGE
+  if ((config.on_change_epsilon < 0.) || (config.on_change_keep_alive < 0.)) {
+    reason = "'command/on_change/epsilon|keep_alive' must be >= 0";
+    return nullptr;
+  }
+  if (config.on_change && (sharded || (streams > 0))) {
+    reason = "'command/on_change/enabled' can't be used alongside 'shard/*' "
+             "(the partial commands must all be published), nor 'batch/*'";
+    return nullptr;
+  }
+
+  if (config.on_change) {
+    step->m_on_change.emplace(
+        static_cast<std::size_t>(gains->rows()), config.on_change_epsilon,
+        std::chrono::duration_cast<ChangeFilter::clock::duration>(
+            std::chrono::duration<double>{config.on_change_keep_alive}));
+  }
+
+  // STATS
+  if (config.deadline < 0.) {
+    reason = "'diagnostics/deadline' must be >= 0";
+    return nullptr;
+  }
+  step->m_stats.deadline = std::chrono::duration_cast<clock::duration>(
+      std::chrono::duration<double>{config.deadline});
+
+  if (!config.shm.empty()) {
+    auto page = CreateSharedStatsPage(config.shm, reason);
+    if (page == nullptr) return nullptr;
+    step->m_stats.Share(std::move(page));
+  }
+
+  if (config.perf) step->EnablePerf();
+
+  // FLIGHT RECORDER
+  if (config.flight_records < 0) {
+    reason = "'flight_recorder/records' must be >= 0";
+    return nullptr;
+  }
+
+  if (config.flight_records > 0) {
+    if (!step->EnableFlightRecorder(
+            static_cast<std::size_t>(config.flight_records), reason)) {
+      return nullptr;
+    }
+    const auto path = FlightPathOf(config);
+    if (config.flight_dump_on_fault && !DumpOnFault(*step->m_recorder, path)) {
+      reason = "can't dump the flight recorder on fault into '" + path + "'";
+      return nullptr;
+    }
+  }
+
+  return step;
+}
+
+auto ControlStep::Reset(const gains_t &gains, const offset_t &offset,
+                        GainsKernel kernel) -> void {
+  m_posted.gains = Gains{gains, GainsKernel::kColMajor};
+  m_posted.offset = offset;
+  m_model.ForEachSlot([&](Model &slot) {
+    slot.gains = Gains{gains, kernel};
+    slot.offset = offset;
+    slot.version = m_posted.version;
+  });
+  m_patches.clear();
+
+  m_state.setZero(gains.cols());
+  m_command.setZero(gains.rows());
+  m_blend.setZero(gains.rows());
+  m_batch_state.setZero(gains.cols(), m_batch_state.cols());
+  m_batch_command.setZero(gains.rows(), m_batch_command.cols());
+  m_kernel = kernel;
+  m_stats.SetKernel(ToString(kernel));
+}
+
+auto ControlStep::PostPatches(std::vector<ModelPatch> &pending,
+                              bool full_update) -> void {
+  if (pending.empty()) return;
+
+  auto &next = m_model.Back();
+  CatchUp(next);
+
+  for (auto &patch : pending) {
+    patch.ApplyTo(m_posted, m_posted);
+    patch.ApplyTo(next, m_posted);
+    patch.version = ++m_posted.version;
+    next.version = m_posted.version;
+
+    if (!full_update) m_patches.push_back(std::move(patch));
+  }
+
+  if (full_update) m_patches.clear();
+  while (m_patches.size() > kMaxPatches) m_patches.pop_front();
+
+  m_model.Post();
+  LFC_PROBE(model_post, m_posted.version);
+}
+
+auto ControlStep::CatchUp(Model &slot) const -> void {
+  if (slot.version == m_posted.version) return;
+
+  // Sparse gains are entirely copied by any patch: copy them once
+  if (!m_patches.empty() &&
+      (m_patches.front().version <= (slot.version + 1)) &&
+      (slot.gains.Kernel() != GainsKernel::kSparse)) {
+    for (const auto &patch : m_patches) {
+      if (patch.version > slot.version) patch.ApplyTo(slot, m_posted);
+    }
+  } else {
+    slot.gains.Assign(m_posted.gains);
+    slot.offset = m_posted.offset;
+  }
+
+  slot.version = m_posted.version;
+}
+
+} // namespace lfc
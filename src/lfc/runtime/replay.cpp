@@ -0,0 +1,66 @@
+#include "lfc/runtime/replay.hpp"
+
+// System
+#include <chrono>
+
+namespace lfc {
+
+auto KeepModelVersion(std::vector<FlightRecord> &records,
+                      std::uint64_t model_version) -> std::size_t {
+  const auto kept = std::remove_if(
+      records.begin(), records.end(), [&](const FlightRecord &record) {
+        return record.model_version != model_version;
+      });
+  const auto removed = static_cast<std::size_t>(records.end() - kept);
+  records.erase(kept, records.end());
+  return removed;
+}
+
+auto ReplayFlight(const std::vector<FlightRecord> &records, std::size_t begin,
+                  std::size_t end, const Gains &gains, const offset_t &offset,
+                  std::size_t repeat, double tolerance, ReplayStats &stats)
+    -> void {
+  using clock = std::chrono::steady_clock;
+  const auto elapsed = [](clock::time_point from, clock::time_point to) {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(to - from)
+            .count());
+  };
+
+  // Preallocated, as the node state X and command
+  auto x = Eigen::VectorXd{Eigen::VectorXd::Zero(gains.Cols())};
+  auto y = Eigen::VectorXd{Eigen::VectorXd::Zero(gains.Rows())};
+
+  for (std::size_t pass = 0; pass < repeat; ++pass) {
+    for (auto i = begin; i < end; ++i) {
+      const auto &record = records[i];
+
+      const auto load_begin = clock::now();
+      x = Eigen::Map<const Eigen::VectorXd>(record.x.data(), x.size());
+
+      const auto solve_begin = clock::now();
+      gains.SolveInto(offset, x, y);
+
+      const auto compare_begin = clock::now();
+      const auto diff =
+          y - Eigen::Map<const Eigen::VectorXd>(record.y.data(), y.size());
+      const auto max_diff = diff.cwiseAbs().maxCoeff();
+      const auto compare_end = clock::now();
+
+      stats.load.Record(elapsed(load_begin, solve_begin));
+      stats.solve.Record(elapsed(solve_begin, compare_begin));
+      stats.compare.Record(elapsed(compare_begin, compare_end));
+
+      // Once is enough, all passes being identical
+      if (pass > 0) continue;
+      stats.max_diff = std::max(stats.max_diff, max_diff);
+      stats.sum_squared_diff += diff.squaredNorm();
+      stats.values += static_cast<std::size_t>(y.size());
+      if (!(max_diff <= tolerance)) {
+        if (stats.mismatches++ == 0) stats.first_mismatch = record.sequence;
+      }
+    }
+  }
+}
+
+} // namespace lfc
@@ -0,0 +1,259 @@
+// SYSTEM
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// INTERNAL
+#include "lfc/flight_recorder.hpp"
+#include "lfc/lockfree/histogram.hpp"
+#include "lfc/runtime/array_file.hpp"
+#include "lfc/runtime/autotune.hpp"
+#include "lfc/runtime/gains.hpp"
+#include "lfc/runtime/replay.hpp"
+
+// EXT
+// -- Eigen
+#include "Eigen/Core"
+
+namespace lfc {
+namespace {
+
+using histogram_t = ReplayStats::histogram_t;
+using steady_clock = std::chrono::steady_clock;
+
+constexpr std::string_view kUsage =
+    "Usage: lfc-replay [OPTIONS] --gains <FILE> <DUMP>\n"
+    "\n"
+    "Replay the states X of a flight recorder dump (see lfc-flight-decode)\n"
+    "through the solve of an lfc node (gains kernel and offset), as fast as\n"
+    "possible, without ROS. The states X being recorded once gathered, the\n"
+    "gather itself isn't replayed. Reports the throughput, the timing of\n"
+    "each stage and the differences with the commands Y recorded.\n"
+    "\n"
+    "Only the records of the model version of the first one are replayed\n"
+    "(the others being solved by other gains).\n"
+    "\n"
+    "Gains/offset files are .npy (or raw little endian float64) files, as\n"
+    "the node 'gains/file' and 'offset/file' parameters.\n"
+    "\n"
+    "Options:\n"
+    "  --gains <FILE>     Gains replayed (required)\n"
+    "  --offset <FILE>    Offset replayed (default: zeros)\n"
+    "  --kernel <NAME>    Gains kernel, or 'auto' to time them (default)\n"
+    "  --jobs <N>         Threads replaying independent segments of the dump\n"
+    "                     (default: all the cores)\n"
+    "  --repeat <N>       Replay the dump N times (default: 1)\n"
+    "  --tolerance <EPS>  Highest |Y - Y recorded| tolerated (default: 1e-9)\n"
+    "\n"
+    "Exits with 2 when any command exceeds the tolerance.\n";
+
+struct Options {
+  std::string dump = {};
+  std::string gains = {};
+  std::string offset = {};
+  std::string kernel = "auto";
+  std::size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+  std::size_t repeat = 1;
+  double tolerance = 1e-9;
+};
+
+/// \return The options parsed from the command line, std::nullopt if invalid
+auto ParseOptions(int argc, char *argv[]) -> std::optional<Options> {
+  auto options = Options{};
+  try {
+    for (int i = 1; i < argc; ++i) {
+      const auto arg = std::string_view{argv[i]};
+      const auto has_value = ((i + 1) < argc);
+      if ((arg == "--gains") && has_value) {
+        options.gains = argv[++i];
+      } else if ((arg == "--offset") && has_value) {
+        options.offset = argv[++i];
+      } else if ((arg == "--kernel") && has_value) {
+        options.kernel = argv[++i];
+      } else if ((arg == "--jobs") && has_value) {
+        options.jobs = std::stoul(argv[++i]);
+      } else if ((arg == "--repeat") && has_value) {
+        options.repeat = std::stoul(argv[++i]);
+      } else if ((arg == "--tolerance") && has_value) {
+        options.tolerance = std::stod(argv[++i]);
+      } else if (options.dump.empty() && !arg.empty() && (arg[0] != '-')) {
+        options.dump = arg;
+      } else {
+        return std::nullopt;
+      }
+    }
+  } catch (const std::exception &) {
+    return std::nullopt;
+  }
+
+  if (options.dump.empty() || options.gains.empty() || (options.jobs == 0) ||
+      (options.repeat == 0) || (options.tolerance < 0.)) {
+    return std::nullopt;
+  }
+  return options;
+}
+
+/**
+ *  \brief Load the \a rows x \a cols matrix stored in the file \a path
+ *         (row major, unless the .npy file is in fortran order)
+ *
+ *  \return The matrix, std::nullopt (with \a reason) on failure
+ */
+auto LoadMatrix(const std::string &path, Eigen::Index rows, Eigen::Index cols,
+                std::string &reason) -> std::optional<Eigen::MatrixXd> {
+  const auto file = MapArrayFile(path, reason);
+  if (!file.has_value()) return std::nullopt;
+
+  if (file->size != static_cast<std::size_t>(rows * cols)) {
+    reason = "'" + path + "' holds " + std::to_string(file->size) +
+             " values, expecting " + std::to_string(rows) + "x" +
+             std::to_string(cols) + " (w.r.t. the dump)";
+    return std::nullopt;
+  }
+
+  using row_major_t = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic,
+                                    Eigen::RowMajor>;
+  if (file->fortran_order) {
+    return Eigen::MatrixXd{Eigen::Map<const Eigen::MatrixXd>(file->data, rows,
+                                                             cols)};
+  }
+  return Eigen::MatrixXd{Eigen::Map<const row_major_t>(file->data, rows,
+                                                       cols)};
+}
+
+/// Replay of a segment of the dump, by a single thread
+struct Segment {
+  std::size_t begin = 0; /*!< First record replayed */
+  std::size_t end = 0;   /*!< Past the last record replayed */
+  ReplayStats stats = {};
+};
+
+/// Print the count, mean, percentiles and max (ns) of \a histogram
+auto PrintHistogram(std::string_view name, const histogram_t &histogram)
+    -> void {
+  std::printf("%-10.*s %12lu %10.1f %10lu %10lu %10lu %10lu %10lu\n",
+              static_cast<int>(name.size()), name.data(), histogram.Count(),
+              histogram.Mean(), histogram.ValueAtPercentile(50.),
+              histogram.ValueAtPercentile(90.),
+              histogram.ValueAtPercentile(99.),
+              histogram.ValueAtPercentile(99.9), histogram.Max());
+}
+
+/**
+ *  \brief Replay the dump, as set by the \a options, and report it
+ *
+ *  \return The exit code: 0 on success, 1 on failure, 2 on mismatches
+ */
+auto Run(const Options &options) -> int {
+  const auto fail = [](const std::string &reason) {
+    std::fprintf(stderr, "lfc-replay: %s\n", reason.c_str());
+    return 1;
+  };
+
+  // INPUTS
+  auto reason = std::string{};
+  auto header = FlightDumpHeader{};
+  auto records = LoadFlightDump(options.dump, header, reason);
+  if (!records.has_value()) return fail(reason);
+  if (records->empty()) return fail("'" + options.dump + "' is empty");
+  const auto model_version = records->front().model_version;
+  const auto skipped = KeepModelVersion(*records, model_version);
+
+  const auto rows = static_cast<Eigen::Index>(header.y_size);
+  const auto cols = static_cast<Eigen::Index>(header.x_size);
+  const auto gains = LoadMatrix(options.gains, rows, cols, reason);
+  if (!gains.has_value()) return fail(reason);
+
+  auto offset = offset_t{offset_t::Zero(rows)};
+  if (!options.offset.empty()) {
+    const auto loaded = LoadMatrix(options.offset, rows, 1, reason);
+    if (!loaded.has_value()) return fail(reason);
+    offset = *loaded;
+  }
+
+  // KERNEL
+  auto kernel = GainsKernelFrom(options.kernel);
+  if (options.kernel == "auto") {
+    kernel = TimeGainsKernels(*gains, offset, std::chrono::milliseconds{100})
+                 .front()
+                 .kernel;
+  } else if (!kernel.has_value() || !Gains::IsApplicable(*kernel, *gains)) {
+    return fail("unknown (or not applicable to the gains shape) kernel '" +
+                options.kernel + "'");
+  }
+
+  // REPLAY
+  // Each thread replays its own segment, with its own copy of the model
+  const auto jobs = std::min(options.jobs, records->size());
+  auto segments = std::vector<std::unique_ptr<Segment>>{};
+  for (std::size_t job = 0; job < jobs; ++job) {
+    auto &segment = segments.emplace_back(std::make_unique<Segment>());
+    segment->begin = (records->size() * job) / jobs;
+    segment->end = (records->size() * (job + 1)) / jobs;
+  }
+
+  const auto start = steady_clock::now();
+  auto threads = std::vector<std::thread>{};
+  for (auto &segment : segments) {
+    threads.emplace_back([&, kernel = *kernel]() {
+      const auto model = Gains{*gains, kernel};
+      ReplayFlight(*records, segment->begin, segment->end, model, offset,
+                   options.repeat, options.tolerance, segment->stats);
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  const auto wall = std::chrono::duration<double>(steady_clock::now() - start);
+
+  // REPORT
+  auto total = ReplayStats{};
+  for (const auto &segment : segments) total.Merge(segment->stats);
+
+  const auto solves = total.solve.Count();
+  std::printf("%s: %zu records (x: %lu, y: %lu) of model version %lu, "
+              "kernel: %s, %zu jobs, %zu passes\n",
+              options.dump.c_str(), records->size(), header.x_size,
+              header.y_size, model_version,
+              std::string{ToString(*kernel)}.c_str(), jobs, options.repeat);
+  if (skipped > 0) {
+    std::printf("skipped: %zu records of other model versions\n", skipped);
+  }
+  std::printf("throughput: %.0f solves/s (%lu solves in %.3fs)\n",
+              static_cast<double>(solves) / wall.count(), solves,
+              wall.count());
+
+  std::printf("\n%-10s %12s %10s %10s %10s %10s %10s %10s\n", "(ns)", "count",
+              "mean", "p50", "p90", "p99", "p99.9", "max");
+  PrintHistogram("load", total.load);
+  PrintHistogram("solve", total.solve);
+  PrintHistogram("compare", total.compare);
+
+  std::printf("\ny vs recorded: max |diff|: %g, rms: %g, above %g: %zu",
+              total.max_diff, total.RmsDiff(), options.tolerance,
+              total.mismatches);
+  if (total.mismatches > 0) {
+    std::printf(" (first: sequence %lu)", total.first_mismatch);
+  }
+  std::printf("\n");
+
+  return (total.mismatches > 0) ? 2 : 0;
+}
+
+} // namespace
+} // namespace lfc
+
+int main(int argc, char *argv[]) {
+  const auto options = lfc::ParseOptions(argc, argv);
+  if (!options.has_value()) {
+    std::fputs(lfc::kUsage.data(), stderr);
+    return 1;
+  }
+
+  return lfc::Run(*options);
+}
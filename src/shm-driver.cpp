@@ -0,0 +1,180 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "lfc/lockfree/histogram.hpp"
+#include "lfc/shm_transport.hpp"
+
+namespace {
+
+using steady_clock = std::chrono::steady_clock;
+using system_clock = std::chrono::system_clock;
+
+constexpr std::string_view kUsage =
+    "Usage: lfc-shm-driver [OPTIONS] <SHM NAME>\n"
+    "\n"
+    "Reference driver of the shared memory transport of an lfc node (see its\n"
+    "'control/loop: shm' and 'control/shm/name' parameters, e.g.\n"
+    "'/lfc-transport'): pushes synthetic states X, waits for their commands\n"
+    "Y, and reports the round trip latencies.\n"
+    "\n"
+    "Options:\n"
+    "  --rate <Hz>     States pushed per second, 0 for back to back round\n"
+    "                  trips (default: 1000)\n"
+    "  --count <N>     States pushed (default: 10000)\n"
+    "  --timeout <s>   Highest wait for a command (default: 1)\n";
+
+struct Options {
+  std::string name = {};
+  double rate = 1000.;
+  std::uint64_t count = 10000;
+  double timeout = 1.;
+};
+
+/// \return The options of \a argv, std::nullopt when invalid
+auto ParseOptions(int argc, char *argv[]) -> std::optional<Options> {
+  auto options = Options{};
+  try {
+    for (int i = 1; i < argc; ++i) {
+      const auto arg = std::string_view{argv[i]};
+      const auto has_value = (i + 1) < argc;
+
+      if ((arg == "--rate") && has_value) {
+        options.rate = std::stod(argv[++i]);
+      } else if ((arg == "--count") && has_value) {
+        options.count = std::stoull(argv[++i]);
+      } else if ((arg == "--timeout") && has_value) {
+        options.timeout = std::stod(argv[++i]);
+      } else if (options.name.empty() && !arg.empty() && (arg[0] != '-')) {
+        options.name = arg;
+      } else {
+        return std::nullopt;
+      }
+    }
+  } catch (const std::exception &) {
+    return std::nullopt;
+  }
+
+  if (options.name.empty() || (options.rate < 0.) ||
+      (options.timeout <= 0.)) {
+    return std::nullopt;
+  }
+  return options;
+}
+
+/**
+ *  \brief Drive the transport, as set by the \a options, and report it
+ *
+ *  \return The exit code: 0 on success, 1 on failure (e.g. a command timed
+ *          out)
+ */
+auto Run(const Options &options) -> int {
+  auto reason = std::string{};
+  auto transport = lfc::ShmTransport::Open(options.name, reason);
+  if (!transport.has_value()) {
+    std::fprintf(stderr, "lfc-shm-driver: %s\n", reason.c_str());
+    return 1;
+  }
+
+  std::printf("controller pid %ld | X: %zu values | Y: %zu values | %zu "
+              "slots\n",
+              transport->ControllerPid(), transport->XSize(),
+              transport->YSize(), transport->Capacity());
+
+  auto &states = transport->States();
+  auto &commands = transport->Commands();
+  const auto timeout = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::duration<double>{options.timeout});
+  const auto period =
+      (options.rate > 0.)
+          ? std::chrono::duration_cast<steady_clock::duration>(
+                std::chrono::duration<double>{1. / options.rate})
+          : steady_clock::duration::zero();
+
+  auto round_trip = lfc::lockfree::Histogram<>{};
+  auto next = steady_clock::now();
+  auto full = std::uint64_t{0}; /*!< States not pushed: ring full */
+
+  for (std::uint64_t sequence = 1; sequence <= options.count; ++sequence) {
+    if (period > steady_clock::duration::zero()) {
+      next += period;
+      std::this_thread::sleep_until(next);
+    }
+
+    // STATE: smooth synthetic values
+    auto *const state = states.TryClaim();
+    if (state == nullptr) {
+      ++full;
+      continue;
+    }
+
+    for (std::size_t i = 0; i < states.Values(); ++i) {
+      state->Values()[i] =
+          std::sin((1e-3 * static_cast<double>(sequence)) +
+                   static_cast<double>(i));
+    }
+    state->sequence = sequence;
+    state->stamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          system_clock::now().time_since_epoch())
+                          .count();
+    const auto pushed = steady_clock::now();
+    states.Commit();
+
+    // COMMAND: the one of this state (older ones, if any, are late)
+    for (;;) {
+      const auto *const command = commands.Wait(timeout);
+      if (command != nullptr) {
+        const auto solved = command->sequence;
+        commands.Release();
+        if (solved == sequence) break;
+      }
+
+      // Spurious wakeup, or late command: until the timeout
+      if ((steady_clock::now() - pushed) >= timeout) {
+        std::fprintf(stderr,
+                     "lfc-shm-driver: no command for the state %lu within "
+                     "%gs\n",
+                     sequence, options.timeout);
+        return 1;
+      }
+    }
+
+    round_trip.Record(static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            steady_clock::now() - pushed)
+            .count()));
+  }
+
+  std::printf("states: %lu | not pushed (ring full): %lu\n\n",
+              options.count, full);
+  std::printf("%-18s %12s %10s %10s %10s %10s %10s %10s\n", "(us)", "count",
+              "mean", "p50", "p90", "p99", "p99.9", "max");
+  const auto us = [](std::uint64_t ns) {
+    return static_cast<double>(ns) / 1e3;
+  };
+  std::printf("%-18s %12lu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+              "round trip", round_trip.Count(), round_trip.Mean() / 1e3,
+              us(round_trip.ValueAtPercentile(50.)),
+              us(round_trip.ValueAtPercentile(90.)),
+              us(round_trip.ValueAtPercentile(99.)),
+              us(round_trip.ValueAtPercentile(99.9)), us(round_trip.Max()));
+
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  const auto options = ParseOptions(argc, argv);
+  if (!options.has_value()) {
+    std::fputs(kUsage.data(), stderr);
+    return 1;
+  }
+
+  return Run(*options);
+}
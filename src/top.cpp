@@ -0,0 +1,152 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "lfc/stats_page.hpp"
+
+namespace {
+
+constexpr std::string_view kUsage =
+    "Usage: lfc-top [OPTIONS] <SHM NAME>\n"
+    "\n"
+    "Display, live, the control path stats shared by an lfc node (see its\n"
+    "'diagnostics/shm' parameter, e.g. '/lfc').\n"
+    "\n"
+    "Options:\n"
+    "  --period <s>   Refresh period (default: 1)\n"
+    "  --once         Print the stats once, then exit\n";
+
+/// Print the header of the histograms table, whose values are in \a unit
+auto PrintHistogramHeader(const char *unit) -> void {
+  std::printf("\n%-18s %12s %10s %10s %10s %10s %10s %10s\n", unit, "count",
+              "mean", "p50", "p90", "p99", "p99.9", "max");
+}
+
+/// Print the count, mean, percentiles and max of \a histogram, divided by
+/// \a scale
+auto PrintHistogram(std::string_view name,
+                    const lfc::StatsPage::histogram_t &histogram,
+                    double scale) -> void {
+  const auto scaled = [scale](std::uint64_t value) {
+    return static_cast<double>(value) / scale;
+  };
+  std::printf("%-18.*s %12lu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+              static_cast<int>(name.size()), name.data(), histogram.Count(),
+              histogram.Mean() / scale,
+              scaled(histogram.ValueAtPercentile(50.)),
+              scaled(histogram.ValueAtPercentile(90.)),
+              scaled(histogram.ValueAtPercentile(99.)),
+              scaled(histogram.ValueAtPercentile(99.9)),
+              scaled(histogram.Max()));
+}
+
+/**
+ *  \brief Print the stats of \a page, given the \a previous counters (used
+ *         to compute the rate over \a elapsed seconds)
+ */
+auto Print(const lfc::StatsPage &page, const lfc::StatsCounters &counters,
+           const lfc::StatsCounters &previous, double elapsed) -> void {
+  const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                       .count();
+  const auto rate =
+      (elapsed > 0.)
+          ? static_cast<double>(counters.ticks - previous.ticks) / elapsed
+          : 0.;
+
+  std::printf("pid %ld | kernel: %s | model version: %lu\n", page.pid,
+              counters.kernel.data(), counters.model_version);
+  std::printf("ticks: %lu (%.1f/s) | deadline misses: %lu | dropped: %lu",
+              counters.ticks, rate, counters.deadline_misses,
+              page.dropped.load(std::memory_order_relaxed));
+  if (counters.ticks > 0) {
+    std::printf(" | last tick: %.3fs ago",
+                static_cast<double>(now - counters.last_tick_ns) / 1e9);
+  }
+  std::printf("\n");
+
+  PrintHistogramHeader("(us)");
+  PrintHistogram("receive to solve", page.receive_to_solve, 1e3);
+  PrintHistogram("solve", page.solve, 1e3);
+  PrintHistogram("solve to publish", page.solve_to_publish, 1e3);
+  PrintHistogram("end to end", page.end_to_end, 1e3);
+
+  // Only when measured (see the 'diagnostics/perf' parameter)
+  if (page.perf[0].Count() > 0) {
+    PrintHistogramHeader("(per solve)");
+    for (std::size_t i = 0; i < lfc::kPerfEventCount; ++i) {
+      PrintHistogram(lfc::ToString(lfc::PerfEvent{i}), page.perf[i], 1.);
+    }
+  }
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  auto name = std::string{};
+  auto period = 1.;
+  auto once = false;
+
+  for (int i = 1; i < argc; ++i) {
+    const auto arg = std::string_view{argv[i]};
+    if (arg == "--once") {
+      once = true;
+    } else if ((arg == "--period") && ((i + 1) < argc)) {
+      try {
+        period = std::stod(argv[++i]);
+      } catch (const std::exception &) {
+        period = 0.;
+      }
+    } else if (name.empty() && !arg.empty() && (arg[0] != '-')) {
+      name = arg;
+    } else {
+      name.clear();
+      break;
+    }
+  }
+
+  if (name.empty() || (period <= 0.)) {
+    std::fputs(kUsage.data(), stderr);
+    return 1;
+  }
+
+  auto reason = std::string{};
+  const auto page = lfc::OpenSharedStatsPage(name, reason);
+  if (page == nullptr) {
+    std::fprintf(stderr, "lfc-top: %s\n", reason.c_str());
+    return 1;
+  }
+
+  // Only reads the page: never disturbs the controller (no syscall, no lock)
+  auto previous = page->counters.Load();
+  auto last = std::chrono::steady_clock::now();
+  while (true) {
+    if (!once) {
+      std::this_thread::sleep_for(std::chrono::duration<double>{period});
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    const auto counters = page->counters.Load();
+    if (page->magic.load(std::memory_order_acquire) !=
+        lfc::StatsPage::kMagic) {
+      std::fprintf(stderr, "lfc-top: '%s' has been released\n", name.c_str());
+      return 1;
+    }
+
+    // Clear the terminal, unless printing once
+    if (!once) std::fputs("\x1b[H\x1b[2J", stdout);
+    std::printf("%s\n", name.c_str());
+    Print(*page, counters, previous,
+          std::chrono::duration<double>(now - last).count());
+    std::fflush(stdout);
+
+    if (once) break;
+    previous = counters;
+    last = now;
+  }
+
+  return 0;
+}
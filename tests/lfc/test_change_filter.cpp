@@ -0,0 +1,68 @@
+#include <chrono>
+#include <limits>
+#include <vector>
+
+// lfc
+#include "lfc/change_filter.hpp"
+
+// gtest
+#include "gtest/gtest.h"
+
+namespace lfc {
+namespace {
+
+using namespace std::chrono_literals;
+
+TEST(ChangeFilterTest, OnChange) {
+  auto filter = ChangeFilter{2, /* epsilon = */ 0.1, /* keep_alive = */ 0s};
+  EXPECT_EQ(filter.Size(), 2u);
+  const auto t0 = ChangeFilter::clock::time_point{} + 1s;
+
+  // The first command is always published
+  EXPECT_TRUE(filter.ShouldPublish(std::vector<double>{1., 2.}.data(), t0));
+
+  // Within epsilon of the last command PUBLISHED (no drift)
+  EXPECT_FALSE(filter.ShouldPublish(std::vector<double>{1.05, 2.}.data(), t0));
+  EXPECT_FALSE(filter.ShouldPublish(std::vector<double>{1.09, 2.}.data(), t0));
+  EXPECT_TRUE(filter.ShouldPublish(std::vector<double>{1., 2.2}.data(), t0));
+  EXPECT_FALSE(filter.ShouldPublish(std::vector<double>{1., 2.2}.data(), t0));
+
+  // Never republished without a change
+  EXPECT_FALSE(
+      filter.ShouldPublish(std::vector<double>{1., 2.2}.data(), t0 + 1h));
+
+  EXPECT_EQ(filter.Suppressed(), 4u);
+}
+
+TEST(ChangeFilterTest, KeepAlive) {
+  auto filter = ChangeFilter{1, /* epsilon = */ 0., /* keep_alive = */ 10ms};
+  const auto t0 = ChangeFilter::clock::time_point{} + 1s;
+  const auto y = std::vector<double>{3.};
+
+  EXPECT_TRUE(filter.ShouldPublish(y.data(), t0));
+  EXPECT_FALSE(filter.ShouldPublish(y.data(), t0 + 9ms));
+  EXPECT_TRUE(filter.ShouldPublish(y.data(), t0 + 10ms));
+  EXPECT_FALSE(filter.ShouldPublish(y.data(), t0 + 12ms));
+
+  // Any change is published (epsilon = 0), resetting the keep alive
+  EXPECT_TRUE(filter.ShouldPublish(std::vector<double>{3.5}.data(),
+                                   t0 + 15ms));
+  EXPECT_FALSE(filter.ShouldPublish(std::vector<double>{3.5}.data(),
+                                    t0 + 24ms));
+
+  EXPECT_EQ(filter.Suppressed(), 3u);
+}
+
+TEST(ChangeFilterTest, NaN) {
+  auto filter = ChangeFilter{1, /* epsilon = */ 1., /* keep_alive = */ 0s};
+  const auto t0 = ChangeFilter::clock::time_point{};
+  const auto nan = std::vector<double>{
+      std::numeric_limits<double>::quiet_NaN()};
+
+  EXPECT_TRUE(filter.ShouldPublish(std::vector<double>{0.}.data(), t0));
+  EXPECT_TRUE(filter.ShouldPublish(nan.data(), t0));
+  EXPECT_TRUE(filter.ShouldPublish(nan.data(), t0));
+}
+
+} // namespace
+} // namespace lfc
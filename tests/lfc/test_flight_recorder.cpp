@@ -0,0 +1,205 @@
+#include <unistd.h>
+
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// lfc
+#include "lfc/flight_recorder.hpp"
+
+// gtest
+#include "gtest/gtest.h"
+
+namespace lfc {
+namespace {
+
+auto TempPath() -> std::string {
+  return "/tmp/lfc-test-flight-recorder-" + std::to_string(::getpid());
+}
+
+/// Record \a count records, the values of the record i being derived from i
+auto RecordMany(FlightRecorder &recorder, std::uint64_t count) -> void {
+  auto x = std::vector<double>(recorder.XSize());
+  auto y = std::vector<double>(recorder.YSize());
+  for (std::uint64_t i = 1; i <= count; ++i) {
+    const auto value = static_cast<double>(i);
+    std::fill(x.begin(), x.end(), value);
+    std::fill(y.begin(), y.end(), -value);
+    recorder.Record(i / 10, static_cast<std::int64_t>(i * 1000),
+                    static_cast<std::int64_t>(i * 1000 - 1), x.data(),
+                    y.data());
+  }
+}
+
+auto DumpAndLoad(const FlightRecorder &recorder, FlightDumpHeader &header)
+    -> std::vector<FlightRecord> {
+  const auto path = TempPath();
+  EXPECT_TRUE(recorder.DumpTo(path.c_str()));
+
+  auto reason = std::string{};
+  auto records = LoadFlightDump(path, header, reason);
+  std::remove(path.c_str());
+
+  EXPECT_TRUE(records.has_value()) << reason;
+  return records.value_or(std::vector<FlightRecord>{});
+}
+
+TEST(FlightRecorderTest, Create) {
+  auto reason = std::string{};
+  EXPECT_FALSE(FlightRecorder::Create(2, 1, 0, reason).has_value());
+  EXPECT_FALSE(reason.empty());
+
+  const auto recorder = FlightRecorder::Create(2, 1, 8, reason);
+  ASSERT_TRUE(recorder.has_value()) << reason;
+  EXPECT_EQ(recorder->XSize(), 2u);
+  EXPECT_EQ(recorder->YSize(), 1u);
+  EXPECT_EQ(recorder->Capacity(), 8u);
+  EXPECT_EQ(recorder->Recorded(), 0u);
+}
+
+TEST(FlightRecorderTest, DumpBeforeWrapping) {
+  auto reason = std::string{};
+  auto recorder = FlightRecorder::Create(3, 2, 8, reason);
+  ASSERT_TRUE(recorder.has_value()) << reason;
+
+  RecordMany(*recorder, 5);
+
+  auto header = FlightDumpHeader{};
+  const auto records = DumpAndLoad(*recorder, header);
+  EXPECT_EQ(header.x_size, 3u);
+  EXPECT_EQ(header.y_size, 2u);
+  EXPECT_EQ(header.count, 5u);
+  EXPECT_EQ(header.recorded, 5u);
+
+  ASSERT_EQ(records.size(), 5u);
+  for (std::uint64_t i = 1; i <= records.size(); ++i) {
+    const auto &record = records[i - 1];
+    EXPECT_EQ(record.sequence, i);
+    EXPECT_EQ(record.model_version, i / 10);
+    EXPECT_EQ(record.time_ns, static_cast<std::int64_t>(i * 1000));
+    EXPECT_EQ(record.stamp_ns, static_cast<std::int64_t>(i * 1000 - 1));
+    EXPECT_EQ(record.x, std::vector<double>(3, static_cast<double>(i)));
+    EXPECT_EQ(record.y, std::vector<double>(2, -static_cast<double>(i)));
+  }
+}
+
+TEST(FlightRecorderTest, DumpKeepsTheLastRecords) {
+  auto reason = std::string{};
+  auto recorder = FlightRecorder::Create(1, 1, 8, reason);
+  ASSERT_TRUE(recorder.has_value()) << reason;
+
+  RecordMany(*recorder, 29);
+
+  auto header = FlightDumpHeader{};
+  const auto records = DumpAndLoad(*recorder, header);
+  EXPECT_EQ(header.count, 8u);
+  EXPECT_EQ(header.recorded, 29u);
+
+  ASSERT_EQ(records.size(), 8u);
+  for (std::size_t i = 0; i < records.size(); ++i) {
+    EXPECT_EQ(records[i].sequence, 22u + i);
+    EXPECT_EQ(records[i].x.front(), static_cast<double>(22u + i));
+  }
+}
+
+TEST(FlightRecorderTest, LoadFailures) {
+  auto header = FlightDumpHeader{};
+  auto reason = std::string{};
+  EXPECT_FALSE(LoadFlightDump(TempPath() + "-missing", header, reason));
+  EXPECT_FALSE(reason.empty());
+
+  // Not a dump
+  const auto path = TempPath();
+  {
+    auto file = std::ofstream{path, std::ios::binary};
+    file << std::string(sizeof(FlightDumpHeader), 'x');
+  }
+  reason.clear();
+  EXPECT_FALSE(LoadFlightDump(path, header, reason));
+  EXPECT_FALSE(reason.empty());
+  std::remove(path.c_str());
+}
+
+TEST(FlightRecorderDeathTest, DumpOnFault) {
+  const auto path = TempPath() + "-fault";
+  std::remove(path.c_str());
+
+  EXPECT_DEATH(
+      {
+        auto reason = std::string{};
+        auto recorder = FlightRecorder::Create(2, 2, 4, reason);
+        RecordMany(*recorder, 6);
+        DumpOnFault(*recorder, path);
+        std::abort();
+      },
+      "");
+
+  auto header = FlightDumpHeader{};
+  auto reason = std::string{};
+  const auto records = LoadFlightDump(path, header, reason);
+  std::remove(path.c_str());
+
+  ASSERT_TRUE(records.has_value()) << reason;
+  ASSERT_EQ(records->size(), 4u);
+  EXPECT_EQ(records->front().sequence, 3u);
+  EXPECT_EQ(records->back().sequence, 6u);
+}
+
+/// Previous action of a fault signal, writing \a marker then exiting with
+/// \a code (async signal safe)
+template <int kCode>
+auto ExitWithCode(int /* signal */) -> void {
+  constexpr char kMarker[] = "previous action\n";
+  [[maybe_unused]] const auto written =
+      ::write(STDERR_FILENO, kMarker, sizeof(kMarker) - 1);
+  ::_exit(kCode);
+}
+
+TEST(FlightRecorderDeathTest, DumpOnFaultChainsThePreviousAction) {
+  const auto path = TempPath() + "-chained";
+
+  // abort(), raised again by the handler
+  std::remove(path.c_str());
+  EXPECT_EXIT(
+      {
+        std::signal(SIGABRT, ExitWithCode<3>);
+        auto reason = std::string{};
+        auto recorder = FlightRecorder::Create(2, 2, 4, reason);
+        RecordMany(*recorder, 2);
+        DumpOnFault(*recorder, path);
+        std::abort();
+      },
+      testing::ExitedWithCode(3), "previous action");
+
+  auto header = FlightDumpHeader{};
+  auto reason = std::string{};
+  auto records = LoadFlightDump(path, header, reason);
+  ASSERT_TRUE(records.has_value()) << reason;
+  EXPECT_EQ(records->size(), 2u);
+
+  // Bad access, faulting again once the previous action is restored
+  std::remove(path.c_str());
+  EXPECT_EXIT(
+      {
+        std::signal(SIGSEGV, ExitWithCode<4>);
+        auto recorder = FlightRecorder::Create(2, 2, 4, reason);
+        RecordMany(*recorder, 3);
+        DumpOnFault(*recorder, path);
+        DumpOnFault(*recorder, path); // Handlers set once: not chained twice
+
+        int *volatile bad = nullptr;
+        *bad = 1;
+      },
+      testing::ExitedWithCode(4), "previous action");
+
+  records = LoadFlightDump(path, header, reason);
+  std::remove(path.c_str());
+  ASSERT_TRUE(records.has_value()) << reason;
+  EXPECT_EQ(records->size(), 3u);
+}
+
+} // namespace
+} // namespace lfc
@@ -0,0 +1,117 @@
+#include <cstdint>
+#include <limits>
+#include <thread>
+
+// lfc
+#include "lfc/lockfree/histogram.hpp"
+
+// gtest
+#include "gtest/gtest.h"
+
+namespace lfc::lockfree {
+namespace {
+
+TEST(HistogramTest, Init) {
+  auto histogram = Histogram<>{};
+  EXPECT_EQ(histogram.Count(), 0u);
+  EXPECT_EQ(histogram.Sum(), 0u);
+  EXPECT_EQ(histogram.Max(), 0u);
+  EXPECT_EQ(histogram.Mean(), 0.);
+  EXPECT_EQ(histogram.ValueAtPercentile(50.), 0u);
+}
+
+TEST(HistogramTest, Buckets) {
+  using histogram_t = Histogram<4>;
+
+  // Small values are exact
+  for (std::uint64_t value = 0; value < histogram_t::kSubBuckets; ++value) {
+    EXPECT_EQ(histogram_t::BucketOf(value), value);
+    EXPECT_EQ(histogram_t::LowestOf(value), value);
+    EXPECT_EQ(histogram_t::HighestOf(value), value);
+  }
+
+  // Each value falls within its bucket, with a bounded relative error
+  for (std::uint64_t value :
+       {std::uint64_t{16}, std::uint64_t{17}, std::uint64_t{31},
+        std::uint64_t{32}, std::uint64_t{1'000}, std::uint64_t{123'456'789},
+        std::numeric_limits<std::uint64_t>::max()}) {
+    const auto bucket = histogram_t::BucketOf(value);
+    ASSERT_LT(bucket, histogram_t::kBuckets) << value;
+    EXPECT_LE(histogram_t::LowestOf(bucket), value);
+    EXPECT_GE(histogram_t::HighestOf(bucket), value);
+    EXPECT_LE(histogram_t::HighestOf(bucket) - histogram_t::LowestOf(bucket),
+              histogram_t::LowestOf(bucket) / histogram_t::kSubBuckets);
+  }
+
+  // Contiguous buckets
+  for (std::size_t bucket = 1; bucket < histogram_t::kBuckets; ++bucket) {
+    ASSERT_EQ(histogram_t::LowestOf(bucket),
+              histogram_t::HighestOf(bucket - 1) + 1)
+        << bucket;
+  }
+}
+
+TEST(HistogramTest, Percentiles) {
+  auto histogram = Histogram<>{};
+  for (std::uint64_t value = 1; value <= 100; ++value) {
+    histogram.Record(value * 1'000);
+  }
+
+  EXPECT_EQ(histogram.Count(), 100u);
+  EXPECT_EQ(histogram.Sum(), 5'050'000u);
+  EXPECT_EQ(histogram.Max(), 100'000u);
+  EXPECT_DOUBLE_EQ(histogram.Mean(), 50'500.);
+
+  // Within the precision of the histogram (1/16)
+  EXPECT_NEAR(static_cast<double>(histogram.ValueAtPercentile(50.)), 50'000.,
+              50'000. / 16);
+  EXPECT_NEAR(static_cast<double>(histogram.ValueAtPercentile(90.)), 90'000.,
+              90'000. / 16);
+  EXPECT_EQ(histogram.ValueAtPercentile(100.), 100'000u);
+  EXPECT_LE(histogram.ValueAtPercentile(0.), 1'000u + 1'000u / 16);
+
+  histogram.Reset();
+  EXPECT_EQ(histogram.Count(), 0u);
+  EXPECT_EQ(histogram.ValueAtPercentile(50.), 0u);
+}
+
+TEST(HistogramTest, Merge) {
+  auto lhs = Histogram<>{};
+  auto rhs = Histogram<>{};
+  for (std::uint64_t i = 1; i <= 100; ++i) lhs.Record(i);
+  for (std::uint64_t i = 101; i <= 300; ++i) rhs.Record(i);
+
+  lhs.Merge(rhs);
+  EXPECT_EQ(lhs.Count(), 300u);
+  EXPECT_EQ(lhs.Sum(), 300u * 301u / 2);
+  EXPECT_EQ(lhs.Max(), 300u);
+  EXPECT_NEAR(static_cast<double>(lhs.ValueAtPercentile(50.)), 150., 10.);
+
+  // Merging a lower max keeps the highest one
+  rhs.Merge(Histogram<>{});
+  EXPECT_EQ(rhs.Max(), 300u);
+}
+
+TEST(HistogramTest, ConcurrentReader) {
+  constexpr std::uint64_t kLast = 200'000;
+  auto histogram = Histogram<>{};
+
+  auto writer = std::thread([&]() {
+    for (std::uint64_t i = 1; i <= kLast; ++i) histogram.Record(i);
+  });
+
+  // Readers only ever observe monotonic counts
+  auto last_count = std::uint64_t{0};
+  while (last_count < kLast) {
+    const auto count = histogram.Count();
+    ASSERT_GE(count, last_count);
+    ASSERT_LE(histogram.ValueAtPercentile(99.), kLast);
+    last_count = count;
+  }
+
+  writer.join();
+  EXPECT_EQ(histogram.Max(), kLast);
+}
+
+} // namespace
+} // namespace lfc::lockfree
@@ -402,6 +402,51 @@ TEST_F(LinearModelMockedTest, Solve) {
   }
 }
 
+TEST_F(LinearModelMockedTest, SolveInto) {
+  using testing::Ref;
+  using testing::Return;
+  using tests::ArgSide;
+
+  input_t x = 123;
+
+  {
+    // WITH OFFSET
+    auto model = MockedModel();
+    testing::InSequence seq;
+    input_t y = 0;
+
+    // y = (coeffs * x) -> 321
+    EXPECT_CALL(model.coeffs, Multiplication(x, ArgSide::Right))
+        .Times(1)
+        .WillOnce(Return(321))
+        .RetiresOnSaturation();
+
+    // y += offset -> -1
+    EXPECT_CALL(model.offset, Addition(321, ArgSide::Left))
+        .Times(1)
+        .WillOnce(Return(-1))
+        .RetiresOnSaturation();
+
+    SolveInto(model, x, y);
+    EXPECT_EQ(y, -1);
+  }
+
+  {
+    // NO OFFSET
+    auto model = MockedModelWithoutOffset();
+    input_t y = 0;
+
+    // y = (coeffs * x) -> 456
+    EXPECT_CALL(model.coeffs, Multiplication(x, ArgSide::Right))
+        .Times(1)
+        .WillOnce(Return(456))
+        .RetiresOnSaturation();
+
+    SolveInto(model, x, y);
+    EXPECT_EQ(y, 456);
+  }
+}
+
 TEST_F(LinearModelMockedTest, TryToSolve) {
   using tests::ArgSide;
 
@@ -498,6 +543,23 @@ TEST_F(LinearModelMockedDeathTest, SolvePreconditions) {
         Solve(model, input_t{});
       },
       "Accepts\\(m, x\\)");
+
+  input_t y{};
+
+  EXPECT_DEBUG_DEATH(
+      {
+        ON_CALL(model.coeffs, IsValid()).WillByDefault(Return(false));
+        SolveInto(model, input_t{}, y);
+      },
+      "IsValid\\(m\\)");
+
+  EXPECT_DEBUG_DEATH(
+      {
+        ON_CALL(model.coeffs, IsValid()).WillByDefault(Return(true));
+        ON_CALL(model.coeffs, Accepts(_)).WillByDefault(Return(false));
+        SolveInto(model, input_t{}, y);
+      },
+      "Accepts\\(m, x\\)");
 }
 
 } // namespace
@@ -0,0 +1,138 @@
+#include <memory>
+#include <numeric>
+#include <vector>
+
+// lfc
+#include "lfc/linear_model_trajectory.hpp"
+
+// gtest
+#include "gtest/gtest.h"
+
+namespace lfc {
+namespace {
+
+/// 3 models of 2x1 coeffs + 2 offset values: {0, 1, 2, 3}, {4, 5, 6, 7}, ...
+auto MakeValues() -> std::vector<double> {
+  auto values = std::vector<double>(12);
+  std::iota(values.begin(), values.end(), 0.);
+  return values;
+}
+
+TEST(LinearModelTrajectoryTest, Make) {
+  {
+    auto trajectory = LinearModelTrajectory<double>{};
+    EXPECT_EQ(trajectory.Count(), 0);
+    EXPECT_EQ(trajectory.Stride(), 0);
+  }
+
+  {
+    auto trajectory = MakeLinearModelTrajectory(2, 1, 10., 0.5, MakeValues());
+    ASSERT_TRUE(trajectory.has_value());
+    EXPECT_EQ(trajectory->Count(), 3);
+    EXPECT_EQ(trajectory->Rows(), 2);
+    EXPECT_EQ(trajectory->Cols(), 1);
+    EXPECT_EQ(trajectory->Stride(), 4);
+    EXPECT_EQ(trajectory->Start(), 10.);
+    EXPECT_EQ(trajectory->Period(), 0.5);
+  }
+
+  // Not a whole number of models
+  EXPECT_FALSE(MakeLinearModelTrajectory(2, 3, 0., 1., MakeValues()));
+  EXPECT_FALSE(MakeLinearModelTrajectory(0, 0, 0., 1., MakeValues()));
+
+  // dt must be > 0
+  EXPECT_FALSE(MakeLinearModelTrajectory(2, 1, 0., 0., MakeValues()));
+  EXPECT_FALSE(MakeLinearModelTrajectory(2, 1, 0., -1., MakeValues()));
+
+  // Borrowed values can't be null
+  EXPECT_FALSE(MakeLinearModelTrajectory<double>(2, 1, 0., 1., nullptr, 4,
+                                                 nullptr));
+}
+
+TEST(LinearModelTrajectoryTest, Models) {
+  const auto trajectory =
+      MakeLinearModelTrajectory(2, 1, 0., 1., MakeValues()).value();
+
+  for (std::size_t k = 0; k < trajectory.Count(); ++k) {
+    const auto first = static_cast<double>(k * 4);
+    EXPECT_EQ(trajectory.Coeffs(k)[0], first) << "k = " << k;
+    EXPECT_EQ(trajectory.Coeffs(k)[1], first + 1) << "k = " << k;
+    EXPECT_EQ(trajectory.Offset(k)[0], first + 2) << "k = " << k;
+    EXPECT_EQ(trajectory.Offset(k)[1], first + 3) << "k = " << k;
+  }
+}
+
+TEST(LinearModelTrajectoryTest, Borrowed) {
+  auto values = std::make_shared<std::vector<double>>(MakeValues());
+
+  auto trajectory = MakeLinearModelTrajectory<double>(
+      2, 1, 0., 1., values->data(), values->size(), values);
+  ASSERT_TRUE(trajectory.has_value());
+  EXPECT_EQ(trajectory->Count(), 3);
+
+  // No copies, and the owner is kept alive
+  EXPECT_EQ(trajectory->Coeffs(0), values->data());
+  EXPECT_EQ(values.use_count(), 2);
+
+  trajectory.reset();
+  EXPECT_EQ(values.use_count(), 1);
+}
+
+TEST(LinearModelTrajectoryTest, RowMajorToColumnMajorModels) {
+  // 2 models of 2x3 coeffs {0, 1, 2; 3, 4, 5} (row major) + 2 offset values
+  auto values = std::vector<double>(16);
+  std::iota(values.begin(), values.end(), 0.);
+  std::iota(values.begin() + 8, values.end(), 0.);
+
+  ASSERT_TRUE(RowMajorToColumnMajorModels(2, 3, values));
+  const auto model = std::vector<double>{0., 3., 1., 4., 2., 5., 6., 7.};
+  EXPECT_EQ(std::vector<double>(values.begin(), values.begin() + 8), model);
+  EXPECT_EQ(std::vector<double>(values.begin() + 8, values.end()), model);
+
+  // Not a whole number of models
+  auto partial = MakeValues();
+  EXPECT_FALSE(RowMajorToColumnMajorModels(2, 3, partial));
+  EXPECT_EQ(partial, MakeValues());
+}
+
+TEST(LinearModelTrajectoryTest, Locate) {
+  const auto trajectory =
+      MakeLinearModelTrajectory(2, 1, 10., 0.5, MakeValues()).value();
+
+  // t_k = 10 + k * 0.5, with k in [0, 2]
+  for (auto interpolation :
+       {TrajectoryInterpolation::kHold, TrajectoryInterpolation::kLinear}) {
+    const auto linear = (interpolation == TrajectoryInterpolation::kLinear);
+
+    // Clamped before/after the trajectory
+    EXPECT_EQ(trajectory.Locate(0., interpolation).index, 0);
+    EXPECT_EQ(trajectory.Locate(0., interpolation).alpha, 0.);
+    EXPECT_EQ(trajectory.Locate(10., interpolation).index, 0);
+    EXPECT_EQ(trajectory.Locate(11., interpolation).index, 2);
+    EXPECT_EQ(trajectory.Locate(11., interpolation).alpha, 0.);
+    EXPECT_EQ(trajectory.Locate(42., interpolation).index, 2);
+    EXPECT_EQ(trajectory.Locate(42., interpolation).alpha, 0.);
+
+    EXPECT_EQ(trajectory.Locate(10.25, interpolation).index, 0);
+    EXPECT_EQ(trajectory.Locate(10.25, interpolation).alpha,
+              linear ? 0.5 : 0.);
+    EXPECT_EQ(trajectory.Locate(10.5, interpolation).index, 1);
+    EXPECT_EQ(trajectory.Locate(10.5, interpolation).alpha, 0.);
+    EXPECT_EQ(trajectory.Locate(10.875, interpolation).index, 1);
+    EXPECT_EQ(trajectory.Locate(10.875, interpolation).alpha,
+              linear ? 0.75 : 0.);
+  }
+}
+
+TEST(LinearModelTrajectoryTest, Prefetch) {
+  const auto trajectory =
+      MakeLinearModelTrajectory(2, 1, 0., 1., MakeValues()).value();
+
+  // Only hints, out of bounds models are ignored
+  for (std::size_t k = 0; k <= trajectory.Count(); ++k) {
+    trajectory.Prefetch(k);
+  }
+}
+
+} // namespace
+} // namespace lfc
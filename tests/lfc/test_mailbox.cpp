@@ -0,0 +1,109 @@
+#include <array>
+#include <cstdint>
+#include <thread>
+
+// lfc
+#include "lfc/lockfree/mailbox.hpp"
+
+// gtest
+#include "gtest/gtest.h"
+
+namespace lfc::lockfree {
+namespace {
+
+TEST(MailboxTest, Init) {
+  {
+    auto mailbox = Mailbox<int>{};
+    EXPECT_EQ(mailbox.Front(), 0);
+    EXPECT_FALSE(mailbox.Fetch());
+    EXPECT_EQ(mailbox.Front(), 0);
+  }
+
+  {
+    auto mailbox = Mailbox<int>{42};
+    EXPECT_EQ(mailbox.Front(), 42);
+    EXPECT_EQ(mailbox.Back(), 42);
+    EXPECT_FALSE(mailbox.Fetch());
+    EXPECT_EQ(mailbox.Front(), 42);
+  }
+}
+
+TEST(MailboxTest, KeepsTheLatestValue) {
+  auto mailbox = Mailbox<int>{};
+
+  mailbox.Back() = 1;
+  mailbox.Post();
+  EXPECT_TRUE(mailbox.Fetch());
+  EXPECT_EQ(mailbox.Front(), 1);
+
+  // Nothing new: Front() is untouched
+  EXPECT_FALSE(mailbox.Fetch());
+  EXPECT_EQ(mailbox.Front(), 1);
+
+  // Unread values are overwritten
+  for (int i = 2; i < 10; ++i) {
+    mailbox.Back() = i;
+    mailbox.Post();
+  }
+  EXPECT_EQ(mailbox.Front(), 1);
+  EXPECT_TRUE(mailbox.Fetch());
+  EXPECT_EQ(mailbox.Front(), 9);
+  EXPECT_FALSE(mailbox.Fetch());
+}
+
+TEST(MailboxTest, WriterNeverTouchesFront) {
+  auto mailbox = Mailbox<int>{};
+
+  mailbox.Back() = 1;
+  mailbox.Post();
+  ASSERT_TRUE(mailbox.Fetch());
+
+  const auto *front = &mailbox.Front();
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_NE(&mailbox.Back(), front);
+    mailbox.Back() = -1;
+    mailbox.Post();
+  }
+  EXPECT_EQ(*front, 1);
+}
+
+TEST(MailboxTest, ForEachSlot) {
+  auto mailbox = Mailbox<int>{};
+  mailbox.ForEachSlot([](int &v) { v = 3; });
+  EXPECT_EQ(mailbox.Front(), 3);
+  EXPECT_EQ(mailbox.Back(), 3);
+}
+
+TEST(MailboxTest, NoTearingBetweenThreads) {
+  // Each value is an array filled with the same number: the reader must never
+  // see a mix of two values, and values must never go backward.
+  using value_t = std::array<std::uint64_t, 32>;
+  constexpr std::uint64_t kLast = 100'000;
+
+  auto mailbox = Mailbox<value_t>{};
+
+  auto writer = std::thread([&]() {
+    for (std::uint64_t i = 1; i <= kLast; ++i) {
+      mailbox.Back().fill(i);
+      mailbox.Post();
+    }
+  });
+
+  std::uint64_t last_seen = 0;
+  while (last_seen != kLast) {
+    if (!mailbox.Fetch()) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    const auto &value = mailbox.Front();
+    for (auto v : value) ASSERT_EQ(v, value.front());
+    ASSERT_GT(value.front(), last_seen);
+    last_seen = value.front();
+  }
+
+  writer.join();
+}
+
+} // namespace
+} // namespace lfc::lockfree
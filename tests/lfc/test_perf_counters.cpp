@@ -0,0 +1,43 @@
+#include <cstdint>
+#include <string>
+
+// lfc
+#include "lfc/perf_counters.hpp"
+
+// gtest
+#include "gtest/gtest.h"
+
+namespace lfc {
+namespace {
+
+TEST(PerfCountersTest, ToString) {
+  EXPECT_EQ(ToString(PerfEvent::kCycles), "cycles");
+  EXPECT_EQ(ToString(PerfEvent::kInstructions), "instructions");
+  EXPECT_EQ(ToString(PerfEvent::kLlcMisses), "llc_misses");
+  EXPECT_EQ(ToString(PerfEvent::kBranchMisses), "branch_misses");
+}
+
+TEST(PerfCountersTest, Measure) {
+  auto reason = std::string{};
+  const auto perf = PerfCounters::Open(reason);
+  if (!perf.has_value()) {
+    EXPECT_FALSE(reason.empty());
+    GTEST_SKIP() << "Perf events unavailable: " << reason;
+  }
+
+  volatile std::uint64_t sum = 0;
+  auto called = false;
+  auto delta = PerfSample{};
+  ASSERT_TRUE(perf->Measure(delta, [&]() {
+    for (std::uint64_t i = 0; i < 100'000; ++i) sum = sum + i;
+    called = true;
+  }));
+
+  EXPECT_TRUE(called);
+  EXPECT_GT(delta[static_cast<std::size_t>(PerfEvent::kCycles)], 0u);
+  EXPECT_GT(delta[static_cast<std::size_t>(PerfEvent::kInstructions)],
+            100'000u);
+}
+
+} // namespace
+} // namespace lfc
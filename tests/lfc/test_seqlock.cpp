@@ -0,0 +1,148 @@
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+// lfc
+#include "lfc/lockfree/seqlock.hpp"
+
+// gtest
+#include "gtest/gtest.h"
+
+namespace lfc::lockfree {
+namespace {
+
+struct Values {
+  std::uint64_t a = 0;
+  std::uint64_t b = 0;
+  std::array<char, 5> c = {}; /* Not a whole number of words */
+};
+
+TEST(SeqlockTest, Init) {
+  auto seqlock = Seqlock<Values>{};
+  EXPECT_EQ(seqlock.Sequence(), 0u);
+
+  auto values = Values{1, 2, {}};
+  EXPECT_TRUE(seqlock.TryLoad(values));
+  EXPECT_EQ(values.a, 0u);
+  EXPECT_EQ(values.b, 0u);
+}
+
+TEST(SeqlockTest, Store) {
+  auto seqlock = Seqlock<Values>{};
+
+  seqlock.Store(Values{1, 2, {'a', 'b', 'c', 'd', 'e'}});
+  EXPECT_EQ(seqlock.Sequence(), 2u);
+
+  const auto values = seqlock.Load();
+  EXPECT_EQ(values.a, 1u);
+  EXPECT_EQ(values.b, 2u);
+  EXPECT_EQ(values.c, (std::array<char, 5>{'a', 'b', 'c', 'd', 'e'}));
+
+  seqlock.Store(Values{3, 4, {}});
+  EXPECT_EQ(seqlock.Sequence(), 4u);
+  EXPECT_EQ(seqlock.Load().a, 3u);
+  EXPECT_EQ(seqlock.Load().b, 4u);
+}
+
+TEST(SeqlockTest, ConcurrentReaderNeverTears) {
+  auto seqlock = Seqlock<Values>{};
+  constexpr std::uint64_t kStores = 100'000;
+
+  seqlock.Store(Values{0, ~std::uint64_t{0}, {}});
+
+  auto done = std::atomic<bool>{false};
+  auto writer = std::thread([&]() {
+    for (std::uint64_t i = 1; i <= kStores; ++i) {
+      seqlock.Store(Values{i, ~i, {}});
+    }
+    done = true;
+  });
+
+  auto last = std::uint64_t{0};
+  while (!done) {
+    auto values = Values{};
+    if (!seqlock.TryLoad(values)) continue;
+
+    // Both words always come from the same Store()
+    ASSERT_EQ(values.b, ~values.a);
+    ASSERT_GE(values.a, last);
+    last = values.a;
+  }
+  writer.join();
+
+  EXPECT_EQ(seqlock.Load().a, kStores);
+}
+
+struct Header {
+  std::int64_t stamp = 0;
+};
+
+TEST(SeqlockArrayTest, Store) {
+  auto seqlock = SeqlockArray<Header, double>{3};
+  EXPECT_EQ(seqlock.Size(), 3u);
+  EXPECT_EQ(seqlock.Sequence(), 0u);
+
+  auto header = Header{1};
+  auto values = std::array<double, 3>{1., 2., 3.};
+  EXPECT_TRUE(seqlock.TryLoad(header, values.data()));
+  EXPECT_EQ(header.stamp, 0);
+  EXPECT_EQ(values, (std::array<double, 3>{0., 0., 0.}));
+
+  seqlock.Store(Header{42}, std::array<double, 3>{4., 5., 6.}.data());
+  EXPECT_EQ(seqlock.Sequence(), 2u);
+
+  seqlock.Load(header, values.data());
+  EXPECT_EQ(header.stamp, 42);
+  EXPECT_EQ(values, (std::array<double, 3>{4., 5., 6.}));
+}
+
+TEST(SeqlockArrayTest, NotWholeWords) {
+  auto seqlock = SeqlockArray<Header, char>{5};
+
+  seqlock.Store(Header{1}, "abcde");
+
+  auto header = Header{};
+  auto values = std::array<char, 6>{'x', 'x', 'x', 'x', 'x', 'x'};
+  seqlock.Load(header, values.data());
+  EXPECT_EQ(values, (std::array<char, 6>{'a', 'b', 'c', 'd', 'e', 'x'}));
+}
+
+TEST(SeqlockArrayTest, ConcurrentReaderNeverTears) {
+  constexpr std::size_t kSize = 16;
+  constexpr std::int64_t kStores = 100'000;
+  auto seqlock = SeqlockArray<Header, double>{kSize};
+
+  auto done = std::atomic<bool>{false};
+  auto writer = std::thread([&]() {
+    auto values = std::array<double, kSize>{};
+    for (std::int64_t i = 1; i <= kStores; ++i) {
+      values.fill(static_cast<double>(i));
+      seqlock.Store(Header{i}, values.data());
+    }
+    done = true;
+  });
+
+  auto last = std::int64_t{0};
+  while (!done) {
+    auto header = Header{};
+    auto values = std::array<double, kSize>{};
+    if (!seqlock.TryLoad(header, values.data())) continue;
+
+    // The header and all the values always come from the same Store()
+    for (auto value : values) {
+      ASSERT_EQ(value, static_cast<double>(header.stamp));
+    }
+    ASSERT_GE(header.stamp, last);
+    last = header.stamp;
+  }
+  writer.join();
+
+  auto header = Header{};
+  auto values = std::array<double, kSize>{};
+  seqlock.Load(header, values.data());
+  EXPECT_EQ(header.stamp, kStores);
+}
+
+} // namespace
+} // namespace lfc::lockfree
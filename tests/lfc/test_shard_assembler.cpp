@@ -0,0 +1,77 @@
+#include <vector>
+
+// lfc
+#include "lfc/shard_assembler.hpp"
+
+// gtest
+#include "gtest/gtest.h"
+
+namespace lfc {
+namespace {
+
+TEST(ShardAssemblerTest, Assemble) {
+  auto assembler = ShardAssembler{5};
+  const auto head = std::vector<double>{1., 2.};
+  const auto tail = std::vector<double>{3., 4., 5.};
+
+  // Any order, the last shard completing the command
+  EXPECT_EQ(assembler.Add(7, 2, tail.data(), tail.size()), nullptr);
+  const auto *y = assembler.Add(7, 0, head.data(), head.size());
+  ASSERT_NE(y, nullptr);
+  EXPECT_EQ(*y, (std::vector<double>{1., 2., 3., 4., 5.}));
+
+  // Rows added twice are only counted once
+  EXPECT_EQ(assembler.Add(8, 0, head.data(), head.size()), nullptr);
+  EXPECT_EQ(assembler.Add(8, 0, head.data(), head.size()), nullptr);
+  ASSERT_NE(assembler.Add(8, 2, tail.data(), tail.size()), nullptr);
+
+  EXPECT_EQ(assembler.Dropped(), 0u);
+  EXPECT_EQ(assembler.Ignored(), 0u);
+}
+
+TEST(ShardAssemblerTest, Interleaved) {
+  auto assembler = ShardAssembler{2, /* in_flight = */ 2};
+  const auto value = std::vector<double>{1.};
+
+  // 2 sequences at once, each one shard behind
+  EXPECT_EQ(assembler.Add(1, 0, value.data(), 1), nullptr);
+  EXPECT_EQ(assembler.Add(2, 0, value.data(), 1), nullptr);
+  EXPECT_NE(assembler.Add(1, 1, value.data(), 1), nullptr);
+  EXPECT_NE(assembler.Add(2, 1, value.data(), 1), nullptr);
+  EXPECT_EQ(assembler.Dropped(), 0u);
+
+  // No slot left: the oldest pending sequence (3) is dropped for 5, and the
+  // ones older than all the pending ones ignored
+  EXPECT_EQ(assembler.Add(3, 0, value.data(), 1), nullptr);
+  EXPECT_EQ(assembler.Add(4, 0, value.data(), 1), nullptr);
+  EXPECT_EQ(assembler.Add(5, 0, value.data(), 1), nullptr);
+  EXPECT_EQ(assembler.Dropped(), 1u);
+  EXPECT_EQ(assembler.Add(3, 1, value.data(), 1), nullptr);
+  EXPECT_EQ(assembler.Ignored(), 1u);
+
+  // 5 is complete: 4 is dropped, and never published
+  EXPECT_NE(assembler.Add(5, 1, value.data(), 1), nullptr);
+  EXPECT_EQ(assembler.Dropped(), 2u);
+  EXPECT_EQ(assembler.Add(4, 1, value.data(), 1), nullptr);
+  EXPECT_EQ(assembler.Ignored(), 2u);
+}
+
+TEST(ShardAssemblerTest, Ignored) {
+  auto assembler = ShardAssembler{3};
+  const auto values = std::vector<double>{1., 2., 3., 4.};
+
+  // Out of the command rows
+  EXPECT_EQ(assembler.Add(1, 0, values.data(), 4), nullptr);
+  EXPECT_EQ(assembler.Add(1, 3, values.data(), 1), nullptr);
+  EXPECT_EQ(assembler.Add(1, 0, values.data(), 0), nullptr);
+  EXPECT_EQ(assembler.Ignored(), 3u);
+
+  // Not newer than the last complete command
+  ASSERT_NE(assembler.Add(2, 0, values.data(), 3), nullptr);
+  EXPECT_EQ(assembler.Add(2, 0, values.data(), 3), nullptr);
+  EXPECT_EQ(assembler.Add(1, 0, values.data(), 3), nullptr);
+  EXPECT_EQ(assembler.Ignored(), 5u);
+}
+
+} // namespace
+} // namespace lfc
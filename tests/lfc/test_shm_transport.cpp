@@ -0,0 +1,246 @@
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+// lfc
+#include "lfc/shm_transport.hpp"
+
+// gtest
+#include "gtest/gtest.h"
+
+namespace lfc {
+namespace {
+
+using namespace std::chrono_literals;
+
+auto UniqueName() -> std::string {
+  return "/lfc-test-shm-transport-" + std::to_string(::getpid());
+}
+
+TEST(ShmTransportTest, RoundTrip) {
+  const auto name = UniqueName();
+  auto reason = std::string{};
+
+  auto controller = ShmTransport::Create(name, 3, 2, 4, ShmWakeup::kBusyPoll,
+                                         reason);
+  ASSERT_TRUE(controller.has_value()) << reason;
+
+  auto driver = ShmTransport::Open(name, reason);
+  ASSERT_TRUE(driver.has_value()) << reason;
+  EXPECT_EQ(driver->XSize(), 3u);
+  EXPECT_EQ(driver->YSize(), 2u);
+  EXPECT_EQ(driver->Capacity(), 4u);
+  EXPECT_EQ(driver->ControllerPid(), ::getpid());
+
+  // DRIVER: state
+  auto *state = driver->States().TryClaim();
+  ASSERT_NE(state, nullptr);
+  state->sequence = 42;
+  state->stamp_ns = 1000;
+  state->Values()[0] = 1.;
+  state->Values()[2] = 3.;
+  EXPECT_EQ(controller->States().TryPeek(), nullptr); // Not committed yet
+  driver->States().Commit();
+
+  // CONTROLLER: state -> command
+  const auto *received = controller->States().Wait(1s);
+  ASSERT_NE(received, nullptr);
+  EXPECT_EQ(received->sequence, 42u);
+  EXPECT_EQ(received->stamp_ns, 1000);
+  EXPECT_EQ(received->Values()[2], 3.);
+
+  auto *command = controller->Commands().TryClaim();
+  ASSERT_NE(command, nullptr);
+  command->sequence = received->sequence;
+  command->Values()[1] = received->Values()[0] + received->Values()[2];
+  controller->States().Release();
+  controller->Commands().Commit();
+  EXPECT_EQ(controller->States().TryPeek(), nullptr);
+
+  // DRIVER: command
+  const auto *solved = driver->Commands().TryPeek();
+  ASSERT_NE(solved, nullptr);
+  EXPECT_EQ(solved->sequence, 42u);
+  EXPECT_EQ(solved->Values()[1], 4.);
+  driver->Commands().Release();
+}
+
+TEST(ShmTransportTest, Bounded) {
+  auto reason = std::string{};
+  auto controller = ShmTransport::Create(UniqueName(), 1, 1, 2,
+                                         ShmWakeup::kBusyPoll, reason);
+  ASSERT_TRUE(controller.has_value()) << reason;
+  auto &states = controller->States();
+
+  for (std::uint64_t i = 1; i <= 2; ++i) {
+    auto *slot = states.TryClaim();
+    ASSERT_NE(slot, nullptr);
+    slot->sequence = i;
+    states.Commit();
+  }
+  EXPECT_EQ(states.TryClaim(), nullptr);
+  EXPECT_EQ(states.Pending(), 2u);
+  const auto *oldest = states.Wait(0ns);
+  ASSERT_NE(oldest, nullptr);
+  EXPECT_EQ(oldest->sequence, 1u);
+
+  states.Release();
+  EXPECT_EQ(states.Pending(), 1u);
+  ASSERT_NE(states.TryClaim(), nullptr);
+  const auto *next = states.TryPeek();
+  ASSERT_NE(next, nullptr);
+  EXPECT_EQ(next->sequence, 2u);
+
+  // Nothing committed in time
+  states.Release();
+  EXPECT_EQ(states.Wait(1ms), nullptr);
+}
+
+TEST(ShmTransportTest, Reopen) {
+  const auto name = UniqueName();
+  auto reason = std::string{};
+  auto controller = ShmTransport::Create(name, 1, 1, 4, ShmWakeup::kBusyPoll,
+                                         reason);
+  ASSERT_TRUE(controller.has_value()) << reason;
+
+  // A first driver exchanges a few states/commands, such that the indices
+  // of both rings aren't 0 anymore (head == tail == 5)
+  {
+    auto driver = ShmTransport::Open(name, reason);
+    ASSERT_TRUE(driver.has_value()) << reason;
+    for (std::uint64_t i = 1; i <= 5; ++i) {
+      auto *state = driver->States().TryClaim();
+      ASSERT_NE(state, nullptr);
+      state->sequence = i;
+      driver->States().Commit();
+
+      const auto *received = controller->States().TryPeek();
+      ASSERT_NE(received, nullptr);
+      EXPECT_EQ(received->sequence, i);
+      controller->States().Release();
+
+      auto *command = controller->Commands().TryClaim();
+      ASSERT_NE(command, nullptr);
+      command->sequence = i;
+      controller->Commands().Commit();
+
+      const auto *solved = driver->Commands().TryPeek();
+      ASSERT_NE(solved, nullptr);
+      EXPECT_EQ(solved->sequence, i);
+      driver->Commands().Release();
+    }
+  }
+
+  // The next driver starts from the current indices, both ways
+  auto driver = ShmTransport::Open(name, reason);
+  ASSERT_TRUE(driver.has_value()) << reason;
+  EXPECT_EQ(driver->Commands().TryPeek(), nullptr);
+  EXPECT_EQ(driver->Commands().Pending(), 0u);
+
+  for (std::uint64_t i = 6; i <= 9; ++i) {
+    auto *state = driver->States().TryClaim();
+    ASSERT_NE(state, nullptr);
+    state->sequence = i;
+    driver->States().Commit();
+  }
+  EXPECT_EQ(driver->States().TryClaim(), nullptr); // 4 slots: full
+
+  auto controller_view = ShmTransport::Open(name, reason);
+  ASSERT_TRUE(controller_view.has_value()) << reason;
+  EXPECT_EQ(controller_view->States().Pending(), 4u);
+  const auto *oldest = controller_view->States().TryPeek();
+  ASSERT_NE(oldest, nullptr);
+  EXPECT_EQ(oldest->sequence, 6u);
+}
+
+TEST(ShmTransportTest, FutexWakeup) {
+  const auto name = UniqueName();
+  auto reason = std::string{};
+  auto controller =
+      ShmTransport::Create(name, 1, 1, 8, ShmWakeup::kFutex, reason);
+  ASSERT_TRUE(controller.has_value()) << reason;
+
+  // Stand-in driver: pushes each state once its previous one is solved
+  constexpr std::uint64_t kStates = 1000;
+  auto driver_thread = std::thread([&name]() {
+    auto error = std::string{};
+    auto driver = ShmTransport::Open(name, error);
+    ASSERT_TRUE(driver.has_value()) << error;
+
+    for (std::uint64_t i = 1; i <= kStates; ++i) {
+      auto *state = driver->States().TryClaim();
+      ASSERT_NE(state, nullptr);
+      state->sequence = i;
+      state->Values()[0] = static_cast<double>(i);
+      driver->States().Commit();
+
+      const auto *command = driver->Commands().Wait(5s);
+      ASSERT_NE(command, nullptr);
+      EXPECT_EQ(command->sequence, i);
+      EXPECT_EQ(command->Values()[0], 2. * static_cast<double>(i));
+      driver->Commands().Release();
+    }
+  });
+
+  for (std::uint64_t solved = 0; solved < kStates;) {
+    const auto *state = controller->States().Wait(5s);
+    ASSERT_NE(state, nullptr);
+
+    auto *command = controller->Commands().TryClaim();
+    ASSERT_NE(command, nullptr);
+    command->sequence = state->sequence;
+    command->Values()[0] = 2. * state->Values()[0];
+    controller->States().Release();
+    controller->Commands().Commit();
+    ++solved;
+  }
+
+  driver_thread.join();
+}
+
+TEST(ShmTransportTest, Failures) {
+  auto reason = std::string{};
+  EXPECT_FALSE(ShmTransport::Create(UniqueName(), 1, 1, 3,
+                                    ShmWakeup::kFutex, reason)
+                   .has_value());
+  EXPECT_FALSE(reason.empty());
+
+  reason.clear();
+  EXPECT_FALSE(ShmTransport::Open(UniqueName() + "-missing", reason)
+                   .has_value());
+  EXPECT_FALSE(reason.empty());
+
+  // Unlinked once the controller is gone
+  const auto name = UniqueName();
+  {
+    auto controller =
+        ShmTransport::Create(name, 1, 1, 1, ShmWakeup::kFutex, reason);
+    ASSERT_TRUE(controller.has_value()) << reason;
+    EXPECT_TRUE(ShmTransport::Open(name, reason).has_value()) << reason;
+
+    // Never taken over (nor unlinked) by another controller
+    reason.clear();
+    EXPECT_FALSE(ShmTransport::Create(name, 1, 1, 1, ShmWakeup::kFutex,
+                                      reason)
+                     .has_value());
+    EXPECT_NE(reason.find("already exists"), std::string::npos) << reason;
+    EXPECT_TRUE(ShmTransport::Open(name, reason).has_value()) << reason;
+  }
+  EXPECT_FALSE(ShmTransport::Open(name, reason).has_value());
+
+  // Too large to be mapped (or resized): never left behind
+  const auto huge = std::size_t{1} << 50;
+  reason.clear();
+  EXPECT_FALSE(ShmTransport::Create(name, 1, 1, huge, ShmWakeup::kFutex,
+                                    reason)
+                   .has_value());
+  EXPECT_FALSE(reason.empty());
+  auto controller =
+      ShmTransport::Create(name, 1, 1, 1, ShmWakeup::kFutex, reason);
+  EXPECT_TRUE(controller.has_value()) << reason;
+}
+
+} // namespace
+} // namespace lfc
@@ -0,0 +1,91 @@
+#include <cstdint>
+#include <thread>
+
+// lfc
+#include "lfc/lockfree/spsc_ring.hpp"
+
+// gtest
+#include "gtest/gtest.h"
+
+namespace lfc::lockfree {
+namespace {
+
+TEST(SpscRingTest, Empty) {
+  auto ring = SpscRing<int, 4>{};
+  static_assert(decltype(ring)::Capacity() == 4);
+
+  EXPECT_EQ(ring.TryPeek(), nullptr);
+  EXPECT_NE(ring.TryClaim(), nullptr);
+
+  // Claimed but not committed
+  EXPECT_EQ(ring.TryPeek(), nullptr);
+}
+
+TEST(SpscRingTest, Fifo) {
+  auto ring = SpscRing<int, 4>{-1};
+
+  for (int i = 0; i < 4; ++i) {
+    auto *slot = ring.TryClaim();
+    ASSERT_NE(slot, nullptr);
+    EXPECT_EQ(*slot, -1);
+    *slot = i;
+    ring.Commit();
+  }
+
+  // Full
+  EXPECT_EQ(ring.TryClaim(), nullptr);
+
+  for (int i = 0; i < 4; ++i) {
+    auto *slot = ring.TryPeek();
+    ASSERT_NE(slot, nullptr);
+    EXPECT_EQ(*slot, i);
+
+    // Same slot until released
+    EXPECT_EQ(ring.TryPeek(), slot);
+    ring.Release();
+
+    // Released slots are reused
+    EXPECT_NE(ring.TryClaim(), nullptr);
+  }
+
+  EXPECT_EQ(ring.TryPeek(), nullptr);
+}
+
+TEST(SpscRingTest, ForEachSlot) {
+  auto ring = SpscRing<int, 2>{};
+  ring.ForEachSlot([](int &v) { v = 7; });
+  const auto *slot = ring.TryClaim();
+  ASSERT_NE(slot, nullptr);
+  EXPECT_EQ(*slot, 7);
+}
+
+TEST(SpscRingTest, ProducerConsumer) {
+  constexpr std::uint64_t kLast = 200'000;
+  auto ring = SpscRing<std::uint64_t, 8>{};
+
+  auto producer = std::thread([&]() {
+    for (std::uint64_t i = 1; i <= kLast; ++i) {
+      std::uint64_t *slot = nullptr;
+      while ((slot = ring.TryClaim()) == nullptr) {
+        std::this_thread::yield();
+      }
+      *slot = i;
+      ring.Commit();
+    }
+  });
+
+  // Nothing is lost, nor reordered
+  for (std::uint64_t expected = 1; expected <= kLast; ++expected) {
+    std::uint64_t *slot = nullptr;
+    while ((slot = ring.TryPeek()) == nullptr) {
+      std::this_thread::yield();
+    }
+    ASSERT_EQ(*slot, expected);
+    ring.Release();
+  }
+
+  producer.join();
+}
+
+} // namespace
+} // namespace lfc::lockfree
@@ -0,0 +1,110 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+
+// lfc
+#include "lfc/stats_page.hpp"
+
+// gtest
+#include "gtest/gtest.h"
+
+namespace lfc {
+namespace {
+
+auto UniqueName() -> std::string {
+  return "/lfc-test-stats-page-" + std::to_string(::getpid());
+}
+
+TEST(StatsPageTest, SharedBetweenMappings) {
+  const auto name = UniqueName();
+  auto reason = std::string{};
+
+  auto writer = CreateSharedStatsPage(name, reason);
+  ASSERT_NE(writer, nullptr) << reason;
+  EXPECT_EQ(writer->pid, ::getpid());
+
+  const auto reader = OpenSharedStatsPage(name, reason);
+  ASSERT_NE(reader, nullptr) << reason;
+
+  auto counters = StatsCounters{};
+  counters.ticks = 42;
+  counters.kernel = {'f', 'i', 'x', 'e', 'd'};
+  writer->counters.Store(counters);
+  writer->dropped.fetch_add(3);
+  writer->solve.Record(1000);
+
+  EXPECT_EQ(reader->counters.Load().ticks, 42u);
+  EXPECT_EQ(std::string{reader->counters.Load().kernel.data()}, "fixed");
+  EXPECT_EQ(reader->dropped.load(), 3u);
+  EXPECT_EQ(reader->solve.Count(), 1u);
+  EXPECT_EQ(reader->solve.Max(), 1000u);
+
+  // Released: the reader sees it, and the name is gone
+  writer.reset();
+  EXPECT_NE(reader->magic.load(), StatsPage::kMagic);
+  EXPECT_EQ(OpenSharedStatsPage(name, reason), nullptr);
+}
+
+TEST(StatsPageTest, NeverTakesOverALiveController) {
+  const auto name = UniqueName();
+  auto reason = std::string{};
+
+  auto first = CreateSharedStatsPage(name, reason);
+  ASSERT_NE(first, nullptr) << reason;
+  first->dropped.fetch_add(1);
+
+  EXPECT_EQ(CreateSharedStatsPage(name, reason), nullptr);
+  EXPECT_NE(reason.find("already exists"), std::string::npos) << reason;
+
+  // Untouched
+  const auto reader = OpenSharedStatsPage(name, reason);
+  ASSERT_NE(reader, nullptr) << reason;
+  EXPECT_EQ(reader->dropped.load(), 1u);
+}
+
+TEST(StatsPageTest, ReplacesAnOrphanPage) {
+  const auto name = UniqueName();
+  auto reason = std::string{};
+
+  // A process that is gone
+  const auto child = ::fork();
+  ASSERT_GE(child, 0);
+  if (child == 0) ::_exit(0);
+  ASSERT_EQ(::waitpid(child, nullptr, 0), child);
+
+  auto orphan = CreateSharedStatsPage(name, reason);
+  ASSERT_NE(orphan, nullptr) << reason;
+  orphan->pid = child;
+
+  auto page = CreateSharedStatsPage(name, reason);
+  ASSERT_NE(page, nullptr) << reason;
+  EXPECT_EQ(page->pid, ::getpid());
+
+  // Releasing the orphan doesn't unlink the new page
+  orphan.reset();
+  EXPECT_NE(OpenSharedStatsPage(name, reason), nullptr) << reason;
+}
+
+TEST(StatsPageTest, NeverReplacesAnotherObject) {
+  const auto name = UniqueName();
+  const auto fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  ASSERT_GE(fd, 0);
+  ::close(fd);
+
+  auto reason = std::string{};
+  EXPECT_EQ(CreateSharedStatsPage(name, reason), nullptr);
+  EXPECT_NE(reason.find("already exists"), std::string::npos) << reason;
+  EXPECT_EQ(::shm_unlink(name.c_str()), 0);
+}
+
+TEST(StatsPageTest, OpenFailures) {
+  auto reason = std::string{};
+  EXPECT_EQ(OpenSharedStatsPage(UniqueName() + "-missing", reason), nullptr);
+  EXPECT_FALSE(reason.empty());
+}
+
+} // namespace
+} // namespace lfc
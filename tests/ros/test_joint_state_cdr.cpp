@@ -0,0 +1,237 @@
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// lfc
+#include "joint_state_cdr.hpp"
+
+// gtest
+#include "gtest/gtest.h"
+
+namespace lfc::ros {
+namespace {
+
+/// Little endian CDR writer of a sensor_msgs/JointState, each primitive
+/// being aligned on its size (relative to the end of the encapsulation)
+class JointStateWriter {
+ public:
+  JointStateWriter() : m_bytes{0x00, 0x01, 0x00, 0x00} {}
+
+  auto Int32(std::int32_t v) -> JointStateWriter & { return Raw(&v, 4); }
+  auto UInt32(std::uint32_t v) -> JointStateWriter & { return Raw(&v, 4); }
+
+  auto String(const std::string &s) -> JointStateWriter & {
+    UInt32(static_cast<std::uint32_t>(s.size() + 1));
+    m_bytes.insert(m_bytes.end(), s.begin(), s.end());
+    m_bytes.push_back(0);
+    return *this;
+  }
+
+  auto Strings(const std::vector<std::string> &strings)
+      -> JointStateWriter & {
+    UInt32(static_cast<std::uint32_t>(strings.size()));
+    for (const auto &s : strings) String(s);
+    return *this;
+  }
+
+  auto Doubles(const std::vector<double> &values) -> JointStateWriter & {
+    UInt32(static_cast<std::uint32_t>(values.size()));
+    for (auto v : values) Raw(&v, sizeof(v));
+    return *this;
+  }
+
+  auto Bytes() const -> const std::vector<std::uint8_t> & { return m_bytes; }
+
+ private:
+  auto Raw(const void *v, std::size_t size) -> JointStateWriter & {
+    while (((m_bytes.size() - 4) % size) != 0) m_bytes.push_back(0xAA);
+
+    const auto *bytes = static_cast<const std::uint8_t *>(v);
+    m_bytes.insert(m_bytes.end(), bytes, bytes + size);
+    return *this;
+  }
+
+  std::vector<std::uint8_t> m_bytes;
+};
+
+struct Message {
+  std::string frame_id = "base";
+  std::vector<std::string> names = {"j1", "j2"};
+  std::vector<double> position = {1., 2.};
+  std::vector<double> velocity = {3., 4.};
+  std::vector<double> effort = {};
+};
+
+auto Serialize(const Message &msg) -> std::vector<std::uint8_t> {
+  auto writer = JointStateWriter{};
+  writer.Int32(12).UInt32(34).String(msg.frame_id);
+  writer.Strings(msg.names);
+  writer.Doubles(msg.position).Doubles(msg.velocity).Doubles(msg.effort);
+  return writer.Bytes();
+}
+
+const auto kFields =
+    std::vector<JointStateField>{JointStateField::kPosition,
+                                 JointStateField::kVelocity};
+
+TEST(JointStateCdrTest, Gather) {
+  const auto bytes = Serialize(Message{});
+
+  auto x = Eigen::VectorXd{Eigen::VectorXd::Zero(4)};
+  auto stamp = builtin_interfaces::msg::Time{};
+  auto names = JointNamesLayout{};
+  ASSERT_EQ(GatherSerializedInto(bytes.data(), bytes.size(), kFields, x,
+                                 stamp, names),
+            CdrStatus::kOk);
+
+  EXPECT_EQ(x, (Eigen::VectorXd(4) << 1., 2., 3., 4.).finished());
+  EXPECT_EQ(stamp.sec, 12);
+  EXPECT_EQ(stamp.nanosec, 34u);
+  // 2 x (length, "jX\0"), the second length being aligned
+  EXPECT_EQ(names.bytes, (4u + 3u) + 1u + (4u + 3u));
+
+  // Fields in any order, the effort being empty
+  const auto fields = std::vector<JointStateField>{
+      JointStateField::kEffort, JointStateField::kVelocity};
+  auto v = Eigen::VectorXd{Eigen::VectorXd::Zero(2)};
+  ASSERT_EQ(GatherSerializedInto(bytes.data(), bytes.size(), fields, v,
+                                 stamp, names),
+            CdrStatus::kOk);
+  EXPECT_EQ(v, (Eigen::VectorXd(2) << 3., 4.).finished());
+}
+
+TEST(JointStateCdrTest, SizeMismatch) {
+  const auto bytes = Serialize(Message{});
+
+  auto x = Eigen::VectorXd{Eigen::VectorXd::Constant(3, -1.)};
+  auto stamp = builtin_interfaces::msg::Time{};
+  auto names = JointNamesLayout{};
+  EXPECT_EQ(GatherSerializedInto(bytes.data(), bytes.size(), kFields, x,
+                                 stamp, names),
+            CdrStatus::kSizeMismatch);
+  EXPECT_EQ(x, Eigen::VectorXd::Constant(3, -1.));
+}
+
+TEST(JointStateCdrTest, Truncated) {
+  auto msg = Message{};
+  msg.effort = {5., 6.};
+  const auto bytes = Serialize(msg);
+
+  // Cut within, or right after, each field: stamp, frame_id, names, and
+  // each sequence (count, padding and values)
+  for (std::size_t size = 0; size < bytes.size(); ++size) {
+    auto x = Eigen::VectorXd{Eigen::VectorXd::Constant(4, -1.)};
+    auto stamp = builtin_interfaces::msg::Time{};
+    auto names = JointNamesLayout{};
+    EXPECT_EQ(GatherSerializedInto(bytes.data(), size, kFields, x, stamp,
+                                   names),
+              CdrStatus::kMalformed)
+        << size << " bytes out of " << bytes.size();
+    EXPECT_EQ(x, Eigen::VectorXd::Constant(4, -1.)) << size << " bytes";
+  }
+
+  // Nothing at all
+  auto x = Eigen::VectorXd{Eigen::VectorXd::Zero(4)};
+  auto stamp = builtin_interfaces::msg::Time{};
+  auto names = JointNamesLayout{};
+  EXPECT_EQ(GatherSerializedInto(nullptr, 0, kFields, x, stamp, names),
+            CdrStatus::kMalformed);
+}
+
+TEST(JointStateCdrTest, Oversized) {
+  // A sequence count beyond the buffer (e.g. corrupted), not overflowing
+  auto writer = JointStateWriter{};
+  writer.Int32(0).UInt32(0).String("").Strings({"j1"});
+  writer.UInt32(0x20000000u).Doubles({1.});
+  const auto &bytes = writer.Bytes();
+
+  auto x = Eigen::VectorXd{Eigen::VectorXd::Zero(1)};
+  auto stamp = builtin_interfaces::msg::Time{};
+  auto names = JointNamesLayout{};
+  EXPECT_EQ(GatherSerializedInto(bytes.data(), bytes.size(),
+                                 {JointStateField::kPosition}, x, stamp,
+                                 names),
+            CdrStatus::kMalformed);
+}
+
+TEST(JointStateCdrTest, Encapsulation) {
+  auto bytes = Serialize(Message{});
+
+  auto x = Eigen::VectorXd{Eigen::VectorXd::Zero(4)};
+  auto stamp = builtin_interfaces::msg::Time{};
+  auto names = JointNamesLayout{};
+
+  // Big endian CDR (CDR_BE), then parameter lists (PL_CDR_LE)
+  for (auto kind : {std::uint8_t{0x00}, std::uint8_t{0x03}}) {
+    bytes[1] = kind;
+    EXPECT_EQ(GatherSerializedInto(bytes.data(), bytes.size(), kFields, x,
+                                   stamp, names),
+              CdrStatus::kMalformed)
+        << int{kind};
+  }
+  EXPECT_EQ(x, Eigen::VectorXd::Zero(4));
+}
+
+TEST(JointStateCdrTest, NamesLayout) {
+  const auto layout_of = [](const Message &msg) {
+    const auto bytes = Serialize(msg);
+    auto x = Eigen::VectorXd{Eigen::VectorXd::Zero(4)};
+    auto stamp = builtin_interfaces::msg::Time{};
+    auto names = JointNamesLayout{};
+    EXPECT_EQ(GatherSerializedInto(bytes.data(), bytes.size(), kFields, x,
+                                   stamp, names),
+              CdrStatus::kOk);
+    return names;
+  };
+
+  const auto reference = layout_of(Message{});
+
+  // Independent of everything but the names
+  auto other_values = Message{};
+  other_values.frame_id = "world";
+  other_values.position = {-1., -2.};
+  EXPECT_EQ(layout_of(other_values), reference);
+
+  auto renamed = Message{};
+  renamed.names = {"j1", "j3"};
+  EXPECT_NE(layout_of(renamed), reference);
+  EXPECT_EQ(layout_of(renamed).bytes, reference.bytes);
+
+  auto swapped = Message{};
+  swapped.names = {"j2", "j1"};
+  EXPECT_NE(layout_of(swapped), reference);
+
+  auto longer = Message{};
+  longer.names = {"j1", "j22"};
+  EXPECT_NE(layout_of(longer).bytes, reference.bytes);
+}
+
+TEST(JointStateCdrTest, Padding) {
+  // Each frame_id length shifts the doubles by a different padding (0 to 7
+  // bytes), the empty sequences having none
+  for (std::size_t length = 0; length < 8; ++length) {
+    auto msg = Message{};
+    msg.frame_id = std::string(length, 'f');
+    msg.names = {};
+    msg.position = {};
+    msg.effort = {5., 6.};
+    const auto bytes = Serialize(msg);
+
+    const auto fields = std::vector<JointStateField>{
+        JointStateField::kPosition, JointStateField::kVelocity,
+        JointStateField::kEffort};
+    auto x = Eigen::VectorXd{Eigen::VectorXd::Zero(4)};
+    auto stamp = builtin_interfaces::msg::Time{};
+    auto names = JointNamesLayout{};
+    ASSERT_EQ(GatherSerializedInto(bytes.data(), bytes.size(), fields, x,
+                                   stamp, names),
+              CdrStatus::kOk)
+        << "frame_id of " << length << " chars";
+    EXPECT_EQ(x, (Eigen::VectorXd(4) << 3., 4., 5., 6.).finished())
+        << "frame_id of " << length << " chars";
+  }
+}
+
+} // namespace
+} // namespace lfc::ros
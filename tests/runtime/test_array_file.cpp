@@ -0,0 +1,142 @@
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// lfc
+#include "lfc/runtime/array_file.hpp"
+
+// gtest
+#include "gtest/gtest.h"
+
+namespace lfc {
+namespace {
+
+auto TempPath(const std::string &extension) -> std::string {
+  return "/tmp/lfc-test-array-file-" + std::to_string(::getpid()) +
+         extension;
+}
+
+/// \return The .npy (version 1.0) file of the \a dict header and \a values,
+///         whose header length is \a header_size when not 0
+auto MakeNpy(const std::string &dict, const std::vector<double> &values,
+             std::size_t header_size = 0) -> std::string {
+  // Values are 64 bytes aligned, the header ending with '\n'
+  auto header = dict;
+  while (((10 + header.size() + 1) % 64) != 0) header += ' ';
+  header += '\n';
+  if (header_size == 0) header_size = header.size();
+
+  auto npy = std::string{"\x93NUMPY\x01\x00", 8};
+  npy += static_cast<char>(header_size & 0xff);
+  npy += static_cast<char>((header_size >> 8) & 0xff);
+  npy += header;
+  npy.append(reinterpret_cast<const char *>(values.data()),
+             values.size() * sizeof(double));
+  return npy;
+}
+
+/// \return The ArrayFile mapped from the \a bytes written into \a path
+///         (removed), std::nullopt (with \a reason) on failure
+auto MapBytes(const std::string &path, const std::string &bytes,
+              std::string &reason) -> std::optional<ArrayFile> {
+  std::ofstream{path, std::ios::binary} << bytes;
+  auto array = MapArrayFile(path, reason);
+  std::remove(path.c_str());
+  return array;
+}
+
+const auto kValues = std::vector<double>{1., 2., 3., 4., 5., 6.};
+
+TEST(ArrayFileTest, Npy) {
+  auto reason = std::string{};
+  const auto array = MapBytes(
+      TempPath(".npy"),
+      MakeNpy("{'descr': '<f8', 'fortran_order': False, 'shape': (2, 3), }",
+              kValues),
+      reason);
+  ASSERT_TRUE(array.has_value()) << reason;
+
+  EXPECT_EQ(array->shape, (std::vector<std::size_t>{2, 3}));
+  EXPECT_FALSE(array->fortran_order);
+  ASSERT_EQ(array->size, kValues.size());
+  EXPECT_EQ(std::vector<double>(array->data, array->data + array->size),
+            kValues);
+}
+
+TEST(ArrayFileTest, NpyFortranOrder) {
+  auto reason = std::string{};
+  const auto array = MapBytes(
+      TempPath(".npy"),
+      MakeNpy("{'descr': '<f8', 'fortran_order': True, 'shape': (6,), }",
+              kValues),
+      reason);
+  ASSERT_TRUE(array.has_value()) << reason;
+
+  EXPECT_EQ(array->shape, (std::vector<std::size_t>{6}));
+  EXPECT_TRUE(array->fortran_order);
+  EXPECT_EQ(array->size, kValues.size());
+}
+
+TEST(ArrayFileTest, Raw) {
+  auto reason = std::string{};
+  const auto array = MapBytes(
+      TempPath(".bin"),
+      std::string{reinterpret_cast<const char *>(kValues.data()),
+                  kValues.size() * sizeof(double)},
+      reason);
+  ASSERT_TRUE(array.has_value()) << reason;
+
+  EXPECT_EQ(array->shape, (std::vector<std::size_t>{6}));
+  EXPECT_EQ(std::vector<double>(array->data, array->data + array->size),
+            kValues);
+}
+
+TEST(ArrayFileTest, Failures) {
+  const auto npy = TempPath(".npy");
+  auto reason = std::string{};
+
+  // Wrong dtype
+  EXPECT_FALSE(MapBytes(npy,
+                        MakeNpy("{'descr': '<f4', 'fortran_order': False, "
+                                "'shape': (2, 3), }",
+                                kValues),
+                        reason));
+  EXPECT_NE(reason.find("float64"), std::string::npos) << reason;
+
+  // Truncated header (longer than the file)
+  EXPECT_FALSE(MapBytes(npy,
+                        MakeNpy("{'descr': '<f8', 'fortran_order': False, "
+                                "'shape': (2, 3), }",
+                                {}, /* header_size = */ 1000),
+                        reason));
+  EXPECT_EQ(reason, "truncated .npy header");
+
+  // Shape mismatch
+  EXPECT_FALSE(MapBytes(npy,
+                        MakeNpy("{'descr': '<f8', 'fortran_order': False, "
+                                "'shape': (2, 4), }",
+                                kValues),
+                        reason));
+  EXPECT_NE(reason.find("shape"), std::string::npos) << reason;
+
+  // Malformed header, bad magic string
+  EXPECT_FALSE(MapBytes(npy,
+                        MakeNpy("{'descr': '<f8', 'shape': (2, 3), }",
+                                kValues),
+                        reason));
+  EXPECT_EQ(reason, "malformed .npy header");
+  EXPECT_FALSE(MapBytes(npy, "NUMPY", reason));
+
+  // Not a whole number of float64
+  EXPECT_FALSE(MapBytes(TempPath(".bin"), "1234", reason));
+
+  // No such file
+  EXPECT_FALSE(MapArrayFile(TempPath(".none"), reason));
+}
+
+} // namespace
+} // namespace lfc
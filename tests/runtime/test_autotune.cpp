@@ -0,0 +1,93 @@
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+// lfc
+#include "lfc/runtime/autotune.hpp"
+
+// gtest
+#include "gtest/gtest.h"
+
+namespace lfc {
+namespace {
+
+using namespace std::chrono_literals;
+
+auto TempPath() -> std::string {
+  return "/tmp/lfc-test-autotune-" + std::to_string(::getpid());
+}
+
+TEST(AutotuneTest, CacheRoundTrip) {
+  const auto path = TempPath();
+  std::remove(path.c_str());
+
+  const auto key_2x3 = AutotuneKey(2, 3);
+  const auto key_3x2 = AutotuneKey(3, 2);
+  EXPECT_EQ(ReadCachedKernel(path, key_2x3), std::nullopt); // No such file
+
+  ASSERT_TRUE(WriteCachedKernel(path, key_2x3, GainsKernel::kRowMajor));
+  ASSERT_TRUE(WriteCachedKernel(path, key_3x2, GainsKernel::kSparse));
+  EXPECT_EQ(ReadCachedKernel(path, key_2x3), GainsKernel::kRowMajor);
+  EXPECT_EQ(ReadCachedKernel(path, key_3x2), GainsKernel::kSparse);
+
+  // Replaced, the other entries being kept
+  ASSERT_TRUE(WriteCachedKernel(path, key_2x3, GainsKernel::kColMajor));
+  EXPECT_EQ(ReadCachedKernel(path, key_2x3), GainsKernel::kColMajor);
+  EXPECT_EQ(ReadCachedKernel(path, key_3x2), GainsKernel::kSparse);
+
+  std::remove(path.c_str());
+}
+
+TEST(AutotuneTest, CacheStaleKey) {
+  const auto path = TempPath();
+  ASSERT_TRUE(
+      WriteCachedKernel(path, AutotuneKey(2, 3), GainsKernel::kRowMajor));
+
+  // Another shape, or another CPU
+  EXPECT_EQ(ReadCachedKernel(path, AutotuneKey(2, 4)), std::nullopt);
+  EXPECT_EQ(ReadCachedKernel(path, "2x3\tanother CPU"), std::nullopt);
+  EXPECT_EQ(ReadCachedKernel(path, "2x3"), std::nullopt); // Key prefix
+
+  // A kernel not applicable (anymore) to the gains is timed again
+  ASSERT_TRUE(WriteCachedKernel(path, AutotuneKey(2, 3), GainsKernel::kSparse));
+  const gains_t gains = gains_t::Ones(2, 3);
+  const auto tuning =
+      AutotuneKernel(gains, offset_t::Zero(2), 1ms, /* cache = */ path);
+  EXPECT_FALSE(tuning.cached);
+  EXPECT_FALSE(tuning.timings.empty());
+  EXPECT_EQ(ReadCachedKernel(path, AutotuneKey(2, 3)), tuning.kernel);
+
+  // Read from the cache from now on
+  const auto cached =
+      AutotuneKernel(gains, offset_t::Zero(2), 1ms, /* cache = */ path);
+  EXPECT_TRUE(cached.cached);
+  EXPECT_EQ(cached.kernel, tuning.kernel);
+
+  std::remove(path.c_str());
+}
+
+TEST(AutotuneTest, CacheCorruptFile) {
+  const auto path = TempPath();
+  const auto key = AutotuneKey(2, 3);
+  std::ofstream{path} << "garbage\n\n\t\t\n"
+                      << key << "\tnot_a_kernel\n"
+                      << std::string{"\0\xff\t", 3} << '\n';
+
+  EXPECT_EQ(ReadCachedKernel(path, key), std::nullopt);
+
+  // Repaired by the next write
+  ASSERT_TRUE(WriteCachedKernel(path, key, GainsKernel::kBlocked));
+  EXPECT_EQ(ReadCachedKernel(path, key), GainsKernel::kBlocked);
+
+  // Unwritable
+  EXPECT_FALSE(WriteCachedKernel(path + "/not_a_dir", key,
+                                 GainsKernel::kBlocked));
+
+  std::remove(path.c_str());
+}
+
+} // namespace
+} // namespace lfc
@@ -0,0 +1,271 @@
+#include <string>
+#include <vector>
+
+// lfc
+#include "lfc/runtime/control_step.hpp"
+
+// gtest
+#include "gtest/gtest.h"
+
+namespace lfc {
+namespace {
+
+auto MakeConfig(const std::string &kernel) -> RuntimeConfig {
+  auto config = RuntimeConfig{};
+  config.gains_rows = 2;
+  config.gains_cols = 3;
+  config.gains_values = {1., 2., 3., 4., 5., 6.}; // Row major
+  config.offset_values = {10., 20.};
+  config.kernel = kernel;
+  config.flight_records = 4;
+  config.flight_dump_on_fault = false;
+  return config;
+}
+
+TEST(ControlStepTest, Step) {
+  for (const auto *kernel : {"column_major", "row_major", "auto"}) {
+    auto config = MakeConfig(kernel);
+    config.autotune_budget_ms = 1;
+
+    auto reason = std::string{};
+    auto step = ControlStep::Create(config, reason);
+    ASSERT_NE(step, nullptr) << kernel << ": " << reason;
+    ASSERT_EQ(step->Rows(), 2);
+    ASSERT_EQ(step->Cols(), 3);
+
+    step->State() << 1., 1., 2.;
+    const auto &y = step->Step(/* stamp_ns = */ 0);
+    EXPECT_DOUBLE_EQ(y[0], 10. + 1. + 2. + 6.) << kernel;
+    EXPECT_DOUBLE_EQ(y[1], 20. + 4. + 5. + 12.) << kernel;
+
+    EXPECT_EQ(step->Stats().page->counters.Load().ticks, 1u);
+    ASSERT_NE(step->Recorder(), nullptr);
+    EXPECT_EQ(step->Recorder()->Recorded(), 1u);
+  }
+}
+
+TEST(ControlStepTest, Shard) {
+  auto config = MakeConfig("row_major");
+  config.shard_rows_begin = 1;
+
+  auto reason = std::string{};
+  auto step = ControlStep::Create(config, reason);
+  ASSERT_NE(step, nullptr) << reason;
+  ASSERT_EQ(step->Rows(), 1);
+  ASSERT_EQ(step->Cols(), 3);
+  EXPECT_EQ(step->Kernel(), GainsKernel::kRowMajor);
+  EXPECT_FALSE(step->Tuning().has_value());
+
+  // Second row only
+  step->State() << 1., 1., 2.;
+  EXPECT_DOUBLE_EQ(step->Step(0)[0], 20. + 4. + 5. + 12.);
+}
+
+TEST(ControlStepTest, PostModel) {
+  auto reason = std::string{};
+  auto step = ControlStep::Create(MakeConfig("column_major"), reason);
+  ASSERT_NE(step, nullptr) << reason;
+  step->State() << 1., 1., 1.;
+
+  // Block patch of the gains, then of the offset
+  auto pending = std::vector<ModelPatch>{};
+  pending.push_back(ModelPatch{false, ModelBlock{1, 1, 1, 2},
+                               Eigen::MatrixXd::Constant(1, 2, 0.), 0});
+  pending.push_back(ModelPatch{true, ModelBlock{0, 0, 1, 1},
+                               Eigen::MatrixXd::Constant(1, 1, -6.), 0});
+  step->PostPatches(pending, /* full_update = */ false);
+  EXPECT_EQ(step->Posted().version, 2u);
+
+  // Not fetched yet
+  EXPECT_EQ(step->Current().version, 0u);
+  EXPECT_DOUBLE_EQ(step->Step(0)[0], -6. + 1. + 2. + 3.);
+  EXPECT_EQ(step->Current().version, 2u);
+  EXPECT_DOUBLE_EQ(step->Command()[1], 20. + 4.);
+
+  // Whole gains (the offset is kept)
+  step->PostModel(Eigen::MatrixXd::Ones(2, 3));
+  step->FetchModel();
+  EXPECT_EQ(step->Current().version, 3u);
+  EXPECT_DOUBLE_EQ(step->Step(0)[0], -6. + 3.);
+  EXPECT_DOUBLE_EQ(step->Command()[1], 20. + 3.);
+  EXPECT_EQ(step->Recorder()->Recorded(), 2u);
+}
+
+TEST(ControlStepTest, SolveBatch) {
+  // Sparse enough, and of a fixed shape ([q, v] -> tau), for all the kernels
+  auto gains = gains_t{gains_t::Random(6, 12)};
+  gains.rightCols(6).setZero();
+  const auto offset = offset_t{offset_t::Random(6)};
+  const auto x = Eigen::MatrixXd{Eigen::MatrixXd::Random(12, 4)};
+
+  for (auto kernel : kAllGainsKernels) {
+    if (!Gains::IsApplicable(kernel, gains)) continue;
+
+    auto step = ControlStep{};
+    step.Reset(gains, offset, kernel);
+    step.FetchModel();
+
+    auto y = Eigen::MatrixXd{Eigen::MatrixXd::Zero(6, 4)};
+    step.SolveBatchInto(x, y);
+
+    // Same as solving each state on its own
+    for (Eigen::Index k = 0; k < x.cols(); ++k) {
+      const auto expected = offset_t{offset + (gains * x.col(k))};
+      EXPECT_TRUE(y.col(k).isApprox(expected))
+          << ToString(kernel) << ", state " << k;
+    }
+  }
+}
+
+TEST(ControlStepTest, Trajectory) {
+  // 2 models of a 1x2 model: {1, 2 | 10}, then {3, 4 | 20} (row major)
+  auto config = MakeConfig("column_major");
+  config.gains_rows = 1;
+  config.gains_cols = 2;
+  config.gains_values.clear();
+  config.offset_values.clear();
+  config.trajectory_values = {1., 2., 10., 3., 4., 20.};
+  config.trajectory_period = 1.;
+  config.trajectory_interpolation = "linear";
+
+  auto reason = std::string{};
+  auto step = ControlStep::Create(config, reason);
+  ASSERT_NE(step, nullptr) << reason;
+  ASSERT_NE(step->Trajectory(), nullptr);
+  EXPECT_EQ(step->Trajectory()->Count(), 2u);
+  EXPECT_EQ(step->FetchModel(), 0u);
+
+  // Solved without ever latching the start
+  step->WarmUp(3);
+  EXPECT_DOUBLE_EQ(step->Command()[0], 0.);
+
+  // Starts at the first step (t = 10s), blended in between
+  step->State() << 1., 1.;
+  EXPECT_DOUBLE_EQ(step->Step(10'000'000'000)[0], 10. + 1. + 2.);
+  EXPECT_DOUBLE_EQ(step->Step(10'500'000'000)[0], 20.);
+  EXPECT_DOUBLE_EQ(step->Step(12'000'000'000)[0], 20. + 3. + 4.);
+
+  // Held, from a set start
+  config.trajectory_interpolation = "hold";
+  config.trajectory_start = 1.;
+  step = ControlStep::Create(config, reason);
+  ASSERT_NE(step, nullptr) << reason;
+  step->State() << 1., 0.;
+  EXPECT_DOUBLE_EQ(step->Step(1'000'000'000)[0], 10. + 1.);
+  EXPECT_DOUBLE_EQ(step->Step(1'999'999'999)[0], 10. + 1.);
+  EXPECT_DOUBLE_EQ(step->Step(2'000'000'000)[0], 20. + 3.);
+}
+
+TEST(ControlStepTest, OnChange) {
+  auto config = MakeConfig("column_major");
+  config.on_change = true;
+  config.on_change_epsilon = 0.5;
+  config.on_change_keep_alive = 0.;
+
+  auto reason = std::string{};
+  auto step = ControlStep::Create(config, reason);
+  ASSERT_NE(step, nullptr) << reason;
+  ASSERT_NE(step->OnChange(), nullptr);
+
+  auto x = ControlStep::input_t{ControlStep::input_t::Zero(3)};
+  auto y = ControlStep::output_t{ControlStep::output_t::Zero(2)};
+  auto changes = std::vector<bool>{};
+  for (const auto value : {0., 0.01, 1.}) {
+    x.setConstant(value);
+    step->Step(x, y, ControlStep::Stamps{},
+               [&](bool changed) { changes.push_back(changed); });
+  }
+
+  // First one always published, then only beyond the epsilon
+  EXPECT_EQ(changes, (std::vector<bool>{true, false, true}));
+  EXPECT_EQ(step->OnChange()->Suppressed(), 1u);
+  EXPECT_DOUBLE_EQ(y[0], 10. + 6.);
+  EXPECT_EQ(step->Recorder()->Recorded(), 3u); // Suppressed ones too
+}
+
+TEST(ControlStepTest, StepBatch) {
+  auto config = MakeConfig("column_major");
+  config.batch_streams = 2;
+  config.batch_offsets = {1., 2., 3., 4.};
+
+  auto reason = std::string{};
+  auto step = ControlStep::Create(config, reason);
+  ASSERT_NE(step, nullptr) << reason;
+  ASSERT_EQ(step->BatchState().cols(), 2);
+  step->WarmUp(3);
+  EXPECT_TRUE(step->BatchCommand().isZero());
+
+  // No stream to publish: not even solved
+  auto published = std::vector<std::size_t>{};
+  const auto publish = [&](std::size_t k) { published.push_back(k); };
+  step->BatchState().setOnes();
+  step->StepBatch({nullptr, nullptr}, publish);
+  EXPECT_TRUE(step->BatchCommand().isZero());
+
+  // Both solved, the second one only published and recorded
+  const auto stamps = ControlStep::Stamps{};
+  step->StepBatch({nullptr, &stamps}, publish);
+  EXPECT_EQ(published, (std::vector<std::size_t>{1}));
+  EXPECT_EQ(step->Recorder()->Recorded(), 1u);
+  EXPECT_DOUBLE_EQ(step->BatchCommand()(0, 0), 10. + 6. + 1.);
+  EXPECT_DOUBLE_EQ(step->BatchCommand()(1, 0), 20. + 15. + 2.);
+  EXPECT_DOUBLE_EQ(step->BatchCommand()(0, 1), 10. + 6. + 3.);
+  EXPECT_DOUBLE_EQ(step->BatchCommand()(1, 1), 20. + 15. + 4.);
+}
+
+TEST(ControlStepTest, CreateFailures) {
+  auto shape = MakeConfig("column_major");
+  shape.gains_values.pop_back();
+
+  auto offset = MakeConfig("column_major");
+  offset.offset_values.push_back(30.);
+
+  auto kernel = MakeConfig("unknown");
+
+  auto file = MakeConfig("column_major");
+  file.gains_file = "/nonexistent/gains.npy";
+
+  auto order = MakeConfig("column_major");
+  order.gains_values.clear(); // Checked anyway
+  order.gains_storage_order = "diagonal";
+
+  auto shard = MakeConfig("column_major");
+  shard.shard_rows_begin = 1;
+  shard.shard_rows_end = 3;
+
+  auto empty_shard = MakeConfig("column_major");
+  empty_shard.shard_rows_begin = 1;
+  empty_shard.shard_rows_end = 1;
+
+  auto trajectory = MakeConfig("column_major");
+  trajectory.trajectory_values = {1., 2.}; // Not a whole 2x3 model
+  trajectory.trajectory_period = 1.;
+
+  auto interpolation = MakeConfig("column_major");
+  interpolation.trajectory_values.assign(8, 0.);
+  interpolation.trajectory_period = 1.;
+  interpolation.trajectory_interpolation = "cubic";
+
+  auto shard_trajectory = interpolation;
+  shard_trajectory.trajectory_interpolation = "hold";
+  shard_trajectory.shard_rows_begin = 1;
+
+  auto batch_offsets = MakeConfig("column_major");
+  batch_offsets.batch_streams = 2;
+  batch_offsets.batch_offsets = {1., 2.};
+
+  auto on_change = MakeConfig("column_major");
+  on_change.on_change = true;
+  on_change.batch_streams = 2;
+
+  for (const auto &config :
+       {shape, offset, kernel, file, order, shard, empty_shard, trajectory,
+        interpolation, shard_trajectory, batch_offsets, on_change}) {
+    auto reason = std::string{};
+    EXPECT_EQ(ControlStep::Create(config, reason), nullptr);
+    EXPECT_FALSE(reason.empty());
+  }
+}
+
+} // namespace
+} // namespace lfc
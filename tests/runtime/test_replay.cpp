@@ -0,0 +1,112 @@
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+// lfc
+#include "lfc/runtime/replay.hpp"
+
+// gtest
+#include "gtest/gtest.h"
+
+namespace lfc {
+namespace {
+
+/**
+ *  \return The records of a small dump of a 2x3 model: X = {k, k, k}, Y
+ *          solved by {1, 2, 3; 4, 5, 6} (offset {10, 20}), the record
+ *          \a wrong being off by {0.3, 0.4}, the last one being of the model
+ *          version 2
+ */
+auto MakeDump(std::size_t wrong) -> std::vector<FlightRecord> {
+  constexpr std::size_t kRecords = 5;
+  auto reason = std::string{};
+  auto recorder = FlightRecorder::Create(3, 2, kRecords, reason);
+  EXPECT_TRUE(recorder.has_value()) << reason;
+
+  for (std::size_t k = 0; k < kRecords; ++k) {
+    const auto value = static_cast<double>(k);
+    const auto x = std::vector<double>(3, value);
+    auto y = std::vector<double>{10. + (6. * value), 20. + (15. * value)};
+    if (k == wrong) {
+      y[0] += 0.3;
+      y[1] += 0.4;
+    }
+    const auto version = (k + 1 < kRecords) ? 1u : 2u;
+    recorder->Record(version, static_cast<std::int64_t>(k), 0, x.data(),
+                     y.data());
+  }
+
+  const auto path =
+      "/tmp/lfc-test-replay-" + std::to_string(::getpid()) + ".bin";
+  EXPECT_TRUE(recorder->DumpTo(path.c_str()));
+  auto header = FlightDumpHeader{};
+  auto records = LoadFlightDump(path, header, reason);
+  std::remove(path.c_str());
+  EXPECT_TRUE(records.has_value()) << reason;
+  return records.value_or(std::vector<FlightRecord>{});
+}
+
+auto MakeGains() -> Gains {
+  auto gains = gains_t{2, 3};
+  gains << 1., 2., 3., 4., 5., 6.;
+  return Gains{gains, GainsKernel::kColMajor};
+}
+
+auto MakeOffset() -> offset_t {
+  auto offset = offset_t{2};
+  offset << 10., 20.;
+  return offset;
+}
+
+TEST(ReplayTest, KeepModelVersion) {
+  auto records = MakeDump(/* wrong = */ 10);
+  ASSERT_EQ(records.size(), 5u);
+
+  EXPECT_EQ(KeepModelVersion(records, 1), 1u);
+  ASSERT_EQ(records.size(), 4u);
+  for (const auto &record : records) EXPECT_EQ(record.model_version, 1u);
+}
+
+TEST(ReplayTest, Matches) {
+  auto records = MakeDump(/* wrong = */ 10);
+  KeepModelVersion(records, 1);
+
+  auto stats = ReplayStats{};
+  ReplayFlight(records, 0, records.size(), MakeGains(), MakeOffset(),
+               /* repeat = */ 3, /* tolerance = */ 1e-9, stats);
+
+  EXPECT_EQ(stats.solve.Count(), 3u * 4u);
+  EXPECT_EQ(stats.values, 2u * 4u); // First pass only
+  EXPECT_DOUBLE_EQ(stats.max_diff, 0.);
+  EXPECT_DOUBLE_EQ(stats.RmsDiff(), 0.);
+  EXPECT_EQ(stats.mismatches, 0u);
+}
+
+TEST(ReplayTest, Mismatches) {
+  auto records = MakeDump(/* wrong = */ 2);
+  KeepModelVersion(records, 1);
+
+  // Replayed by 2 segments, merged
+  auto stats = ReplayStats{};
+  for (const auto &[begin, end] :
+       {std::pair<std::size_t, std::size_t>{0, 2}, {2, 4}}) {
+    auto segment = ReplayStats{};
+    ReplayFlight(records, begin, end, MakeGains(), MakeOffset(),
+                 /* repeat = */ 1, /* tolerance = */ 0.35, segment);
+    stats.Merge(segment);
+  }
+
+  // Over the values: not the max |diff| of each record
+  EXPECT_NEAR(stats.max_diff, 0.4, 1e-12);
+  EXPECT_NEAR(stats.RmsDiff(), std::sqrt((0.3 * 0.3 + 0.4 * 0.4) / 8.),
+              1e-12);
+  EXPECT_EQ(stats.mismatches, 1u);
+  EXPECT_EQ(stats.first_mismatch, 3u);
+}
+
+} // namespace
+} // namespace lfc
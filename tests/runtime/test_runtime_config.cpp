@@ -0,0 +1,98 @@
+#include <unistd.h>
+
+#include <string>
+
+// lfc
+#include "lfc/runtime/config.hpp"
+
+// gtest
+#include "gtest/gtest.h"
+
+namespace lfc {
+namespace {
+
+TEST(RuntimeConfigTest, ParseKeys) {
+  auto config = RuntimeConfig{};
+  auto reason = std::string{};
+  ASSERT_TRUE(ParseRuntimeConfig(R"(
+# Model
+gains/shape/rows: 2
+gains/shape/cols: 3
+gains/values: [1, 2, 3,   # First row
+               4, 5, 6]
+gains/storage_order: 'column_major'
+offset/values: [0.5, -1e-3]
+model/kernel: "fixed"
+shard/rows_begin: 1
+trajectory/values: [1, 2]
+trajectory/period: 0.5
+batch/streams: 2
+command/on_change/enabled: true
+
+diagnostics/deadline: 0.001
+diagnostics/perf: true
+flight_recorder/records: 0
+flight_recorder/path: /tmp/lfc # not a comment in quotes: '#'
+)",
+                                 config, reason))
+      << reason;
+
+  EXPECT_EQ(config.gains_rows, 2);
+  EXPECT_EQ(config.gains_cols, 3);
+  EXPECT_EQ(config.gains_values,
+            (std::vector<double>{1., 2., 3., 4., 5., 6.}));
+  EXPECT_EQ(config.gains_storage_order, "column_major");
+  EXPECT_EQ(config.offset_values, (std::vector<double>{0.5, -1e-3}));
+  EXPECT_EQ(config.kernel, "fixed");
+  EXPECT_EQ(config.shard_rows_begin, 1);
+  EXPECT_EQ(config.trajectory_values, (std::vector<double>{1., 2.}));
+  EXPECT_DOUBLE_EQ(config.trajectory_period, 0.5);
+  EXPECT_EQ(config.batch_streams, 2);
+  EXPECT_TRUE(config.on_change);
+  EXPECT_DOUBLE_EQ(config.deadline, 0.001);
+  EXPECT_TRUE(config.perf);
+  EXPECT_EQ(config.flight_records, 0);
+  EXPECT_EQ(config.flight_path, "/tmp/lfc");
+
+  // Unset keys keep their default
+  EXPECT_EQ(config.autotune_budget_ms, 100);
+  EXPECT_EQ(config.shard_rows_end, -1);
+  EXPECT_TRUE(config.flight_dump_on_fault);
+  EXPECT_EQ(config.trajectory_interpolation, "hold");
+  EXPECT_DOUBLE_EQ(config.on_change_keep_alive, 0.1);
+}
+
+TEST(RuntimeConfigTest, FlightPathOf) {
+  auto config = RuntimeConfig{};
+  EXPECT_EQ(FlightPathOf(config),
+            "/tmp/lfc-flight-" + std::to_string(::getpid()) + ".bin");
+
+  config.flight_path = "/tmp/lfc";
+  EXPECT_EQ(FlightPathOf(config), "/tmp/lfc");
+}
+
+TEST(RuntimeConfigTest, ParseFailures) {
+  for (const auto *text : {
+           "gains/unknown: 1",           // Unknown key
+           "gains/shape/rows: two",      // Not an integer
+           "diagnostics/perf: yes",      // Not a boolean
+           "gains/values: [1, 2,]",      // Trailing ','
+           "gains/values: [1, 2",        // Not closed
+           "gains/file: 'gains.npy",     // Not closed
+           "gains/shape/rows",           // No value
+       }) {
+    auto config = RuntimeConfig{};
+    auto reason = std::string{};
+    EXPECT_FALSE(ParseRuntimeConfig(text, config, reason)) << text;
+    EXPECT_EQ(reason.rfind("line 1: ", 0), 0u) << reason;
+  }
+}
+
+TEST(RuntimeConfigTest, LoadMissingFile) {
+  auto reason = std::string{};
+  EXPECT_FALSE(LoadRuntimeConfig("/nonexistent/lfc.yaml", reason).has_value());
+  EXPECT_FALSE(reason.empty());
+}
+
+} // namespace
+} // namespace lfc
@@ -0,0 +1,44 @@
+#include <chrono>
+#include <vector>
+
+// lfc
+#include "lfc/runtime/state_fusion.hpp"
+
+// gtest
+#include "gtest/gtest.h"
+
+namespace lfc {
+namespace {
+
+using namespace std::chrono_literals;
+
+TEST(StateFusionTest, FuseInto) {
+  auto fusion = StateFusion{};
+  const auto imu = fusion.AddSource(/* start = */ 1, /* size = */ 2, 0s);
+  const auto wrench = fusion.AddSource(/* start = */ 3, /* size = */ 1, 10ms);
+  ASSERT_EQ(fusion.Sources(), 2u);
+
+  const auto now = StateFusion::clock::now();
+  auto x = std::vector<double>{-1., 0., 0., 0.};
+
+  // Not received yet
+  EXPECT_FALSE(fusion.FuseInto(x.data(), now, now));
+
+  const auto imu_values = std::vector<double>{1., 2.};
+  const auto wrench_values = std::vector<double>{3.};
+  fusion.Store(imu, imu_values.data(), now - 1s); // Never stale
+  fusion.Store(wrench, wrench_values.data(), now);
+  ASSERT_TRUE(fusion.FuseInto(x.data(), now, now));
+  EXPECT_EQ(x, (std::vector<double>{-1., 1., 2., 3.}));
+
+  // Source older than its max age
+  EXPECT_FALSE(fusion.FuseInto(x.data(), now, now + 20ms));
+
+  // Main input older than its max age
+  fusion.max_age = 5ms;
+  EXPECT_TRUE(fusion.FuseInto(x.data(), now, now + 5ms));
+  EXPECT_FALSE(fusion.FuseInto(x.data(), now - 6ms, now));
+}
+
+} // namespace
+} // namespace lfc
@@ -38,8 +38,9 @@ struct MockAddition {
     return *this;
   }
 
+  // T & (not T): a scalar T (e.g. double) is only assignable as an lvalue
   friend constexpr auto operator+=(T &value, MockAddition &m) -> T & {
-    if constexpr (std::is_assignable_v<T, R>) {
+    if constexpr (std::is_assignable_v<T &, R>) {
       value = m.Addition(value, ArgSide::Left);
     } else {
       m.Addition(value, ArgSide::Left);
@@ -48,7 +49,7 @@ struct MockAddition {
   }
 
   friend constexpr auto operator+=(T &value, const MockAddition &m) -> T & {
-    if constexpr (std::is_assignable_v<T, R>) {
+    if constexpr (std::is_assignable_v<T &, R>) {
       value = m.Addition(value, ArgSide::Left);
     } else {
       m.Addition(value, ArgSide::Left);